@@ -0,0 +1,206 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*                                                                     
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*                                                                     
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <osg/ArgumentParser>
+#include <osg/Timer>
+#include <osgDB/ReadFile>
+#include <osgDB/FileUtils>
+#include <osgCompute/Memory>
+#include <osgCompute/Visitor>
+#include <osgCompute/Runner>
+#include <osgCudaInit/Init>
+#include <osgCudaStats/Metrics>
+#include <cuda_runtime.h>
+
+struct Dump
+{
+    std::string _identifier;
+    std::string _fileName;
+};
+
+//------------------------------------------------------------------------------
+bool dumpResource( osgCompute::ResourceVisitor& rv, const Dump& dump )
+{
+    osgCompute::ResourceSet& resources = rv.getResources();
+    for( osgCompute::ResourceSetItr itr = resources.begin(); itr != resources.end(); ++itr )
+    {
+        osgCompute::Memory* memory = dynamic_cast<osgCompute::Memory*>( (*itr).get() );
+        if( memory == NULL || !memory->isIdentifiedBy( dump._identifier ) )
+            continue;
+
+        // Copy the current device content to the host
+        void* hostPtr = memory->map( osgCompute::MAP_HOST_SOURCE );
+        if( hostPtr == NULL )
+        {
+            osg::notify(osg::WARN)<<"Cannot map resource \""<<dump._identifier<<"\" to the host."<<std::endl;
+            return false;
+        }
+
+        std::ofstream file( dump._fileName.c_str(), std::ios::out | std::ios::binary );
+        if( !file )
+        {
+            osg::notify(osg::WARN)<<"Cannot open file \""<<dump._fileName<<"\"."<<std::endl;
+            return false;
+        }
+
+        file.write( static_cast<const char*>(hostPtr), memory->getByteSize( osgCompute::MAP_HOST ) );
+        std::cout<<"Dumped \""<<dump._identifier<<"\" ("<<memory->getByteSize( osgCompute::MAP_HOST )
+            <<" bytes) to \""<<dump._fileName<<"\"."<<std::endl;
+        return true;
+    }
+
+    osg::notify(osg::WARN)<<"Cannot find memory resource \""<<dump._identifier<<"\"."<<std::endl;
+    return false;
+}
+
+//------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    osg::setNotifyLevel( osg::WARN );
+
+    ///////////////
+    // ARGUMENTS //
+    ///////////////
+    osg::ArgumentParser arguments( &argc, argv );
+    arguments.getApplicationUsage()->setApplicationName( arguments.getApplicationName() );
+    arguments.getApplicationUsage()->setDescription( "Executes the computations of a graph without rendering." );
+    arguments.getApplicationUsage()->setCommandLineUsage( arguments.getApplicationName()+" [options] filename" );
+    arguments.getApplicationUsage()->addCommandLineOption( "--frames <num>", "Number of iterations (default 100)." );
+    arguments.getApplicationUsage()->addCommandLineOption( "--device <id>", "CUDA device (default 0)." );
+    arguments.getApplicationUsage()->addCommandLineOption( "--dump <identifier> <file>", "Write the memory resource to a raw binary file after the last iteration." );
+    arguments.getApplicationUsage()->addCommandLineOption( "--timing", "Report the time of each iteration." );
+    arguments.getApplicationUsage()->addCommandLineOption( "--metrics <file>", "Export memory and timer metrics after each iteration (Prometheus text format)." );
+    arguments.getApplicationUsage()->addCommandLineOption( "--metrics-csv", "Append metrics as CSV instead." );
+    arguments.getApplicationUsage()->addCommandLineOption( "-h or --help", "Display this information." );
+
+    if( arguments.read("-h") || arguments.read("--help") || arguments.argc() < 2 )
+    {
+        arguments.getApplicationUsage()->write( std::cout );
+        return 1;
+    }
+
+    unsigned int numFrames = 100;
+    while( arguments.read( "--frames", numFrames ) ) {}
+
+    int device = 0;
+    while( arguments.read( "--device", device ) ) {}
+
+    bool timing = false;
+    while( arguments.read( "--timing" ) ) { timing = true; }
+
+    std::vector<Dump> dumps;
+    Dump dump;
+    while( arguments.read( "--dump", dump._identifier, dump._fileName ) )
+        dumps.push_back( dump );
+
+    osg::ref_ptr<osgCuda::MetricsExporter> metrics;
+    std::string metricsFile;
+    while( arguments.read( "--metrics", metricsFile ) )
+    {
+        metrics = new osgCuda::MetricsExporter;
+        metrics->setFileName( metricsFile );
+    }
+    while( arguments.read( "--metrics-csv" ) ) 
+    {
+        if( metrics.valid() ) 
+            metrics->setFormat( osgCuda::MetricsExporter::FORMAT_CSV ); 
+    }
+
+    arguments.reportRemainingOptionsAsUnrecognized();
+    if( arguments.errors() )
+    {
+        arguments.writeErrorMessages( std::cout );
+        return 1;
+    }
+
+    ////////////////
+    // SETUP CUDA //
+    ////////////////
+    // No OpenGL context is created. Programs 
+    // are launched in headless mode.
+    if( !osgCuda::setupOsgCudaHeadless( device ) )
+        return 1;
+
+    ////////////////
+    // LOAD GRAPH //
+    ////////////////
+    // Please note that all program libraries 
+    // referenced by the file must be INSTALLED first.
+    osg::ref_ptr<osg::Node> graph = osgDB::readNodeFiles( arguments );
+    if( !graph.valid() )
+    {
+        osg::notify(osg::FATAL)<<arguments.getApplicationName()<<": no graph loaded."<<std::endl;
+        return 1;
+    }
+
+    // Distribute all resources but keep them 
+    // in the visitor for dumping
+    osg::ref_ptr<osgCompute::ResourceVisitor> rv = new osgCompute::ResourceVisitor;
+    rv->setMode( osgCompute::ResourceVisitor::COLLECT | osgCompute::ResourceVisitor::DISTRIBUTE );
+    rv->apply( *graph );
+
+    /////////
+    // RUN //
+    /////////
+    osg::ref_ptr<osgCompute::Runner> runner = new osgCompute::Runner;
+    runner->setSceneData( graph.get() );
+
+    // Metrics are written by a background thread
+    if( metrics.valid() )
+        metrics->start();
+
+    double overallTime = 0.0;
+    double peakTime = 0.0;
+    for( unsigned int f=0; f<numFrames; ++f )
+    {
+        osg::Timer_t startTick = osg::Timer::instance()->tick();
+        runner->frame();
+        // Kernels are launched asynchronously
+        cudaThreadSynchronize();
+        double frameTime = osg::Timer::instance()->delta_m( startTick, osg::Timer::instance()->tick() );
+
+        overallTime += frameTime;
+        if( frameTime > peakTime )
+            peakTime = frameTime;
+
+        if( timing )
+            std::cout<<"Iteration "<<f<<": "<<frameTime<<" ms"<<std::endl;
+
+        if( metrics.valid() )
+            metrics->snapshot( f );
+    }
+
+    if( metrics.valid() )
+        metrics->stop();
+
+    if( numFrames > 0 )
+    {
+        std::cout<<"Iterations: "<<numFrames
+            <<", overall: "<<overallTime<<" ms"
+            <<", average: "<<overallTime/double(numFrames)<<" ms"
+            <<", peak: "<<peakTime<<" ms"<<std::endl;
+    }
+
+    //////////
+    // DUMP //
+    //////////
+    bool success = true;
+    for( std::vector<Dump>::iterator itr = dumps.begin(); itr != dumps.end(); ++itr )
+        success &= dumpResource( *rv, *itr );
+
+    return success ? 0 : 1;
+}
@@ -16,9 +16,10 @@
 #include <osg/Notify>
 #include <osgCuda/Buffer>
 #include <osgCompute/Program>
+#include <osgCompute/LaunchConfig>
 #include <cuda_runtime.h>
 
-extern "C" void swapEndianness( unsigned int numBytes, void* bytes );
+extern "C" void swapEndianness( unsigned int numBytes, void* bytes, const unsigned int* numBlocks, const unsigned int* numThreads );
 
 class SwapProgram : public osgCompute::Program
 {
@@ -28,7 +29,9 @@ public:
         if( !_buffer.valid() )
             return;
 
-        swapEndianness( _buffer->getNumElements(), _buffer->map( osgCompute::MAP_DEVICE_TARGET ) );
+        // Derive the grid from the buffer dimensions
+        osgCompute::LaunchConfig config = osgCompute::LaunchConfig::compute( 128, *_buffer );
+        swapEndianness( _buffer->getNumElements(), _buffer->map( osgCompute::MAP_DEVICE_TARGET ), config._blocks, config._threads );
     }
 
     virtual void acceptResource( osgCompute::Resource& resource )
@@ -48,10 +48,12 @@ inline unsigned int swapBytes( unsigned int value )
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //-------------------------------------------------------------------------
 __global__ 
-void kernelSwapEndianness( unsigned int* bytes ) 
+void kernelSwapEndianness( unsigned int numElements, unsigned int* bytes ) 
 {
     // compute thread dimension
     unsigned int trgIdx = thIdx();
+    if( trgIdx >= numElements )
+        return;
 
     // swap endianess within buffer
     bytes[trgIdx] = swapBytes( bytes[trgIdx] );
@@ -62,13 +64,13 @@ void kernelSwapEndianness( unsigned int* bytes )
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //-------------------------------------------------------------------------
 extern "C"
-void swapEndianness( unsigned int numElements, void* bytes )
+void swapEndianness( unsigned int numElements, void* bytes, const unsigned int* numBlocks, const unsigned int* numThreads )
 {
-    dim3 blocks( numElements, 1, 1 );
-    dim3 threads( 1, 1, 1 );
+    dim3 blocks( numBlocks[0], numBlocks[1], numBlocks[2] );
+    dim3 threads( numThreads[0], numThreads[1], numThreads[2] );
 
     // call kernel
-    kernelSwapEndianness<<< blocks, threads >>>( reinterpret_cast<unsigned int*>(bytes) );
+    kernelSwapEndianness<<< blocks, threads >>>( numElements, reinterpret_cast<unsigned int*>(bytes) );
 }
 
 
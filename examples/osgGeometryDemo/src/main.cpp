@@ -50,13 +50,13 @@ public:
         if( !_vertices.valid() )
             return;
 
+        osgCuda::Geometry* geometry = dynamic_cast<osgCuda::Geometry*>( ((osgCompute::GLMemory*)_vertices.get())->getAdapter() );
+        if( !geometry )
+            return;
+
         if( !_initNormals.valid() || !_initPos.valid() )
         {
             // Create the original reference buffers
-            osgCuda::Geometry* geometry = dynamic_cast<osgCuda::Geometry*>( ((osgCompute::GLMemory*)_vertices.get())->getAdapter() );
-            if( !geometry )
-                return;
-
             _initNormals= new osgCuda::Buffer;
             _initNormals->setName( "NORMALS" );
             _initNormals->setElementSize( geometry->getNormalArray()->getDataSize() * sizeof(float) );
@@ -84,8 +84,10 @@ public:
 
         _simulationTime += 0.01f;
 
+        // Map the vertex positions only. The normals and texture 
+        // coordinates follow as separate arrays in the vertex buffer.
         warp(_vertices->getNumElements(),
-            _vertices->map(),	
+            geometry->mapAttribute( "VERTEX" ),
             _initPos->map(),
             _initNormals->map(),
             _simulationTime );
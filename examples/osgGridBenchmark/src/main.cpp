@@ -0,0 +1,208 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <osg/ArgumentParser>
+#include <osg/Timer>
+#include <osgCuda/Buffer>
+#include <osgCudaInit/Init>
+#include <osgComputeAlgo/HostSpatialGrid>
+#include <osgComputeAlgo/CudaSpatialGrid>
+#include <cuda_runtime.h>
+
+//------------------------------------------------------------------------------
+osg::ref_ptr<osgCuda::Buffer> createBuffer( const std::string& name, unsigned int elementSize, size_t numElements )
+{
+    osg::ref_ptr<osgCuda::Buffer> buffer = new osgCuda::Buffer;
+    buffer->setName( name );
+    buffer->setElementSize( elementSize );
+    buffer->setDimension( 0, static_cast<unsigned int>(numElements) );
+    return buffer;
+}
+
+//------------------------------------------------------------------------------
+void setupGrid( osgCompute::SpatialGrid& grid, float cellSize, unsigned int numCellsPerDim, size_t numParticles )
+{
+    grid.setCellSize( cellSize );
+    for( unsigned int d=0; d<3; ++d )
+        grid.setDimension( d, numCellsPerDim );
+
+    grid.setCellStart( createBuffer( grid.getName() + " cell start", sizeof(unsigned int), grid.getNumCells() ).get() );
+    grid.setCellEnd( createBuffer( grid.getName() + " cell end", sizeof(unsigned int), grid.getNumCells() ).get() );
+    grid.setIndices( createBuffer( grid.getName() + " indices", sizeof(unsigned int), numParticles ).get() );
+}
+
+//------------------------------------------------------------------------------
+double benchmark( osgCompute::SpatialGrid& grid, osgCompute::Memory& positions, unsigned int numFrames )
+{
+    // The first build allocates memory and copies the positions
+    if( !grid.build( positions ) )
+        return -1.0;
+    cudaThreadSynchronize();
+
+    osg::Timer_t startTick = osg::Timer::instance()->tick();
+    for( unsigned int f=0; f<numFrames; ++f )
+        grid.build( positions );
+    // Kernels are launched asynchronously
+    cudaThreadSynchronize();
+
+    return osg::Timer::instance()->delta_m( startTick, osg::Timer::instance()->tick() ) / double(numFrames);
+}
+
+//------------------------------------------------------------------------------
+bool verify( osgCompute::SpatialGrid& hostGrid, osgCompute::SpatialGrid& cudaGrid, size_t numParticles )
+{
+    size_t numCells = hostGrid.getNumCells();
+    const unsigned int* hostStart = static_cast<const unsigned int*>( hostGrid.getCellStart()->map( osgCompute::MAP_HOST_SOURCE ) );
+    const unsigned int* hostEnd = static_cast<const unsigned int*>( hostGrid.getCellEnd()->map( osgCompute::MAP_HOST_SOURCE ) );
+    const unsigned int* hostIndices = static_cast<const unsigned int*>( hostGrid.getIndices()->map( osgCompute::MAP_HOST_SOURCE ) );
+    const unsigned int* cudaStart = static_cast<const unsigned int*>( cudaGrid.getCellStart()->map( osgCompute::MAP_HOST_SOURCE ) );
+    const unsigned int* cudaEnd = static_cast<const unsigned int*>( cudaGrid.getCellEnd()->map( osgCompute::MAP_HOST_SOURCE ) );
+    const unsigned int* cudaIndices = static_cast<const unsigned int*>( cudaGrid.getIndices()->map( osgCompute::MAP_HOST_SOURCE ) );
+    if( !hostStart || !hostEnd || !hostIndices || !cudaStart || !cudaEnd || !cudaIndices )
+        return false;
+
+    if( memcmp( hostStart, cudaStart, numCells * sizeof(unsigned int) ) != 0 ||
+        memcmp( hostEnd, cudaEnd, numCells * sizeof(unsigned int) ) != 0 )
+        return false;
+
+    // The order of the indices within a cell differs
+    std::vector<unsigned int> sorted( cudaIndices, cudaIndices + numParticles );
+    for( size_t c=0; c<numCells; ++c )
+        std::sort( sorted.begin() + cudaStart[c], sorted.begin() + cudaEnd[c] );
+
+    return std::equal( sorted.begin(), sorted.end(), hostIndices );
+}
+
+//------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    osg::setNotifyLevel( osg::WARN );
+
+    ///////////////
+    // ARGUMENTS //
+    ///////////////
+    osg::ArgumentParser arguments( &argc, argv );
+    arguments.getApplicationUsage()->setApplicationName( arguments.getApplicationName() );
+    arguments.getApplicationUsage()->setDescription( "Measures the time to build a spatial grid on the host and on the device." );
+    arguments.getApplicationUsage()->setCommandLineUsage( arguments.getApplicationName()+" [options]" );
+    arguments.getApplicationUsage()->addCommandLineOption( "--particles <num>", "Number of particles. Might be repeated (default 16K, 64K, 256K and 1M)." );
+    arguments.getApplicationUsage()->addCommandLineOption( "--cells <num>", "Number of cells in each dimension of the unit cube (default 64)." );
+    arguments.getApplicationUsage()->addCommandLineOption( "--frames <num>", "Number of builds per measurement (default 20)." );
+    arguments.getApplicationUsage()->addCommandLineOption( "--device <id>", "CUDA device (default 0)." );
+    arguments.getApplicationUsage()->addCommandLineOption( "--verify", "Compare the device grid with the host grid." );
+    arguments.getApplicationUsage()->addCommandLineOption( "-h or --help", "Display this information." );
+
+    if( arguments.read("-h") || arguments.read("--help") )
+    {
+        arguments.getApplicationUsage()->write( std::cout );
+        return 1;
+    }
+
+    std::vector<unsigned int> particleCounts;
+    unsigned int numParticles = 0;
+    while( arguments.read( "--particles", numParticles ) )
+        particleCounts.push_back( numParticles );
+
+    if( particleCounts.empty() )
+    {
+        particleCounts.push_back( 1 << 14 );
+        particleCounts.push_back( 1 << 16 );
+        particleCounts.push_back( 1 << 18 );
+        particleCounts.push_back( 1 << 20 );
+    }
+
+    unsigned int numCellsPerDim = 64;
+    while( arguments.read( "--cells", numCellsPerDim ) ) {}
+
+    unsigned int numFrames = 20;
+    while( arguments.read( "--frames", numFrames ) ) {}
+    if( numFrames == 0 ) 
+        numFrames = 1;
+
+    int device = 0;
+    while( arguments.read( "--device", device ) ) {}
+
+    bool verification = false;
+    while( arguments.read( "--verify" ) ) { verification = true; }
+
+    arguments.reportRemainingOptionsAsUnrecognized();
+    if( arguments.errors() || numCellsPerDim == 0 )
+    {
+        arguments.writeErrorMessages( std::cout );
+        return 1;
+    }
+
+    ////////////////
+    // SETUP CUDA //
+    ////////////////
+    if( !osgCuda::setupOsgCudaHeadless( device ) )
+        return 1;
+
+    ///////////////
+    // BENCHMARK //
+    ///////////////
+    bool success = true;
+    float cellSize = 1.0f / float(numCellsPerDim);
+    for( std::vector<unsigned int>::iterator itr = particleCounts.begin(); itr != particleCounts.end(); ++itr )
+    {
+        numParticles = *itr;
+        if( numParticles == 0 )
+            continue;
+
+        // Particles are distributed uniformly within the unit cube
+        osg::ref_ptr<osgCuda::Buffer> positions = createBuffer( "positions", sizeof(osg::Vec4f), numParticles );
+        osg::Vec4f* pos = static_cast<osg::Vec4f*>( positions->map( osgCompute::MAP_HOST_TARGET ) );
+        for( unsigned int p=0; p<numParticles; ++p )
+            pos[p].set( float(rand()) / float(RAND_MAX), float(rand()) / float(RAND_MAX), float(rand()) / float(RAND_MAX), 1.0f );
+
+        osg::ref_ptr<osgCompute::HostSpatialGrid> hostGrid = new osgCompute::HostSpatialGrid;
+        hostGrid->setName( "host grid" );
+        setupGrid( *hostGrid, cellSize, numCellsPerDim, numParticles );
+
+        osg::ref_ptr<osgCuda::SpatialGrid> cudaGrid = new osgCuda::SpatialGrid;
+        cudaGrid->setName( "cuda grid" );
+        setupGrid( *cudaGrid, cellSize, numCellsPerDim, numParticles );
+
+        double hostTime = benchmark( *hostGrid, *positions, numFrames );
+        double cudaTime = benchmark( *cudaGrid, *positions, numFrames );
+        if( hostTime < 0.0 || cudaTime < 0.0 )
+        {
+            osg::notify(osg::FATAL)<<arguments.getApplicationName()<<": cannot build grid for "<<numParticles<<" particles."<<std::endl;
+            return 1;
+        }
+
+        std::cout<<"Particles: "<<numParticles
+            <<", cells: "<<hostGrid->getNumCells()
+            <<", host: "<<hostTime<<" ms ("<<double(numParticles) / (hostTime * 1000.0)<<" M/s)"
+            <<", device: "<<cudaTime<<" ms ("<<double(numParticles) / (cudaTime * 1000.0)<<" M/s)";
+
+        if( verification )
+        {
+            bool equal = verify( *hostGrid, *cudaGrid, numParticles );
+            std::cout<<(equal ? ", verified" : ", MISMATCH");
+            success &= equal;
+        }
+
+        std::cout<<std::endl;
+    }
+
+    return success ? 0 : 1;
+}
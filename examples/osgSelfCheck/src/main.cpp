@@ -0,0 +1,323 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <utility>
+#include <stdlib.h>
+#include <string.h>
+#include <osg/ArgumentParser>
+#include <osgDB/Registry>
+#include <osgDB/ReaderWriter>
+#include <osgDB/Options>
+#include <osgCompute/MirrorCompressor>
+#include <osgCuda/Buffer>
+#include <osgCuda/Storage>
+#include <osgComputeAlgo/HostPrimitives>
+
+static unsigned int s_numFailed = 0;
+
+//------------------------------------------------------------------------------
+void check( bool condition, const std::string& what )
+{
+    if( !condition )
+        ++s_numFailed;
+
+    std::cout<<(condition ? "passed: " : "FAILED: ")<<what<<std::endl;
+}
+
+//------------------------------------------------------------------------------
+osg::ref_ptr<osgCuda::Buffer> createBuffer( const std::string& name, unsigned int elementSize, size_t numElements )
+{
+    osg::ref_ptr<osgCuda::Buffer> buffer = new osgCuda::Buffer;
+    buffer->setName( name );
+    buffer->setElementSize( elementSize );
+    buffer->setDimension( 0, static_cast<unsigned int>(numElements) );
+    return buffer;
+}
+
+//------------------------------------------------------------------------------
+template<typename T>
+osg::ref_ptr<osgCuda::Buffer> createBuffer( const std::string& name, const std::vector<T>& elements )
+{
+    osg::ref_ptr<osgCuda::Buffer> buffer = createBuffer( name, sizeof(T), elements.size() );
+    T* ptr = static_cast<T*>( buffer->map( osgCompute::MAP_HOST_TARGET ) );
+    if( ptr != NULL )
+        memcpy( ptr, &elements.front(), elements.size() * sizeof(T) );
+
+    return buffer;
+}
+
+//------------------------------------------------------------------------------
+template<typename T>
+bool equals( osgCompute::Memory& memory, const std::vector<T>& elements )
+{
+    const T* ptr = static_cast<const T*>( memory.map( osgCompute::MAP_HOST_SOURCE ) );
+    if( ptr == NULL || memory.getNumElements() != elements.size() )
+        return false;
+
+    return memcmp( ptr, &elements.front(), elements.size() * sizeof(T) ) == 0;
+}
+
+//------------------------------------------------------------------------------
+template<typename T>
+bool lessKey( const std::pair<T,unsigned int>& left, const std::pair<T,unsigned int>& right )
+{
+    return left.first < right.first;
+}
+
+//------------------------------------------------------------------------------
+template<typename T>
+bool greaterKey( const std::pair<T,unsigned int>& left, const std::pair<T,unsigned int>& right )
+{
+    return right.first < left.first;
+}
+
+//------------------------------------------------------------------------------
+template<typename T>
+void checkSort( osgCompute::HostPrimitives& prims, const std::vector<T>& keys, osgCompute::Primitives::DataType type, bool descending, const std::string& what )
+{
+    // Expected order of a stable sort
+    std::vector< std::pair<T,unsigned int> > pairs( keys.size() );
+    for( size_t i=0; i<keys.size(); ++i )
+        pairs[i] = std::make_pair( keys[i], static_cast<unsigned int>(i) );
+    if( descending )
+        std::stable_sort( pairs.begin(), pairs.end(), greaterKey<T> );
+    else
+        std::stable_sort( pairs.begin(), pairs.end(), lessKey<T> );
+
+    std::vector<T> sortedKeys( keys.size() );
+    std::vector<unsigned int> sortedValues( keys.size() );
+    for( size_t i=0; i<pairs.size(); ++i )
+    {
+        sortedKeys[i] = pairs[i].first;
+        sortedValues[i] = pairs[i].second;
+    }
+
+    std::vector<unsigned int> values( keys.size() );
+    for( size_t i=0; i<values.size(); ++i )
+        values[i] = static_cast<unsigned int>(i);
+
+    osg::ref_ptr<osgCuda::Buffer> keyBuffer = createBuffer( "keys", keys );
+    osg::ref_ptr<osgCuda::Buffer> valueBuffer = createBuffer( "values", values );
+    bool sorted = prims.sortByKey( *keyBuffer, valueBuffer.get(), type, 0, descending );
+    check( sorted && equals( *keyBuffer, sortedKeys ) && equals( *valueBuffer, sortedValues ), what );
+}
+
+//------------------------------------------------------------------------------
+void checkCompressor()
+{
+    const size_t sizes[] = { 1, 12, 13, 64, 4096, 100000 };
+    const char* patterns[] = { "zeros", "ramp", "random" };
+
+    for( unsigned int s=0; s<sizeof(sizes)/sizeof(size_t); ++s )
+    {
+        for( unsigned int p=0; p<3; ++p )
+        {
+            std::vector<unsigned char> data( sizes[s] );
+            for( size_t b=0; b<data.size(); ++b )
+                data[b] = (p == 0) ? 0 : (p == 1) ? static_cast<unsigned char>( b % 251 ) : static_cast<unsigned char>( rand() );
+
+            std::vector<unsigned char> packed( osgCompute::MirrorCompressor::compressBound( data.size() ) );
+            size_t packedSize = osgCompute::MirrorCompressor::compress( &data.front(), data.size(), &packed.front(), packed.size() );
+
+            std::vector<unsigned char> unpacked( data.size() + 1 );
+            bool restored = packedSize != 0 &&
+                osgCompute::MirrorCompressor::decompress( &packed.front(), packedSize, &unpacked.front(), data.size() ) &&
+                memcmp( &data.front(), &unpacked.front(), data.size() ) == 0;
+
+            // Data must not be accepted for another size
+            bool rejected = !osgCompute::MirrorCompressor::decompress( &packed.front(), packedSize, &unpacked.front(), data.size() + 1 );
+
+            std::stringstream what;
+            what<<"compressor round trip of "<<data.size()<<" bytes ("<<patterns[p]<<")";
+            check( restored && rejected, what.str() );
+        }
+    }
+
+    // Compressed host memory is restored during the next mapping
+    std::vector<unsigned int> elements( 1 << 16 );
+    for( size_t i=0; i<elements.size(); ++i )
+        elements[i] = static_cast<unsigned int>( i / 16 );
+
+    osg::ref_ptr<osgCuda::Buffer> buffer = createBuffer( "compressed", elements );
+    bool compressed = buffer->compress() &&
+        buffer->getCompressedByteSize() != 0 &&
+        buffer->getCompressedByteSize() < buffer->getAllElementsSize();
+    check( compressed && equals( *buffer, elements ), "buffer compression" );
+}
+
+//------------------------------------------------------------------------------
+void checkPrimitives( unsigned int numThreads )
+{
+    osg::ref_ptr<osgCompute::HostPrimitives> prims = new osgCompute::HostPrimitives;
+    prims->setNumThreads( numThreads );
+
+    std::stringstream threads;
+    threads<<" ("<<prims->getNumThreads()<<" threads)";
+
+    // Sizes are not a multiple of the SIMD width
+    const size_t numElements = 10007;
+    std::vector<unsigned int> input( numElements );
+    for( size_t i=0; i<numElements; ++i )
+        input[i] = static_cast<unsigned int>( rand() % 1000 );
+
+    std::vector<unsigned int> inclusive( numElements );
+    std::vector<unsigned int> exclusive( numElements );
+    unsigned int sum = 0;
+    for( size_t i=0; i<numElements; ++i )
+    {
+        exclusive[i] = sum;
+        sum += input[i];
+        inclusive[i] = sum;
+    }
+
+    osg::ref_ptr<osgCuda::Buffer> inputBuffer = createBuffer( "input", input );
+    osg::ref_ptr<osgCuda::Buffer> outputBuffer = createBuffer( "output", sizeof(unsigned int), numElements );
+    bool scanned = prims->inclusiveScan( *inputBuffer, *outputBuffer, osgCompute::Primitives::TYPE_UINT );
+    check( scanned && equals( *outputBuffer, inclusive ), "inclusive scan" + threads.str() );
+
+    scanned = prims->exclusiveScan( *inputBuffer, *outputBuffer, osgCompute::Primitives::TYPE_UINT );
+    check( scanned && equals( *outputBuffer, exclusive ), "exclusive scan" + threads.str() );
+
+    // Few distinct keys test the stability of the sort
+    std::vector<unsigned int> uintKeys( numElements );
+    std::vector<int> intKeys( numElements );
+    std::vector<float> floatKeys( numElements );
+    for( size_t i=0; i<numElements; ++i )
+    {
+        uintKeys[i] = static_cast<unsigned int>( rand() % 64 ) << 20;
+        intKeys[i] = rand() % 200 - 100;
+        floatKeys[i] = float( rand() % 200 - 100 ) * 0.25f;
+    }
+
+    checkSort( *prims, uintKeys, osgCompute::Primitives::TYPE_UINT, false, "radix sort of unsigned integers" + threads.str() );
+    checkSort( *prims, intKeys, osgCompute::Primitives::TYPE_INT, false, "radix sort of integers" + threads.str() );
+    checkSort( *prims, floatKeys, osgCompute::Primitives::TYPE_FLOAT, false, "radix sort of floats" + threads.str() );
+    checkSort( *prims, floatKeys, osgCompute::Primitives::TYPE_FLOAT, true, "descending radix sort of floats" + threads.str() );
+}
+
+//------------------------------------------------------------------------------
+osg::ref_ptr<osgCuda::Buffer> writeAndRead( osgCuda::Buffer& buffer, const std::string& domain, bool ascii )
+{
+    osgDB::ReaderWriter* rw = osgDB::Registry::instance()->getReaderWriterForExtension( "osgt" );
+    if( rw == NULL )
+        return NULL;
+
+    osg::ref_ptr<osgDB::Options> options = new osgDB::Options( ascii ? "Ascii" : "" );
+    if( !domain.empty() )
+        options->setPluginStringData( "domain", domain );
+
+    std::stringstream stream( std::ios::in | std::ios::out | std::ios::binary );
+    if( !rw->writeObject( buffer, stream, options.get() ).success() )
+        return NULL;
+
+    osgDB::ReaderWriter::ReadResult result = rw->readObject( stream, options.get() );
+    return dynamic_cast<osgCuda::Buffer*>( result.getObject() );
+}
+
+//------------------------------------------------------------------------------
+void checkSerializer()
+{
+    std::vector<float> elements( 1000 );
+    for( size_t i=0; i<elements.size(); ++i )
+        elements[i] = float(rand()) / float(RAND_MAX);
+
+    osg::ref_ptr<osgCuda::Buffer> buffer = createBuffer( "serialized", elements );
+    buffer->setSerializeData( true );
+    buffer->setStorageFormat( osgCuda::STORAGE_HALF );
+
+    for( unsigned int a=0; a<2; ++a )
+    {
+        bool ascii = (a == 0);
+        std::string format = ascii ? " (ascii)" : " (binary)";
+
+        // Files of the current domain version contain all fields
+        osg::ref_ptr<osgCuda::Buffer> current = writeAndRead( *buffer, "osgCuda:2", ascii );
+        check( current.valid() &&
+            current->getSerializeData() &&
+            current->getStorageFormat() == osgCuda::STORAGE_HALF &&
+            equals( *current, elements ), "serializer version 2" + format );
+
+        // Version 1 has been written without the storage format
+        osg::ref_ptr<osgCuda::Buffer> previous = writeAndRead( *buffer, "osgCuda:1", ascii );
+        check( previous.valid() &&
+            previous->getSerializeData() &&
+            previous->getStorageFormat() == osgCuda::STORAGE_NATIVE &&
+            equals( *previous, elements ), "serializer version 1" + format );
+
+        // Files without the domain store neither content nor format
+        osg::ref_ptr<osgCuda::Buffer> initial = writeAndRead( *buffer, "", ascii );
+        check( initial.valid() &&
+            !initial->getSerializeData() &&
+            initial->getStorageFormat() == osgCuda::STORAGE_NATIVE &&
+            initial->getNumElements() == elements.size() &&
+            initial->getAllocatedByteSize( osgCompute::MAP_HOST ) == 0, "serializer without domain" + format );
+    }
+}
+
+//------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+    osg::setNotifyLevel( osg::WARN );
+
+    ///////////////
+    // ARGUMENTS //
+    ///////////////
+    osg::ArgumentParser arguments( &argc, argv );
+    arguments.getApplicationUsage()->setApplicationName( arguments.getApplicationName() );
+    arguments.getApplicationUsage()->setDescription( "Checks the host implementations of the compressor, the primitives and the serializers." );
+    arguments.getApplicationUsage()->setCommandLineUsage( arguments.getApplicationName()+" [options]" );
+    arguments.getApplicationUsage()->addCommandLineOption( "--seed <num>", "Seed of the random numbers (default 1)." );
+    arguments.getApplicationUsage()->addCommandLineOption( "-h or --help", "Display this information." );
+
+    if( arguments.read("-h") || arguments.read("--help") )
+    {
+        arguments.getApplicationUsage()->write( std::cout );
+        return 1;
+    }
+
+    unsigned int seed = 1;
+    while( arguments.read( "--seed", seed ) ) {}
+
+    arguments.reportRemainingOptionsAsUnrecognized();
+    if( arguments.errors() )
+    {
+        arguments.writeErrorMessages( std::cout );
+        return 1;
+    }
+
+    ////////////
+    // CHECKS //
+    ////////////
+    // No device is required. All memory is mapped to the host.
+    srand( seed );
+    checkCompressor();
+    checkPrimitives( 1 );
+    checkPrimitives( 4 );
+    checkPrimitives( 0 );
+    checkSerializer();
+
+    if( s_numFailed != 0 )
+    {
+        std::cout<<s_numFailed<<" checks failed."<<std::endl;
+        return 1;
+    }
+
+    std::cout<<"All checks passed."<<std::endl;
+    return 0;
+}
@@ -137,7 +137,7 @@ osg::ref_ptr<osg::Node> setupScene( unsigned int numParticles, osg::Vec3f bbmin,
 }
 
 //------------------------------------------------------------------------------
-osg::ref_ptr<osgCompute::Computation> setupComputation()
+osg::ref_ptr<osgCompute::Computation> setupComputation( const std::string& libraryPrefix )
 {
     // Execute the computation during the update traversal (default) before the subgraph is handled. 
     osgCompute::Computation::ComputeOrder order = osgCompute::Computation::UPDATE_BEFORECHILDREN;
@@ -145,13 +145,13 @@ osg::ref_ptr<osgCompute::Computation> setupComputation()
     osg::ref_ptr<osgCompute::Computation> computationEmitter = new osgCuda::Computation;
     computationEmitter->setName( "emit particles computation" );
     computationEmitter->setComputeOrder( order );
-    osgCompute::Program* ptclEmitter = osgCompute::Program::loadProgram("osgcuda_ptclemitter");
+    osgCompute::Program* ptclEmitter = osgCompute::Program::loadProgram( libraryPrefix + "ptclemitter" );
     if( ptclEmitter )  computationEmitter->addProgram( *ptclEmitter );
 
     osg::ref_ptr<osgCompute::Computation> computationTracer = new osgCuda::Computation;
     computationTracer->setName( "trace particles computation" );
     computationTracer->setComputeOrder( order );
-    osgCompute::Program* ptclTracer = osgCompute::Program::loadProgram("osgcuda_ptcltracer");
+    osgCompute::Program* ptclTracer = osgCompute::Program::loadProgram( libraryPrefix + "ptcltracer" );
     if( ptclTracer )  computationTracer->addProgram( *ptclTracer );
     computationTracer->addChild( computationEmitter );
 
@@ -163,15 +163,19 @@ osg::ref_ptr<osgCompute::Computation> setupComputation()
 }
 
 //------------------------------------------------------------------------------
-osg::ref_ptr<osgCompute::Computation> loadComputation()
+osg::ref_ptr<osgCompute::Computation> loadComputation( bool host )
 {
     osg::ref_ptr<osgCompute::Computation> computation;
 
-    std::string dataFile = osgDB::findDataFile( "osgTraceDemo/scenes/tracedemo.osgt" );
-    if( !dataFile.empty() )
-        computation = dynamic_cast<osgCompute::Computation*>( osgDB::readNodeFile( dataFile ) );
+    // The scene file references the CUDA programs
+    if( !host )
+    {
+        std::string dataFile = osgDB::findDataFile( "osgTraceDemo/scenes/tracedemo.osgt" );
+        if( !dataFile.empty() )
+            computation = dynamic_cast<osgCompute::Computation*>( osgDB::readNodeFile( dataFile ) );
+    }
 
-    if( !computation.valid() ) computation = setupComputation();
+    if( !computation.valid() ) computation = setupComputation( host? "osghost_" : "osgcuda_" );
     return computation;
 }
 
@@ -180,6 +184,11 @@ int main(int argc, char *argv[])
 {
     osg::setNotifyLevel( osg::WARN );
 
+    // Use "--host" to run the programs "osghost_ptclemitter" and
+    // "osghost_ptcltracer" on the CPU instead of the CUDA programs.
+    osg::ArgumentParser arguments( &argc, argv );
+    bool host = arguments.read( "--host" );
+
     //////////////////
     // SETUP VIEWER //
     //////////////////
@@ -206,7 +215,7 @@ int main(int argc, char *argv[])
     // "osgcuda_ptclemitter" and "osgcuda_ptcltracer" 
     // all packages must be INSTALLED first. 
     osg::ref_ptr<osg::Group> root = new osg::Group;
-    root->addChild( loadComputation() );
+    root->addChild( loadComputation( host ) );
     root->addChild( setupScene(64000, osg::Vec3(-1.f,-1.f,-1.f), osg::Vec3(1.f,1.f,1.f)) );
     viewer.setSceneData( root );
 
@@ -21,6 +21,7 @@
 #include <osg/ref_ptr>
 #include <osgCompute/Program>
 #include <osgCompute/Memory>
+#include <osgCompute/MemoryView>
 #include <osgCuda/Buffer>
 #include <osgCuda/Geometry>
 #include <osgCudaUtil/Timer>
@@ -81,13 +82,16 @@ namespace PtclDemo
 
         _timer->start();
 
-        emit(
-            _ptcls->getNumElements(),
-            _ptcls->map( osgCompute::MAP_DEVICE_TARGET ),
-            _seeds->map( osgCompute::MAP_DEVICE_SOURCE ),
-            (unsigned int)(rand()),
-            osg::Vec3f(-1.f,-1.f,-1.f),
-            osg::Vec3f(1.f,1.f,1.f) );
+        osgCompute::MemoryView<float4,osgCompute::MAP_DEVICE_TARGET> ptcls( *_ptcls );
+        osgCompute::MemoryView<float,osgCompute::MAP_DEVICE_SOURCE> seeds( *_seeds );
+        if( ptcls.valid() && seeds.valid() )
+            emit(
+                static_cast<unsigned int>( ptcls.getNumElements() ),
+                ptcls.get(),
+                const_cast<float*>( seeds.get() ),
+                (unsigned int)(rand()),
+                osg::Vec3f(-1.f,-1.f,-1.f),
+                osg::Vec3f(1.f,1.f,1.f) );
 
         _timer->stop();
     }
@@ -106,3 +110,7 @@ extern "C" OSGCOMPUTE_PROGRAM_EXPORT osgCompute::Program* OSGCOMPUTE_CREATE_PROG
 {
     return new PtclDemo::PtclEmitter;
 }
+
+// Registers the emitter without a library search if the
+// module is linked statically into the application
+OSGCOMPUTE_REGISTER_PROGRAM( osgcuda_ptclemitter, PtclDemo::PtclEmitter )
@@ -0,0 +1,228 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+
+
+#ifndef PTCLHOST_H
+#define PTCLHOST_H 1
+
+#include <OpenThreads/Thread>
+#include <osgCompute/HostWorkers>
+
+// Select the widest instruction set the compiler targets. Enable e.g. 
+// "-mavx" in CMAKE_CXX_FLAGS in order to process 8 particles at once.
+#if defined(__AVX__)
+#   include <immintrin.h>
+#   define PTCLHOST_AVX 1
+#   define PTCLHOST_LANES 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   include <xmmintrin.h>
+#   define PTCLHOST_SSE 1
+#   define PTCLHOST_LANES 4
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#   include <arm_neon.h>
+#   define PTCLHOST_NEON 1
+#   define PTCLHOST_LANES 4
+#else
+#   define PTCLHOST_LANES 1
+#endif
+
+namespace PtclDemo
+{
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // LANE FUNCTIONS ////////////////////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Kernels are written once as templates for the vector type. The
+    // float versions process the remaining particles of each range.
+    inline float add( float a, float b ) { return a + b; }
+    inline float sub( float a, float b ) { return a - b; }
+    inline float mul( float a, float b ) { return a * b; }
+    inline float div( float a, float b ) { return a / b; }
+    inline void splat( float& v, float s ) { v = s; }
+
+#if defined(PTCLHOST_AVX)
+    inline __m256 add( __m256 a, __m256 b ) { return _mm256_add_ps( a, b ); }
+    inline __m256 sub( __m256 a, __m256 b ) { return _mm256_sub_ps( a, b ); }
+    inline __m256 mul( __m256 a, __m256 b ) { return _mm256_mul_ps( a, b ); }
+    inline __m256 div( __m256 a, __m256 b ) { return _mm256_div_ps( a, b ); }
+    inline void splat( __m256& v, float s ) { v = _mm256_set1_ps( s ); }
+
+    //------------------------------------------------------------------------------
+    // Transposes 4x4 blocks within both 128-bit halves. Converts two 
+    // float4 particles per register into x,y,z,w lanes and back.
+    inline void transpose( __m256& r0, __m256& r1, __m256& r2, __m256& r3 )
+    {
+        __m256 t0 = _mm256_unpacklo_ps( r0, r1 );
+        __m256 t1 = _mm256_unpackhi_ps( r0, r1 );
+        __m256 t2 = _mm256_unpacklo_ps( r2, r3 );
+        __m256 t3 = _mm256_unpackhi_ps( r2, r3 );
+        r0 = _mm256_shuffle_ps( t0, t2, _MM_SHUFFLE(1,0,1,0) );
+        r1 = _mm256_shuffle_ps( t0, t2, _MM_SHUFFLE(3,2,3,2) );
+        r2 = _mm256_shuffle_ps( t1, t3, _MM_SHUFFLE(1,0,1,0) );
+        r3 = _mm256_shuffle_ps( t1, t3, _MM_SHUFFLE(3,2,3,2) );
+    }
+#elif defined(PTCLHOST_SSE)
+    inline __m128 add( __m128 a, __m128 b ) { return _mm_add_ps( a, b ); }
+    inline __m128 sub( __m128 a, __m128 b ) { return _mm_sub_ps( a, b ); }
+    inline __m128 mul( __m128 a, __m128 b ) { return _mm_mul_ps( a, b ); }
+    inline __m128 div( __m128 a, __m128 b ) { return _mm_div_ps( a, b ); }
+    inline void splat( __m128& v, float s ) { v = _mm_set1_ps( s ); }
+#elif defined(PTCLHOST_NEON)
+    inline float32x4_t add( float32x4_t a, float32x4_t b ) { return vaddq_f32( a, b ); }
+    inline float32x4_t sub( float32x4_t a, float32x4_t b ) { return vsubq_f32( a, b ); }
+    inline float32x4_t mul( float32x4_t a, float32x4_t b ) { return vmulq_f32( a, b ); }
+    inline float32x4_t div( float32x4_t a, float32x4_t b ) 
+    { 
+#   if defined(__aarch64__)
+        return vdivq_f32( a, b ); 
+#   else
+        // Reciprocal estimate refined by two Newton-Raphson steps
+        float32x4_t r = vrecpeq_f32( b );
+        r = vmulq_f32( vrecpsq_f32( b, r ), r );
+        r = vmulq_f32( vrecpsq_f32( b, r ), r );
+        return vmulq_f32( a, r );
+#   endif
+    }
+    inline void splat( float32x4_t& v, float s ) { v = vdupq_n_f32( s ); }
+#endif
+
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // PARTICLE ACCESS ///////////////////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // Particles are stored as float4 (x,y,z,w) as OpenGL expects it. 
+    // load() reads PTCLHOST_LANES particles and transposes them into
+    // one register per component. store() writes them back.
+#if defined(PTCLHOST_AVX)
+    typedef __m256 Lane;
+
+    //------------------------------------------------------------------------------
+    inline void load( const float* ptcls, Lane& x, Lane& y, Lane& z, Lane& w )
+    {
+        x = _mm256_loadu_ps( &ptcls[0] );
+        y = _mm256_loadu_ps( &ptcls[8] );
+        z = _mm256_loadu_ps( &ptcls[16] );
+        w = _mm256_loadu_ps( &ptcls[24] );
+        transpose( x, y, z, w );
+    }
+
+    //------------------------------------------------------------------------------
+    inline void store( float* ptcls, Lane x, Lane y, Lane z, Lane w )
+    {
+        transpose( x, y, z, w );
+        _mm256_storeu_ps( &ptcls[0], x );
+        _mm256_storeu_ps( &ptcls[8], y );
+        _mm256_storeu_ps( &ptcls[16], z );
+        _mm256_storeu_ps( &ptcls[24], w );
+    }
+
+    //------------------------------------------------------------------------------
+    // The in-lane transpose holds particles 0,2,4,6 in the lower 
+    // and particles 1,3,5,7 in the upper half of a register.
+    inline unsigned int lanePtcl( unsigned int lane ) { return (lane < 4)? 2*lane : 2*(lane-4)+1; }
+#elif defined(PTCLHOST_SSE)
+    typedef __m128 Lane;
+
+    //------------------------------------------------------------------------------
+    inline void load( const float* ptcls, Lane& x, Lane& y, Lane& z, Lane& w )
+    {
+        x = _mm_loadu_ps( &ptcls[0] );
+        y = _mm_loadu_ps( &ptcls[4] );
+        z = _mm_loadu_ps( &ptcls[8] );
+        w = _mm_loadu_ps( &ptcls[12] );
+        _MM_TRANSPOSE4_PS( x, y, z, w );
+    }
+
+    //------------------------------------------------------------------------------
+    inline void store( float* ptcls, Lane x, Lane y, Lane z, Lane w )
+    {
+        _MM_TRANSPOSE4_PS( x, y, z, w );
+        _mm_storeu_ps( &ptcls[0], x );
+        _mm_storeu_ps( &ptcls[4], y );
+        _mm_storeu_ps( &ptcls[8], z );
+        _mm_storeu_ps( &ptcls[12], w );
+    }
+
+    //------------------------------------------------------------------------------
+    inline unsigned int lanePtcl( unsigned int lane ) { return lane; }
+#elif defined(PTCLHOST_NEON)
+    typedef float32x4_t Lane;
+
+    //------------------------------------------------------------------------------
+    inline void load( const float* ptcls, Lane& x, Lane& y, Lane& z, Lane& w )
+    {
+        float32x4x4_t v = vld4q_f32( ptcls );
+        x = v.val[0]; y = v.val[1]; z = v.val[2]; w = v.val[3];
+    }
+
+    //------------------------------------------------------------------------------
+    inline void store( float* ptcls, Lane x, Lane y, Lane z, Lane w )
+    {
+        float32x4x4_t v;
+        v.val[0] = x; v.val[1] = y; v.val[2] = z; v.val[3] = w;
+        vst4q_f32( ptcls, v );
+    }
+
+    //------------------------------------------------------------------------------
+    inline unsigned int lanePtcl( unsigned int lane ) { return lane; }
+#else
+    typedef float Lane;
+
+    //------------------------------------------------------------------------------
+    inline void load( const float* ptcls, Lane& x, Lane& y, Lane& z, Lane& w )
+    {
+        x = ptcls[0]; y = ptcls[1]; z = ptcls[2]; w = ptcls[3];
+    }
+
+    //------------------------------------------------------------------------------
+    inline void store( float* ptcls, Lane x, Lane y, Lane z, Lane w )
+    {
+        ptcls[0] = x; ptcls[1] = y; ptcls[2] = z; ptcls[3] = w;
+    }
+
+    //------------------------------------------------------------------------------
+    inline unsigned int lanePtcl( unsigned int lane ) { return lane; }
+#endif
+
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // WORKERS ///////////////////////////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    //! Work on a range of particles
+    /**
+    Splits the particles into one range per thread of the 
+    osgCompute::HostWorkers. The calling thread processes the first 
+    range itself. Ranges are multiples of PTCLHOST_LANES so only the 
+    last range has a remainder.
+    */
+    class PtclJob : public osgCompute::HostJob
+    {
+    public:
+        PtclJob( unsigned int numPtcls ) : _numPtcls( numPtcls ) {}
+
+        //------------------------------------------------------------------------------
+        virtual void execute( unsigned int thread, unsigned int numThreads )
+        {
+            size_t begin, end;
+            osgCompute::HostWorkers::getRange( _numPtcls, PTCLHOST_LANES, thread, numThreads, begin, end );
+            if( begin < end )
+                process( static_cast<unsigned int>(begin), static_cast<unsigned int>(end) );
+        }
+
+        virtual void process( unsigned int begin, unsigned int end ) = 0;
+
+    protected:
+        unsigned int    _numPtcls;
+    };
+}
+
+#endif // PTCLHOST_H
@@ -0,0 +1,213 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+
+
+#include <vector>
+#include <cstdlib>
+#include <osg/Notify>
+#include <osg/Vec4f>
+#include <osg/Vec3f>
+#include <osgCompute/Program>
+#include <osgCompute/Memory>
+#include <osgCompute/MemoryView>
+#include "PtclHost.h"
+
+namespace PtclDemo
+{
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // LANE FUNCTIONS ////////////////////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    // Returns a bit for each lane with a particle outside of the bounding box
+    inline unsigned int outsideMask( float x, float y, float z, const osg::Vec3f& bbmin, const osg::Vec3f& bbmax )
+    {
+        return ( x < bbmin.x() || y < bbmin.y() || z < bbmin.z() ||
+                 x > bbmax.x() || y > bbmax.y() || z > bbmax.z() )? 1 : 0;
+    }
+
+#if defined(PTCLHOST_AVX)
+    inline unsigned int outsideMask( Lane x, Lane y, Lane z, const osg::Vec3f& bbmin, const osg::Vec3f& bbmax )
+    {
+        Lane outside = _mm256_or_ps(
+            _mm256_or_ps( _mm256_cmp_ps( x, _mm256_set1_ps(bbmin.x()), _CMP_LT_OQ ), _mm256_cmp_ps( x, _mm256_set1_ps(bbmax.x()), _CMP_GT_OQ ) ),
+            _mm256_or_ps( _mm256_cmp_ps( y, _mm256_set1_ps(bbmin.y()), _CMP_LT_OQ ), _mm256_cmp_ps( y, _mm256_set1_ps(bbmax.y()), _CMP_GT_OQ ) ) );
+        outside = _mm256_or_ps( outside, 
+            _mm256_or_ps( _mm256_cmp_ps( z, _mm256_set1_ps(bbmin.z()), _CMP_LT_OQ ), _mm256_cmp_ps( z, _mm256_set1_ps(bbmax.z()), _CMP_GT_OQ ) ) );
+        return static_cast<unsigned int>( _mm256_movemask_ps( outside ) );
+    }
+#elif defined(PTCLHOST_SSE)
+    inline unsigned int outsideMask( Lane x, Lane y, Lane z, const osg::Vec3f& bbmin, const osg::Vec3f& bbmax )
+    {
+        Lane outside = _mm_or_ps(
+            _mm_or_ps( _mm_cmplt_ps( x, _mm_set1_ps(bbmin.x()) ), _mm_cmpgt_ps( x, _mm_set1_ps(bbmax.x()) ) ),
+            _mm_or_ps( _mm_cmplt_ps( y, _mm_set1_ps(bbmin.y()) ), _mm_cmpgt_ps( y, _mm_set1_ps(bbmax.y()) ) ) );
+        outside = _mm_or_ps( outside, 
+            _mm_or_ps( _mm_cmplt_ps( z, _mm_set1_ps(bbmin.z()) ), _mm_cmpgt_ps( z, _mm_set1_ps(bbmax.z()) ) ) );
+        return static_cast<unsigned int>( _mm_movemask_ps( outside ) );
+    }
+#elif defined(PTCLHOST_NEON)
+    inline unsigned int outsideMask( Lane x, Lane y, Lane z, const osg::Vec3f& bbmin, const osg::Vec3f& bbmax )
+    {
+        uint32x4_t outside = vorrq_u32(
+            vorrq_u32( vcltq_f32( x, vdupq_n_f32(bbmin.x()) ), vcgtq_f32( x, vdupq_n_f32(bbmax.x()) ) ),
+            vorrq_u32( vcltq_f32( y, vdupq_n_f32(bbmin.y()) ), vcgtq_f32( y, vdupq_n_f32(bbmax.y()) ) ) );
+        outside = vorrq_u32( outside, 
+            vorrq_u32( vcltq_f32( z, vdupq_n_f32(bbmin.z()) ), vcgtq_f32( z, vdupq_n_f32(bbmax.z()) ) ) );
+        return (vgetq_lane_u32( outside, 0 ) & 1) | 
+               (vgetq_lane_u32( outside, 1 ) & 2) | 
+               (vgetq_lane_u32( outside, 2 ) & 4) | 
+               (vgetq_lane_u32( outside, 3 ) & 8);
+    }
+#endif
+
+    //------------------------------------------------------------------------------
+    inline float lerp( float a, float b, float t )
+    {
+        return a + t*(b-a);
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // JOBS //////////////////////////////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    class EmitJob : public PtclJob
+    {
+    public:
+        EmitJob( float* ptcls, unsigned int numPtcls, const float* seeds, unsigned int seedIdx, const osg::Vec3f& bbmin, const osg::Vec3f& bbmax ) 
+            : PtclJob( numPtcls ), _ptcls( ptcls ), _seeds( seeds ), _seedIdx( seedIdx ), _bbmin( bbmin ), _bbmax( bbmax ) {}
+
+        //------------------------------------------------------------------------------
+        virtual void process( unsigned int begin, unsigned int end )
+        {
+            // Particles are rarely outside of the box. So test the whole
+            // block at once and reseed the few particles separately.
+            unsigned int ptclIdx = begin;
+            for( ; ptclIdx + PTCLHOST_LANES <= end; ptclIdx += PTCLHOST_LANES )
+            {
+                Lane x, y, z, w;
+                load( &_ptcls[4*ptclIdx], x, y, z, w );
+
+                unsigned int mask = outsideMask( x, y, z, _bbmin, _bbmax );
+                for( unsigned int lane = 0; mask != 0; ++lane, mask >>= 1 )
+                    if( mask & 1 )
+                        reseed( ptclIdx + lanePtcl(lane) );
+            }
+
+            // Remaining particles of the last range
+            for( ; ptclIdx < end; ++ptclIdx )
+            {
+                const float* ptcl = &_ptcls[4*ptclIdx];
+                if( outsideMask( ptcl[0], ptcl[1], ptcl[2], _bbmin, _bbmax ) )
+                    reseed( ptclIdx );
+            }
+        }
+
+    private:
+        //------------------------------------------------------------------------------
+        void reseed( unsigned int ptclIdx )
+        {
+            // random seed idx
+            unsigned int idx1 = (_seedIdx + ptclIdx) % _numPtcls;
+            unsigned int idx2 = (idx1 + ptclIdx) % _numPtcls;
+            unsigned int idx3 = (idx2 + ptclIdx) % _numPtcls;
+
+            // seeds are within the range [0,1]
+            float* ptcl = &_ptcls[4*ptclIdx];
+            ptcl[0] = lerp( _bbmin.x(), _bbmax.x(), _seeds[idx1] );
+            ptcl[1] = lerp( _bbmin.y(), _bbmax.y(), _seeds[idx3] );
+            ptcl[2] = lerp( _bbmin.z(), _bbmax.z(), _seeds[idx2] );
+            ptcl[3] = 1.0f;
+        }
+
+        float*          _ptcls;
+        const float*    _seeds;
+        unsigned int    _seedIdx;
+        osg::Vec3f      _bbmin;
+        osg::Vec3f      _bbmax;
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // PROGRAM ///////////////////////////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    //! Host version of the particle emitter
+    /**
+    Reseeds particles which have left the bounding box. Boundaries are
+    tested with SIMD instructions on one thread per processor.
+    */
+    class PtclHostEmitter : public osgCompute::Program 
+    {
+    public:
+        PtclHostEmitter() : osgCompute::Program() {}
+
+        virtual void launch();
+        virtual void acceptResource( osgCompute::Resource& resource );
+
+    protected:
+        virtual ~PtclHostEmitter() {}
+
+    private:
+        osg::ref_ptr<osgCompute::Memory>    _ptcls;
+        std::vector<float>                  _seeds;
+    };
+
+    //------------------------------------------------------------------------------
+    void PtclHostEmitter::launch()
+    {
+        if( !_ptcls.valid() )
+            return;
+
+        unsigned int numPtcls = static_cast<unsigned int>( _ptcls->getNumElements() );
+        if( numPtcls == 0 )
+            return;
+
+        if( _seeds.size() != numPtcls )
+        {
+            _seeds.resize( numPtcls );
+            for( unsigned int s=0; s<numPtcls; ++s )
+                _seeds[s] = ( float(rand()) / RAND_MAX );
+        }
+
+        // Particles are stored as float4
+        osgCompute::MemoryView<osg::Vec4f,osgCompute::MAP_HOST_TARGET> ptcls( *_ptcls );
+        if( !ptcls.valid() )
+            return;
+
+        EmitJob job( 
+            ptcls.get()->ptr(), 
+            numPtcls, 
+            &_seeds.front(), 
+            (unsigned int)(rand()), 
+            osg::Vec3f(-1.f,-1.f,-1.f), 
+            osg::Vec3f(1.f,1.f,1.f) );
+        osgCompute::HostWorkers::instance()->run( job );
+    }
+
+    //------------------------------------------------------------------------------
+    void PtclHostEmitter::acceptResource( osgCompute::Resource& resource )
+    {
+        if( resource.isIdentifiedBy("PTCL_BUFFER") )
+            _ptcls = dynamic_cast<osgCompute::Memory*>( &resource );
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Use this function to return a new emitter module to the application
+extern "C" OSGCOMPUTE_PROGRAM_EXPORT osgCompute::Program* OSGCOMPUTE_CREATE_PROGRAM_FUNCTION( void ) 
+{
+    return new PtclDemo::PtclHostEmitter;
+}
+
+// Registers the emitter without a library search if the
+// module is linked statically into the application
+OSGCOMPUTE_REGISTER_PROGRAM( osghost_ptclemitter, PtclDemo::PtclHostEmitter )
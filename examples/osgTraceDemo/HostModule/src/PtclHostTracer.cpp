@@ -0,0 +1,160 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+
+
+#include <osg/Notify>
+#include <osg/Vec4f>
+#include <osgCompute/Program>
+#include <osgCompute/Memory>
+#include <osgCompute/MemoryView>
+#include "PtclHost.h"
+
+#define GAM 0.003f
+#define VEL_STRENGTH  10.0f 
+#define PTCLHOST_PI 3.141592654f
+
+namespace PtclDemo
+{
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // LANE FUNCTIONS ////////////////////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    // A simple vortex field of strength GAM around straight line (0,0,z)
+    template<typename V>
+    inline void vortexField( V x, V z, V& velx, V& velz )
+    {
+        V strength, negStrength;
+        splat( strength, PTCLHOST_PI * GAM * VEL_STRENGTH );
+        splat( negStrength, -PTCLHOST_PI * GAM * VEL_STRENGTH );
+
+        V sqrad = add( mul(x,x), mul(z,z) );
+        velx = div( mul(negStrength,z), sqrad );
+        velz = div( mul(strength,x), sqrad );
+    }
+
+    //------------------------------------------------------------------------------
+    // 4th order Runge-Kutta. The field has no y component so
+    // only x and z of the particles change.
+    template<typename V>
+    inline void advance( V& x, V& z, float etime )
+    {
+        V halfETime, fullETime, sixthETime, two;
+        splat( halfETime, etime * 0.5f );
+        splat( fullETime, etime );
+        splat( sixthETime, etime * (1.0f/6.0f) );
+        splat( two, 2.0f );
+
+        V k0x, k0z, k1x, k1z, k2x, k2z, k3x, k3z;
+        vortexField( x, z, k0x, k0z );
+        vortexField( add(x, mul(halfETime,k0x)), add(z, mul(halfETime,k0z)), k1x, k1z );
+        vortexField( add(x, mul(halfETime,k1x)), add(z, mul(halfETime,k1z)), k2x, k2z );
+        vortexField( add(x, mul(fullETime,k2x)), add(z, mul(fullETime,k2z)), k3x, k3z );
+
+        x = add( x, mul( sixthETime, add( add(k0x, mul(two,k1x)), add(mul(two,k2x), k3x) ) ) );
+        z = add( z, mul( sixthETime, add( add(k0z, mul(two,k1z)), add(mul(two,k2z), k3z) ) ) );
+    }
+
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // JOBS //////////////////////////////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    class TraceJob : public PtclJob
+    {
+    public:
+        TraceJob( float* ptcls, unsigned int numPtcls, float etime ) : PtclJob( numPtcls ), _ptcls( ptcls ), _etime( etime ) {}
+
+        //------------------------------------------------------------------------------
+        virtual void process( unsigned int begin, unsigned int end )
+        {
+            unsigned int ptclIdx = begin;
+            for( ; ptclIdx + PTCLHOST_LANES <= end; ptclIdx += PTCLHOST_LANES )
+            {
+                Lane x, y, z, w;
+                load( &_ptcls[4*ptclIdx], x, y, z, w );
+                advance( x, z, _etime );
+                splat( w, 1.0f );
+                store( &_ptcls[4*ptclIdx], x, y, z, w );
+            }
+
+            // Remaining particles of the last range
+            for( ; ptclIdx < end; ++ptclIdx )
+            {
+                float* ptcl = &_ptcls[4*ptclIdx];
+                advance( ptcl[0], ptcl[2], _etime );
+                ptcl[3] = 1.0f;
+            }
+        }
+
+    private:
+        float*  _ptcls;
+        float   _etime;
+    };
+
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    // PROGRAM ///////////////////////////////////////////////////////////////////////////////////////////////////
+    //////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    //! Host version of the particle tracer
+    /**
+    Traces the particles on the host with SIMD instructions. The 
+    particle ranges are distributed to one thread per processor.
+    */
+    class PtclHostTracer : public osgCompute::Program 
+    {
+    public:
+        PtclHostTracer() : osgCompute::Program() {}
+
+        virtual void launch();
+        virtual void acceptResource( osgCompute::Resource& resource );
+
+    protected:
+        virtual ~PtclHostTracer() {}
+
+    private:
+        osg::ref_ptr<osgCompute::Memory>    _ptcls;
+    };
+
+    //------------------------------------------------------------------------------  
+    void PtclHostTracer::launch()
+    {
+        if( !_ptcls.valid() )
+            return;
+
+        // Particles are stored as float4
+        osgCompute::MemoryView<osg::Vec4f,osgCompute::MAP_HOST_TARGET> ptcls( *_ptcls );
+        if( !ptcls.valid() )
+            return;
+
+        TraceJob job( ptcls.get()->ptr(), static_cast<unsigned int>( ptcls.getNumElements() ), 0.009f );
+        osgCompute::HostWorkers::instance()->run( job );
+    }
+
+    //------------------------------------------------------------------------------
+    void PtclHostTracer::acceptResource( osgCompute::Resource& resource )
+    {
+        // Search for the particle buffer
+        if( resource.isIdentifiedBy("PTCL_BUFFER") )
+            _ptcls = dynamic_cast<osgCompute::Memory*>( &resource );
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Use this function to return a new tracer module to the application
+extern "C" OSGCOMPUTE_PROGRAM_EXPORT osgCompute::Program* OSGCOMPUTE_CREATE_PROGRAM_FUNCTION() 
+{
+    return new PtclDemo::PtclHostTracer;
+}
+
+// Registers the tracer without a library search if the
+// module is linked statically into the application
+OSGCOMPUTE_REGISTER_PROGRAM( osghost_ptcltracer, PtclDemo::PtclHostTracer )
@@ -20,14 +20,40 @@
 #include <osg/FrameStamp>
 #include <osgCompute/Program>
 #include <osgCompute/Memory>
+#include <osgCompute/MemoryView>
+#include <osgCompute/LaunchConfig>
+#include <cuda_runtime.h>
 #include <osgCudaUtil/Timer>
 
 //------------------------------------------------------------------------------
 extern "C"
-void trace( unsigned int numPtcls, void* ptcls, float etime );
+void trace( unsigned int numPtcls, void* ptcls, float etime, const unsigned int* numBlocks, const unsigned int* numThreads );
 
 namespace PtclDemo
 {
+    //------------------------------------------------------------------------------
+    class TraceLaunch : public osgCompute::LaunchFunction
+    {
+    public:
+        TraceLaunch( unsigned int numPtcls, void* ptcls, float etime ) 
+            : _numPtcls( numPtcls ), _ptcls( ptcls ), _etime( etime ) {}
+
+        virtual void launch( const osgCompute::LaunchConfig& config )
+        {
+            trace( _numPtcls, _ptcls, _etime, config._blocks, config._threads );
+        }
+
+        virtual void finish() 
+        { 
+            cudaThreadSynchronize(); 
+        }
+
+    private:
+        unsigned int    _numPtcls;
+        void*           _ptcls;
+        float           _etime;
+    };
+
     class PtclTracer : public osgCompute::Program 
     {
     public:
@@ -53,10 +79,13 @@ namespace PtclDemo
 
         _timer->start();
 
-        trace( 
-            _ptcls->getNumElements(), 
-            _ptcls->map( osgCompute::MAP_DEVICE_TARGET ), 
-            0.009f );
+        osgCompute::MemoryView<float4,osgCompute::MAP_DEVICE_TARGET> ptcls( *_ptcls );
+        if( ptcls.valid() )
+        {
+            // Block size is tuned during the first frames
+            TraceLaunch traceLaunch( static_cast<unsigned int>( ptcls.getNumElements() ), ptcls.get(), 0.009f );
+            osgCompute::LaunchTuner::instance()->launch( "osgcuda_ptcltracer", *_ptcls, traceLaunch );
+        }
 
         _timer->stop();
     }
@@ -76,3 +105,7 @@ extern "C" OSGCOMPUTE_PROGRAM_EXPORT osgCompute::Program* OSGCOMPUTE_CREATE_PROG
 {
     return new PtclDemo::PtclTracer;
 }
+
+// Registers the tracer without a library search if the
+// module is linked statically into the application
+OSGCOMPUTE_REGISTER_PROGRAM( osgcuda_ptcltracer, PtclDemo::PtclTracer )
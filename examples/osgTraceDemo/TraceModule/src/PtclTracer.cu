@@ -98,10 +98,10 @@ void traceKernel( unsigned int numPtcls, float4* ptcls, float etime )
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //------------------------------------------------------------------------------
 extern "C" __host__
-void trace( unsigned int numPtcls,  void* ptcls, float etime )
+void trace( unsigned int numPtcls,  void* ptcls, float etime, const unsigned int* numBlocks, const unsigned int* numThreads )
 {
-    dim3 blocks( (numPtcls/128)+1, 1, 1 );
-    dim3 threads( 128, 1, 1 );
+    dim3 blocks( numBlocks[0], numBlocks[1], numBlocks[2] );
+    dim3 threads( numThreads[0], numThreads[1], numThreads[2] );
 
     traceKernel<<< blocks, threads >>>( numPtcls, (float4*) ptcls, etime );
 }
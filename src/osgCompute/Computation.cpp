@@ -14,6 +14,7 @@
 */
 
 #include <sstream>
+#include <algorithm>
 #include <osg/NodeVisitor>
 #include <osg/OperationThread>
 #include <osgDB/Registry>
@@ -23,6 +24,8 @@
 #include <osgUtil/GLObjectsVisitor>
 #include <osgCompute/Visitor>
 #include <osgCompute/Memory>
+#include <osgCompute/MemoryBudget>
+#include <osgCompute/MirrorCompressor>
 #include <osgCompute/Computation>
 
 namespace osgCompute
@@ -128,10 +131,27 @@ namespace osgCompute
             rbitr->second->draw(renderInfo,previous);
         }
 
+        // Place intermediate buffers before
+        // any program maps them
+        _computation->placeTransients();
+
+        // Execute launches submitted by other threads
+        _computation->getLaunchQueue()->drain();
+
+        // Protect memory mapped from now on from eviction
+        MemoryBudget::instance()->beginLaunch();
+
+        LaunchPlan* plan = _computation->getLaunchPlan();
+        if( plan != NULL ) 
+            plan->begin();
+
         if( _computation->getLaunchCallback() ) 
             (*_computation->getLaunchCallback())( *_computation ); 
         else launch();  
 
+        if( plan != NULL ) 
+            plan->end();
+
         // don't forget to decrement dynamic object count
         renderInfo.getState()->decrementDynamicObjectCount();
 
@@ -250,6 +270,29 @@ namespace osgCompute
         }
     }
 
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // STATIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    bool Computation::s_headless = false;
+
+    //------------------------------------------------------------------------------
+    void Computation::setHeadless( bool headless )
+    {
+        s_headless = headless;
+    }
+
+    //------------------------------------------------------------------------------
+    bool Computation::isHeadless()
+    {
+        return s_headless;
+    }
+
+    //------------------------------------------------------------------------------
+    static bool largerTransient( const TransientHandle* lhs, const TransientHandle* rhs )
+    {
+        return lhs->_byteSize > rhs->_byteSize;
+    }
+
     /////////////////////////////////////////////////////////////////////////////////////////////////
     // PUBLIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
     /////////////////////////////////////////////////////////////////////////////////////////////////
@@ -258,7 +301,9 @@ namespace osgCompute
         :   osg::Group()
     { 
         _launchCallback = NULL;
+        _launchQueue = new LaunchQueue;
         _enabled = true;
+        _transientStoreFailed = false;
 
         // setup computation order
         _computeOrder = UPDATE_BEFORECHILDREN;
@@ -285,6 +330,14 @@ namespace osgCompute
             }
             else if( nv.getVisitorType() == osg::NodeVisitor::UPDATE_VISITOR )
             {
+                // Compress idle host memory once per frame
+                if( nv.getFrameStamp() != NULL )
+                    MirrorCompressor::instance()->frame( nv.getFrameStamp()->getFrameNumber() );
+
+                // Programs write to the buffer which has not
+                // been rendered during the last frame
+                if( _enabled && (_computeOrder & OSGCOMPUTE_PIPELINED) == OSGCOMPUTE_PIPELINED )
+                    swapResources();
 
                 if( _enabled && (_computeOrder & UPDATE_BEFORECHILDREN) == UPDATE_BEFORECHILDREN )
                     launch();
@@ -326,6 +379,8 @@ namespace osgCompute
     //------------------------------------------------------------------------------
     void Computation::addProgram( Program& program )
     {
+        invalidateLaunchPlan();
+
         Resource* curResource = NULL;
         for( ResourceHandleListItr itr = _resources.begin(); itr != _resources.end(); ++itr )
         {
@@ -350,6 +405,8 @@ namespace osgCompute
     //------------------------------------------------------------------------------
     void Computation::removeProgram( Program& program )
     {
+        invalidateLaunchPlan();
+
         for( ProgramListItr itr = _programs.begin(); itr != _programs.end(); ++itr )
         {
             if( (*itr) == &program )
@@ -370,6 +427,8 @@ namespace osgCompute
     //------------------------------------------------------------------------------
     void Computation::removeProgram( const std::string& programIdentifier )
     {
+        invalidateLaunchPlan();
+
         ProgramListItr itr = _programs.begin();
         while( itr != _programs.end() )
         {
@@ -396,6 +455,8 @@ namespace osgCompute
     //------------------------------------------------------------------------------
     void Computation::removePrograms()
     {
+        invalidateLaunchPlan();
+
         ProgramListItr itr;
         while( !_programs.empty() )
         {
@@ -512,6 +573,8 @@ namespace osgCompute
         if( hasResource(resource) )
             return;
 
+        invalidateLaunchPlan();
+
         for( ProgramListItr itr = _programs.begin(); itr != _programs.end(); ++itr )
             (*itr)->acceptResource( resource );
 
@@ -524,6 +587,8 @@ namespace osgCompute
     //------------------------------------------------------------------------------
     void Computation::exchangeResource( Resource& newResource, bool serialize /*= true */ )
     {
+        invalidateLaunchPlan();
+
         IdentifierSet& ids = newResource.getIdentifiers();
         for( ResourceHandleListItr itr = _resources.begin(); itr != _resources.end(); ++itr )
         {
@@ -560,6 +625,8 @@ namespace osgCompute
     //------------------------------------------------------------------------------
     void osgCompute::Computation::removeResource( const std::string& handle )
     {
+        invalidateLaunchPlan();
+
         Resource* curResource = NULL;
 
         ResourceHandleListItr itr = _resources.begin();
@@ -587,6 +654,8 @@ namespace osgCompute
     //------------------------------------------------------------------------------
     void Computation::removeResource( Resource& resource )
     {
+        invalidateLaunchPlan();
+
 		for( ResourceHandleListItr itr = _resources.begin();
 			itr != _resources.end();
 			++itr )
@@ -606,6 +675,8 @@ namespace osgCompute
     //------------------------------------------------------------------------------
     void Computation::removeResources()
     {
+        invalidateLaunchPlan();
+
         ResourceHandleListItr itr = _resources.begin();
         while( itr != _resources.end() )
         {
@@ -633,6 +704,46 @@ namespace osgCompute
         return _resources;
     }
 
+    //------------------------------------------------------------------------------
+    void Computation::addTransientResource( TransientBuffer& buffer, Program& firstUse, Program& lastUse )
+    {
+        for( TransientHandleListItr itr = _transients.begin(); itr != _transients.end(); ++itr )
+        {
+            if( (*itr)._buffer == &buffer )
+            {
+                // Update the lifetime only
+                (*itr)._firstUse = &firstUse;
+                (*itr)._lastUse = &lastUse;
+                (*itr)._byteSize = 0;
+                return;
+            }
+        }
+
+        addResource( buffer, false );
+
+        TransientHandle newHandle;
+        newHandle._buffer = &buffer;
+        newHandle._firstUse = &firstUse;
+        newHandle._lastUse = &lastUse;
+        newHandle._firstIdx = 0;
+        newHandle._lastIdx = 0;
+        newHandle._byteSize = 0;
+        newHandle._offset = 0;
+        _transients.push_back( newHandle );
+    }
+
+    //------------------------------------------------------------------------------
+    const TransientHandleList& Computation::getTransientResources() const
+    {
+        return _transients;
+    }
+
+    //------------------------------------------------------------------------------
+    const Memory* Computation::getTransientStore() const
+    {
+        return _transientStore.get();
+    }
+
 	//------------------------------------------------------------------------------
 	bool Computation::isResourceSerialized( Resource& resource ) const
 	{
@@ -656,6 +767,8 @@ namespace osgCompute
         if( lc == _launchCallback )
             return;
 
+        invalidateLaunchPlan();
+
         _launchCallback = lc; 
     }
 
@@ -671,6 +784,58 @@ namespace osgCompute
         return _launchCallback; 
     }
 
+    //------------------------------------------------------------------------------
+    void Computation::enqueueLaunch( Program& program, osg::Referenced* params /*= NULL*/ )
+    {
+        _launchQueue->push( *new LaunchCommand( program, params ) );
+    }
+
+    //------------------------------------------------------------------------------
+    LaunchQueue* Computation::getLaunchQueue()
+    {
+        return _launchQueue.get();
+    }
+
+    //------------------------------------------------------------------------------
+    const LaunchQueue* Computation::getLaunchQueue() const
+    {
+        return _launchQueue.get();
+    }
+
+    //------------------------------------------------------------------------------
+    void Computation::setLaunchPlanEnabled( bool enabled )
+    {
+        if( enabled && !_launchPlan.valid() )
+            _launchPlan = new LaunchPlan;
+        else if( !enabled )
+            _launchPlan = NULL;
+    }
+
+    //------------------------------------------------------------------------------
+    bool Computation::isLaunchPlanEnabled() const
+    {
+        return _launchPlan.valid();
+    }
+
+    //------------------------------------------------------------------------------
+    LaunchPlan* Computation::getLaunchPlan()
+    {
+        return _launchPlan.get();
+    }
+
+    //------------------------------------------------------------------------------
+    const LaunchPlan* Computation::getLaunchPlan() const
+    {
+        return _launchPlan.get();
+    }
+
+    //------------------------------------------------------------------------------
+    void Computation::invalidateLaunchPlan()
+    {
+        if( _launchPlan.valid() )
+            _launchPlan->invalidate();
+    }
+
     //------------------------------------------------------------------------------
     void Computation::setComputeOrder( Computation::ComputeOrder co, int orderNum/* = 0 */)
     {
@@ -725,6 +890,9 @@ namespace osgCompute
 
             for( ResourceHandleListItr itr = _resources.begin(); itr != _resources.end(); ++itr )
                 (*itr)._resource->releaseObjects();
+
+            if( _transientStore.valid() )
+                _transientStore->releaseObjects();
         }
 
         Group::releaseGLObjects( state );
@@ -801,8 +969,21 @@ namespace osgCompute
     {            
         // Check if graphics context exist
         // or return otherwise
-        if( NULL != GLMemory::getContext() && GLMemory::getContext()->isRealized() )
+        if( s_headless || (NULL != GLMemory::getContext() && GLMemory::getContext()->isRealized()) )
         {       
+            // Place intermediate buffers before
+            // any program maps them
+            placeTransients();
+
+            // Execute launches submitted by other threads
+            _launchQueue->drain();
+
+            // Protect memory mapped from now on from eviction
+            MemoryBudget::instance()->beginLaunch();
+
+            if( _launchPlan.valid() )
+                _launchPlan->begin();
+
             // Launch programs
             if( _launchCallback.valid() ) 
             {
@@ -818,6 +999,168 @@ namespace osgCompute
                     }
                 }
             }
+
+            if( _launchPlan.valid() )
+                _launchPlan->end();
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    Memory* Computation::createTransientStore( size_t ) const
+    {
+        return NULL;
+    }
+
+    //------------------------------------------------------------------------------
+    void Computation::placeTransients()
+    {
+        if( _transients.empty() )
+            return;
+
+        //////////////////////
+        // UPDATE LIFETIMES //
+        //////////////////////
+        // Retry a failed allocation only after
+        // the layout has changed
+        bool changed = !_transientStore.valid() && !_transientStoreFailed;
+        TransientHandleListItr itr = _transients.begin();
+        while( itr != _transients.end() )
+        {
+            TransientHandle& handle = (*itr);
+            if( !hasResource( *handle._buffer ) )
+            {
+                // Buffer has been removed from the computation
+                handle._buffer->setStore( NULL, 0 );
+                itr = _transients.erase( itr );
+                changed = true;
+                continue;
+            }
+
+            // Transients of unknown programs are 
+            // live during the complete launch
+            unsigned int firstIdx = 0;
+            unsigned int lastIdx = _programs.size();
+            unsigned int idx = 0;
+            for( ProgramListCnstItr prgItr = _programs.begin(); prgItr != _programs.end(); ++prgItr, ++idx )
+            {
+                if( (*prgItr) == handle._firstUse )
+                    firstIdx = idx;
+                if( (*prgItr) == handle._lastUse )
+                    lastIdx = idx;
+            }
+
+            if( firstIdx > lastIdx )
+                std::swap( firstIdx, lastIdx );
+
+            // Start each buffer at an aligned address
+            size_t byteSize = handle._buffer->getByteSize( MAP_DEVICE );
+            byteSize = (byteSize + 255) & ~size_t(255);
+
+            if( handle._firstIdx != firstIdx || handle._lastIdx != lastIdx || handle._byteSize != byteSize )
+            {
+                handle._firstIdx = firstIdx;
+                handle._lastIdx = lastIdx;
+                handle._byteSize = byteSize;
+                changed = true;
+            }
+
+            ++itr;
+        }
+
+        if( !changed )
+            return;
+
+        ///////////////////
+        // PLACE BUFFERS //
+        ///////////////////
+        std::vector<TransientHandle*> placed;
+        for( itr = _transients.begin(); itr != _transients.end(); ++itr )
+            placed.push_back( &(*itr) );
+
+        // Place larger buffers first
+        std::stable_sort( placed.begin(), placed.end(), largerTransient );
+
+        size_t storeSize = 0;
+        for( unsigned int t=0; t<placed.size(); ++t )
+        {
+            TransientHandle& handle = *placed[t];
+
+            // Collect ranges of buffers which are 
+            // live at the same time
+            std::vector< std::pair<size_t,size_t> > occupied;
+            for( unsigned int o=0; o<t; ++o )
+            {
+                const TransientHandle& other = *placed[o];
+                if( other._firstIdx <= handle._lastIdx && handle._firstIdx <= other._lastIdx )
+                    occupied.push_back( std::make_pair( other._offset, other._offset + other._byteSize ) );
+            }
+            std::sort( occupied.begin(), occupied.end() );
+
+            // Take the first gap which is large enough
+            size_t offset = 0;
+            for( unsigned int o=0; o<occupied.size(); ++o )
+            {
+                if( offset + handle._byteSize <= occupied[o].first )
+                    break;
+
+                offset = std::max( offset, occupied[o].second );
+            }
+
+            handle._offset = offset;
+            storeSize = std::max( storeSize, offset + handle._byteSize );
+        }
+
+        ////////////////////
+        // ALLOCATE STORE //
+        ////////////////////
+        if( storeSize == 0 )
+            return;
+
+        if( !_transientStore.valid() || _transientStore->getByteSize( MAP_DEVICE ) < storeSize )
+        {
+            if( _transientStore.valid() )
+                _transientStore->releaseObjects();
+
+            _transientStore = createTransientStore( storeSize );
+            if( !_transientStore.valid() )
+            {
+                osg::notify(osg::WARN)  << __FUNCTION__ << ": for \""
+                    << getName()<<"\": cannot allocate store for transient resources."
+                    << std::endl;
+
+                for( itr = _transients.begin(); itr != _transients.end(); ++itr )
+                    (*itr)._buffer->setStore( NULL, 0 );
+
+                _transientStoreFailed = true;
+                return;
+            }
+        }
+
+        _transientStoreFailed = false;
+
+        for( itr = _transients.begin(); itr != _transients.end(); ++itr )
+            (*itr)._buffer->setStore( _transientStore.get(), (*itr)._offset );
+
+        // Buffers have been moved
+        invalidateLaunchPlan();
+    }
+
+    //------------------------------------------------------------------------------
+    void Computation::swapResources()
+    {
+        // Nothing has been computed as long as
+        // no graphics context exists
+        if( !s_headless && (NULL == GLMemory::getContext() || !GLMemory::getContext()->isRealized()) )
+            return;
+
+        // Swap multi-buffered memory so that the following
+        // launch writes to the current swap index while the
+        // draw of the last frame still reads the previous one
+        for( ResourceHandleListItr itr = _resources.begin(); itr != _resources.end(); ++itr )
+        {
+            Memory* curMemory = dynamic_cast<Memory*>( (*itr)._resource.get() );
+            if( curMemory != NULL && curMemory->getSwapCount() > 1 )
+                curMemory->swap();
         }
     }
 
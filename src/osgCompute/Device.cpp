@@ -0,0 +1,131 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+
+#include <osg/Notify>
+#include <osgCompute/Device>
+
+namespace osgCompute
+{
+    DeviceList Device::s_devices;
+
+    // Each thread selects its own device
+    static OSGCOMPUTE_THREAD_LOCAL unsigned int s_currentIdx = 0;
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    Device::Device( unsigned int id /*= 0*/ )
+        : osg::Referenced(),
+          _id( id )
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int Device::getId() const
+    {
+        return _id;
+    }
+
+    //------------------------------------------------------------------------------
+    bool Device::makeCurrent()
+    {
+        // Host devices are always active
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    bool Device::isEmulated() const
+    {
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    std::string Device::getName() const
+    {
+        return "Host";
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // STATIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    unsigned int Device::addDevice( Device& device )
+    {
+        s_devices.push_back( &device );
+        return s_devices.size() - 1;
+    }
+
+    //------------------------------------------------------------------------------
+    void Device::removeAllDevices()
+    {
+        s_devices.clear();
+        s_currentIdx = 0;
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int Device::getNumDevices()
+    {
+        return s_devices.size();
+    }
+
+    //------------------------------------------------------------------------------
+    Device* Device::getDevice( unsigned int idx )
+    {
+        if( idx >= s_devices.size() )
+            return NULL;
+
+        return s_devices[idx].get();
+    }
+
+    //------------------------------------------------------------------------------
+    bool Device::setCurrent( unsigned int idx )
+    {
+        if( idx >= s_devices.size() )
+        {
+            osg::notify(osg::WARN) 
+                << __FUNCTION__ << ": device index \"" << idx << "\" is out of range." 
+                << std::endl;
+            return false;
+        }
+
+        if( !s_devices[idx]->makeCurrent() )
+        {
+            osg::notify(osg::WARN) 
+                << __FUNCTION__ << ": cannot activate device \"" << s_devices[idx]->getId() << "\"."
+                << std::endl;
+            return false;
+        }
+
+        s_currentIdx = idx;
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int Device::getCurrentIdx()
+    {
+        // Devices might have been removed by another thread
+        if( s_currentIdx >= s_devices.size() )
+            return 0;
+
+        return s_currentIdx;
+    }
+
+    //------------------------------------------------------------------------------
+    Device* Device::getCurrent()
+    {
+        return getDevice( getCurrentIdx() );
+    }
+}
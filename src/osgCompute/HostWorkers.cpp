@@ -0,0 +1,120 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+
+#include <algorithm>
+#include <OpenThreads/Thread>
+#include <OpenThreads/ScopedLock>
+#include <osgCompute/HostWorkers>
+
+namespace osgCompute
+{
+    //! Thread of the host workers
+    class HostWorker : public OpenThreads::Thread
+    {
+    public:
+        HostWorker( HostWorkers& workers, unsigned int idx ) : _workers( workers ), _idx( idx ) {}
+
+        virtual void run()
+        {
+            while( true )
+            {
+                _workers._start.block();
+                if( _workers._done )
+                    break;
+
+                _workers._job->execute( _idx, _workers._numThreads );
+                _workers._finish.block();
+            }
+        }
+
+    private:
+        HostWorkers&    _workers;
+        unsigned int    _idx;
+    };
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    HostWorkers* HostWorkers::instance()
+    {
+        static osg::ref_ptr<HostWorkers> s_hostWorkers = new HostWorkers( static_cast<unsigned int>( OpenThreads::GetNumberOfProcessors() ) );
+        return s_hostWorkers.get();
+    }
+
+    //------------------------------------------------------------------------------
+    HostWorkers::HostWorkers( unsigned int numThreads )
+        : osg::Referenced(),
+          _numThreads( numThreads > 0 ? numThreads : 1 ),
+          _start( _numThreads ),
+          _finish( _numThreads ),
+          _job( NULL ),
+          _done( false )
+    {
+        for( unsigned int t=1; t<_numThreads; ++t )
+        {
+            HostWorker* worker = new HostWorker( *this, t );
+            worker->start();
+            _workers.push_back( worker );
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    void HostWorkers::run( HostJob& job )
+    {
+        // Jobs of different threads share the workers
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock( _runMutex );
+        _job = &job;
+
+        if( _workers.empty() )
+        {
+            _job->execute( 0, 1 );
+            return;
+        }
+
+        _start.block();
+        _job->execute( 0, _numThreads );
+        _finish.block();
+    }
+
+    //------------------------------------------------------------------------------
+    void HostWorkers::getRange( size_t count, size_t granularity, unsigned int thread, unsigned int numThreads, size_t& begin, size_t& end )
+    {
+        size_t numBlocks = (count + granularity - 1) / granularity;
+        size_t blocksPerThread = (numBlocks + numThreads - 1) / numThreads;
+
+        begin = (std::min)( count, thread * blocksPerThread * granularity );
+        end = (std::min)( count, (thread + 1) * blocksPerThread * granularity );
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PROTECTED FUNCTIONS //////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    HostWorkers::~HostWorkers()
+    {
+        if( !_workers.empty() )
+        {
+            _done = true;
+            _start.block();
+        }
+
+        for( std::vector<HostWorker*>::iterator itr = _workers.begin(); itr != _workers.end(); ++itr )
+        {
+            (*itr)->join();
+            delete (*itr);
+        }
+    }
+}
@@ -0,0 +1,385 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+
+
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <osg/Notify>
+#include <osg/Timer>
+#include <osgCompute/Device>
+#include <osgCompute/LaunchConfig>
+
+namespace osgCompute
+{
+    osg::ref_ptr<LaunchTuner> LaunchTuner::s_launchTuner = NULL;
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    LaunchConfig::LaunchConfig()
+    {
+        for( unsigned int d=0; d<3; ++d )
+        {
+            _blocks[d] = 1;
+            _threads[d] = 1;
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    LaunchConfig LaunchConfig::compute( unsigned int groupSize, 
+                                        unsigned int width, unsigned int height /*= 1*/, unsigned int depth /*= 1*/, 
+                                        unsigned int maxGridDim /*= 65535*/ )
+    {
+        LaunchConfig config;
+        if( groupSize == 0 ) groupSize = 1;
+        if( maxGridDim == 0 ) maxGridDim = 1;
+        if( height == 0 ) height = 1;
+        if( depth == 0 ) depth = 1;
+
+        if( height == 1 && depth == 1 )
+        {
+            config._threads[0] = groupSize;
+
+            unsigned int numBlocks = (width + groupSize - 1) / groupSize;
+            if( numBlocks > maxGridDim )
+            {
+                // Fold remaining blocks into the 
+                // second dimension of the grid
+                config._blocks[1] = (numBlocks + maxGridDim - 1) / maxGridDim;
+                config._blocks[0] = (numBlocks + config._blocks[1] - 1) / config._blocks[1];
+            }
+            else
+            {
+                config._blocks[0] = numBlocks;
+            }
+        }
+        else
+        {
+            // Rows of a block should be at least a warp wide
+            config._threads[0] = (groupSize < 32)? groupSize : 32;
+            config._threads[1] = (groupSize + config._threads[0] - 1) / config._threads[0];
+
+            config._blocks[0] = (width + config._threads[0] - 1) / config._threads[0];
+            config._blocks[1] = (height + config._threads[1] - 1) / config._threads[1];
+            config._blocks[2] = depth;
+        }
+
+        return config;
+    }
+
+    //------------------------------------------------------------------------------
+    LaunchConfig LaunchConfig::compute( unsigned int groupSize, const Memory& memory, unsigned int maxGridDim /*= 65535*/ )
+    {
+        unsigned int numDims = memory.getNumDimensions();
+        return compute( groupSize, 
+            memory.getDimension(0), 
+            (numDims > 1)? memory.getDimension(1) : 1,
+            (numDims > 2)? memory.getDimension(2) : 1,
+            maxGridDim );
+    }
+
+    //------------------------------------------------------------------------------
+    LaunchTuner* LaunchTuner::instance()
+    {
+        if( !s_launchTuner.valid() )
+            s_launchTuner = new LaunchTuner;
+
+        return s_launchTuner.get();
+    }
+
+    //------------------------------------------------------------------------------
+    LaunchConfig LaunchTuner::launch( const std::string& program, const Memory& memory, LaunchFunction& function )
+    {
+        unsigned int numDims = memory.getNumDimensions();
+        return launch( program,
+            memory.getDimension(0), 
+            (numDims > 1)? memory.getDimension(1) : 1,
+            (numDims > 2)? memory.getDimension(2) : 1,
+            function );
+    }
+
+    //------------------------------------------------------------------------------
+    LaunchConfig LaunchTuner::launch( const std::string& program, unsigned int width, unsigned int height, unsigned int depth, LaunchFunction& function )
+    {
+        if( !_cacheRead )
+            readCache();
+
+        Entry& entry = _entries[ getKey(program, width, height, depth) ];
+        if( entry._tuned )
+        {
+            function.launch( entry._config );
+            return entry._config;
+        }
+
+        // Restart if candidates or the number of samples have changed
+        if( entry._times.size() != _candidates.size() || entry._numSamples != _numSamples )
+        {
+            entry._times.assign( _candidates.size(), -1.0 );
+            entry._numLaunches = 0;
+            entry._numSamples = _numSamples;
+        }
+
+        ///////////////////////
+        // MEASURE CANDIDATE //
+        ///////////////////////
+        unsigned int candidateIdx = entry._numLaunches / _numSamples;
+        LaunchConfig config = LaunchConfig::compute( _candidates[candidateIdx], width, height, depth, _maxGridDim );
+
+        osg::Timer_t start = osg::Timer::instance()->tick();
+        function.launch( config );
+        function.finish();
+        double time = osg::Timer::instance()->delta_u( start, osg::Timer::instance()->tick() );
+
+        if( entry._times[candidateIdx] < 0.0 || time < entry._times[candidateIdx] )
+            entry._times[candidateIdx] = time;
+
+        ++entry._numLaunches;
+        if( entry._numLaunches < _candidates.size() * _numSamples )
+            return config;
+
+        ////////////////////
+        // SELECT FASTEST //
+        ////////////////////
+        unsigned int fastestIdx = 0;
+        for( unsigned int c=1; c<entry._times.size(); ++c )
+            if( entry._times[c] < entry._times[fastestIdx] )
+                fastestIdx = c;
+
+        entry._config = LaunchConfig::compute( _candidates[fastestIdx], width, height, depth, _maxGridDim );
+        entry._time = entry._times[fastestIdx];
+        entry._tuned = true;
+        entry._times.clear();
+
+        osg::notify(osg::INFO)
+            << __FUNCTION__ << ": " << program << " uses group size " << _candidates[fastestIdx]
+            << " for problem size " << width << "x" << height << "x" << depth 
+            << " (" << entry._time << "us)."
+            << std::endl;
+
+        if( !_cacheFile.empty() )
+            writeCache();
+
+        return config;
+    }
+
+    //------------------------------------------------------------------------------
+    bool LaunchTuner::getConfig( const std::string& program, unsigned int width, unsigned int height, unsigned int depth, LaunchConfig& config )
+    {
+        if( !_cacheRead )
+            readCache();
+
+        EntryMapCnstItr itr = _entries.find( getKey(program, width, height, depth) );
+        if( itr == _entries.end() || !(*itr).second._tuned )
+            return false;
+
+        config = (*itr).second._config;
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    void LaunchTuner::setCandidates( const std::vector<unsigned int>& groupSizes )
+    {
+        std::vector<unsigned int> candidates;
+        for( unsigned int c=0; c<groupSizes.size(); ++c )
+            if( groupSizes[c] > 0 )
+                candidates.push_back( groupSizes[c] );
+
+        if( candidates.empty() )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << ": at least one group size must be specified."
+                << std::endl;
+
+            return;
+        }
+
+        _candidates = candidates;
+    }
+
+    //------------------------------------------------------------------------------
+    const std::vector<unsigned int>& LaunchTuner::getCandidates() const
+    {
+        return _candidates;
+    }
+
+    //------------------------------------------------------------------------------
+    void LaunchTuner::setNumSamples( unsigned int numSamples )
+    {
+        _numSamples = (numSamples > 0)? numSamples : 1;
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int LaunchTuner::getNumSamples() const
+    {
+        return _numSamples;
+    }
+
+    //------------------------------------------------------------------------------
+    void LaunchTuner::setMaxGridDim( unsigned int maxGridDim )
+    {
+        _maxGridDim = (maxGridDim > 0)? maxGridDim : 1;
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int LaunchTuner::getMaxGridDim() const
+    {
+        return _maxGridDim;
+    }
+
+    //------------------------------------------------------------------------------
+    bool LaunchTuner::setCacheFile( const std::string& file )
+    {
+        _cacheFile = file;
+        return readCache();
+    }
+
+    //------------------------------------------------------------------------------
+    const std::string& LaunchTuner::getCacheFile() const
+    {
+        return _cacheFile;
+    }
+
+    //------------------------------------------------------------------------------
+    bool LaunchTuner::writeCache() const
+    {
+        if( _cacheFile.empty() )
+            return false;
+
+        std::ofstream out( _cacheFile.c_str() );
+        if( !out )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << ": cannot write launch cache \"" << _cacheFile << "\"."
+                << std::endl;
+
+            return false;
+        }
+
+        // One tuned problem per line: 
+        // program <TAB> device <TAB> size <TAB> blocks threads time
+        out << "# osgCompute launch configurations" << std::endl;
+        for( EntryMapCnstItr itr = _entries.begin(); itr != _entries.end(); ++itr )
+        {
+            const Entry& entry = (*itr).second;
+            if( !entry._tuned )
+                continue;
+
+            out << (*itr).first << "\t"
+                << entry._config._blocks[0] << " " << entry._config._blocks[1] << " " << entry._config._blocks[2] << " "
+                << entry._config._threads[0] << " " << entry._config._threads[1] << " " << entry._config._threads[2] << " "
+                << entry._time << std::endl;
+        }
+
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    void LaunchTuner::clear()
+    {
+        _entries.clear();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PROTECTED FUNCTIONS //////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    LaunchTuner::LaunchTuner()
+        : osg::Referenced(),
+          _numSamples( 3 ),
+          _maxGridDim( 65535 ),
+          _cacheRead( false )
+    {
+        _candidates.push_back( 32 );
+        _candidates.push_back( 64 );
+        _candidates.push_back( 128 );
+        _candidates.push_back( 256 );
+        _candidates.push_back( 512 );
+
+        const char* cacheFile = getenv( "OSGCOMPUTE_TUNING_CACHE" );
+        if( cacheFile != NULL )
+            _cacheFile = cacheFile;
+    }
+
+    //------------------------------------------------------------------------------
+    bool LaunchTuner::readCache()
+    {
+        _cacheRead = true;
+        if( _cacheFile.empty() )
+            return true;
+
+        std::ifstream in( _cacheFile.c_str() );
+        if( !in )
+            return true; // file is created after the first tuning
+
+        std::string line;
+        unsigned int lineNum = 0;
+        while( std::getline( in, line ) )
+        {
+            ++lineNum;
+            if( line.empty() || line[0] == '#' )
+                continue;
+
+            // The key ends with the last tab
+            std::string::size_type sep = line.rfind( '\t' );
+            if( sep == std::string::npos )
+            {
+                osg::notify(osg::WARN)
+                    << __FUNCTION__ << ": invalid line " << lineNum << " in launch cache \"" << _cacheFile << "\"."
+                    << std::endl;
+
+                return false;
+            }
+
+            Entry entry;
+            std::istringstream values( line.substr( sep + 1 ) );
+            values >> entry._config._blocks[0] >> entry._config._blocks[1] >> entry._config._blocks[2]
+                   >> entry._config._threads[0] >> entry._config._threads[1] >> entry._config._threads[2]
+                   >> entry._time;
+            if( values.fail() )
+            {
+                osg::notify(osg::WARN)
+                    << __FUNCTION__ << ": invalid line " << lineNum << " in launch cache \"" << _cacheFile << "\"."
+                    << std::endl;
+
+                return false;
+            }
+
+            // Configurations tuned in this session are newer
+            Entry& current = _entries[ line.substr( 0, sep ) ];
+            if( !current._tuned )
+            {
+                entry._tuned = true;
+                current = entry;
+            }
+        }
+
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    std::string LaunchTuner::getKey( const std::string& program, unsigned int width, unsigned int height, unsigned int depth ) const
+    {
+        Device* device = Device::getCurrent();
+
+        std::ostringstream key;
+        key << program << "\t" 
+            << ((device != NULL)? device->getName() : std::string("Default")) << "\t"
+            << width << "x" << height << "x" << depth;
+
+        return key.str();
+    }
+}
@@ -0,0 +1,214 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*                                                                     
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*                                                                     
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+
+#include <osgCompute/LaunchPlan>
+
+namespace osgCompute
+{
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // STATIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // Each thread launches its own computation
+    static OSGCOMPUTE_THREAD_LOCAL LaunchPlan* s_activePlan = NULL;
+
+    //------------------------------------------------------------------------------
+    LaunchPlan* LaunchPlan::getActive()
+    {
+        return s_activePlan;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    LaunchPlan::LaunchPlan()
+        : osg::Referenced(),
+          _cursor( 0 ),
+          _refresh( 0 ),
+          _numReplayed( 0 ),
+          _state( INVALID )
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    void LaunchPlan::begin()
+    {
+        if( _state == INVALID )
+            _state = RECORDING;
+
+        _cursor = 0;
+        _refresh = 0;
+        s_activePlan = this;
+    }
+
+    //------------------------------------------------------------------------------
+    void LaunchPlan::end()
+    {
+        if( s_activePlan == this )
+            s_activePlan = NULL;
+
+        if( _state == RECORDING )
+        {
+            _state = _mappings.empty()? INVALID : RECORDED;
+        }
+        else if( _state == RECORDED && _cursor != _mappings.size() )
+        {
+            // Less mappings than recorded
+            invalidate();
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    void LaunchPlan::invalidate()
+    {
+        _mappings.clear();
+        _cursor = 0;
+        _refresh = 0;
+        _numReplayed = 0;
+        _state = INVALID;
+    }
+
+    //------------------------------------------------------------------------------
+    LaunchPlan::State LaunchPlan::getState() const
+    {
+        return _state;
+    }
+
+    //------------------------------------------------------------------------------
+    bool LaunchPlan::isRecording() const
+    {
+        return (s_activePlan == this && _state == RECORDING);
+    }
+
+    //------------------------------------------------------------------------------
+    bool LaunchPlan::isReplaying() const
+    {
+        return (s_activePlan == this && _state == RECORDED);
+    }
+
+    //------------------------------------------------------------------------------
+    void* LaunchPlan::replay( Memory& memory, unsigned int mapping, size_t offset, unsigned int hint )
+    {
+        if( !isReplaying() )
+            return NULL;
+
+        _refresh = 0;
+        if( _cursor >= _mappings.size() )
+        {
+            // More mappings than recorded
+            invalidate();
+            return NULL;
+        }
+
+        MappingEntry& entry = _mappings[_cursor++];
+        if( entry._memory != &memory || entry._mapping != mapping || 
+            entry._offset != offset || entry._hint != hint )
+        {
+            // Sequence has changed
+            invalidate();
+            return NULL;
+        }
+
+        if( !entry._replayable )
+        {
+            // Record the mapping again
+            _refresh = _cursor;
+            return NULL;
+        }
+
+        MemoryObject* object = memory._object.get();
+        if( object != entry._object.get() || object->_numEvictions != entry._numEvictions )
+        {
+            // Memory has been released or evicted in the meantime
+            invalidate();
+            return NULL;
+        }
+
+        // Memory has been changed outside of the plan
+        // and must be synchronized first
+        if( object->_syncOp != entry._preSyncOp )
+        {
+            _refresh = _cursor;
+            return NULL;
+        }
+
+        object->_mapping = mapping;
+        object->_syncOp = entry._postSyncOp;
+        ++_numReplayed;
+        return entry._ptr;
+    }
+
+    //------------------------------------------------------------------------------
+    void LaunchPlan::record( Memory& memory, unsigned int mapping, size_t offset, unsigned int hint, 
+                             void* ptr, unsigned int syncOp, bool replayable )
+    {
+        if( isReplaying() )
+        {
+            // Refresh the entry of the last mapping 
+            // which could not be replayed
+            if( _refresh == 0 || _refresh > _mappings.size() || _mappings[_refresh-1]._memory != &memory )
+                return;
+
+            MappingEntry& entry = _mappings[_refresh-1];
+            _refresh = 0;
+
+            entry._object = memory._object.get();
+            entry._preSyncOp = syncOp;
+            entry._postSyncOp = entry._object.valid()? entry._object->_syncOp : NO_SYNC;
+            entry._numEvictions = entry._object.valid()? entry._object->_numEvictions : 0;
+            entry._ptr = ptr;
+            entry._replayable = replayable && entry._object.valid();
+            return;
+        }
+
+        if( !isRecording() )
+            return;
+
+        MappingEntry entry;
+        entry._memory = &memory;
+        entry._object = memory._object.get();
+        entry._mapping = mapping;
+        entry._offset = offset;
+        entry._hint = hint;
+        entry._preSyncOp = syncOp;
+        entry._postSyncOp = entry._object.valid()? entry._object->_syncOp : NO_SYNC;
+        entry._numEvictions = entry._object.valid()? entry._object->_numEvictions : 0;
+        entry._ptr = ptr;
+        entry._replayable = replayable && entry._object.valid();
+        _mappings.push_back( entry );
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int LaunchPlan::getNumMappings() const
+    {
+        return _mappings.size();
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int LaunchPlan::getNumReplayed() const
+    {
+        return _numReplayed;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PROTECTED FUNCTIONS //////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    LaunchPlan::~LaunchPlan()
+    {
+        if( s_activePlan == this )
+            s_activePlan = NULL;
+    }
+}
@@ -0,0 +1,139 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+
+#include <osg/Notify>
+#include <osgCompute/LaunchQueue>
+
+namespace osgCompute
+{
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    LaunchCommand::LaunchCommand( Program& program, osg::Referenced* params /*= NULL*/ )
+        : osg::Referenced(),
+          _program( &program ),
+          _params( params )
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    void LaunchCommand::execute()
+    {
+        if( !_program.valid() || !_program->isEnabled() )
+            return;
+
+        if( _params.valid() )
+            _program->acceptParameters( *_params );
+
+        _program->launch();
+    }
+
+    //------------------------------------------------------------------------------
+    LaunchQueue::LaunchQueue()
+        : osg::Referenced(),
+          _head( NULL )
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    void LaunchQueue::push( LaunchCommand& command )
+    {
+        Entry* entry = new Entry;
+        entry->_command = &command;
+
+        // Link the new entry in front of the current head. Retry
+        // if another thread has changed the head in the meantime.
+        do
+        {
+            entry->_next = static_cast<Entry*>( _head.get() );
+        }
+        while( !_head.assign( entry, entry->_next ) );
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int LaunchQueue::drain()
+    {
+        Entry* entry = detach();
+
+        // Entries are linked in reverse order of submission
+        Entry* ordered = NULL;
+        while( entry != NULL )
+        {
+            Entry* next = entry->_next;
+            entry->_next = ordered;
+            ordered = entry;
+            entry = next;
+        }
+
+        unsigned int numCommands = 0;
+        while( ordered != NULL )
+        {
+            Entry* next = ordered->_next;
+            if( ordered->_command.valid() )
+            {
+                ordered->_command->execute();
+                ++numCommands;
+            }
+
+            delete ordered;
+            ordered = next;
+        }
+
+        return numCommands;
+    }
+
+    //------------------------------------------------------------------------------
+    void LaunchQueue::clear()
+    {
+        Entry* entry = detach();
+        while( entry != NULL )
+        {
+            Entry* next = entry->_next;
+            delete entry;
+            entry = next;
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    bool LaunchQueue::empty() const
+    {
+        return (_head.get() == NULL);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PROTECTED FUNCTIONS //////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    LaunchQueue::~LaunchQueue()
+    {
+        clear();
+    }
+
+    //------------------------------------------------------------------------------
+    LaunchQueue::Entry* LaunchQueue::detach()
+    {
+        // Take over the complete list at once. Producers
+        // will start a new list on an empty head.
+        Entry* entry = NULL;
+        do
+        {
+            entry = static_cast<Entry*>( _head.get() );
+        }
+        while( entry != NULL && !_head.assign( NULL, entry ) );
+
+        return entry;
+    }
+}
@@ -28,7 +28,8 @@ namespace osgCompute
             _mapping( UNMAP ),
 			_allocHint(0),
 			_syncOp(NO_SYNC),
-            _pitch(0)
+            _pitch(0),
+            _numEvictions(0)
     {
     }
 
@@ -49,12 +50,22 @@ namespace osgCompute
         _elementSize = 0;
         _allocHint = 0;
         _subloadCallback = NULL;
+        _payload = NULL;
         _pitch = 0;
     }
 
     //------------------------------------------------------------------------------
     void Memory::setElementSize( unsigned int elementSize ) 
     { 
+        if( elementSize != 0 && _numElements > ((size_t)-1) / elementSize )
+        {
+            osg::notify( osg::FATAL )  
+                << __FUNCTION__ << " " << getName() << ": byte size of all elements exceeds the addressable memory."
+                << std::endl;
+
+            return;
+        }
+
         if( _object.valid() ) 
             releaseObjects();
 
@@ -68,14 +79,20 @@ namespace osgCompute
     }
 
     //------------------------------------------------------------------------------
-    unsigned int Memory::getAllElementsSize( unsigned int hint /*= 0 */ ) const 
+    unsigned int Memory::getStorageElementSize() const 
+    { 
+        return getElementSize(); 
+    }
+
+    //------------------------------------------------------------------------------
+    size_t Memory::getAllElementsSize( unsigned int hint /*= 0 */ ) const 
     { 
         return getElementSize() * getNumElements(); 
     }
     
 
     //------------------------------------------------------------------------------
-    unsigned int Memory::getByteSize( unsigned int mapping, unsigned int hint /*= 0 */ ) const 
+    size_t Memory::getByteSize( unsigned int mapping, unsigned int hint /*= 0 */ ) const 
     { 
         return 0;
     }
@@ -83,6 +100,34 @@ namespace osgCompute
     //------------------------------------------------------------------------------
     void Memory::setDimension( unsigned int dimIdx, unsigned int dimSize )
     {
+        // Compute the number of elements with 64-bit precision
+        // and reject sizes exceeding the addressable memory
+        unsigned int numDimensions = (_dimensions.size() > dimIdx)? _dimensions.size() : dimIdx+1;
+        size_t numElements = 1;
+        for( unsigned int d=0; d<numDimensions; ++d )
+        {
+            size_t curDimSize = (d == dimIdx)? dimSize : ((d < _dimensions.size())? _dimensions[d] : 0);
+            if( curDimSize != 0 && numElements > ((size_t)-1) / curDimSize )
+            {
+                osg::notify( osg::FATAL )  
+                    << __FUNCTION__ << " " << getName() << ": number of elements exceeds the addressable memory."
+                    << std::endl;
+
+                return;
+            }
+
+            numElements *= curDimSize;
+        }
+
+        if( _elementSize != 0 && numElements > ((size_t)-1) / _elementSize )
+        {
+            osg::notify( osg::FATAL )  
+                << __FUNCTION__ << " " << getName() << ": byte size of all elements exceeds the addressable memory."
+                << std::endl;
+
+            return;
+        }
+
         if( _object.valid() ) 
             releaseObjects();
 
@@ -90,10 +135,7 @@ namespace osgCompute
             _dimensions.resize(dimIdx+1,0);
 
         _dimensions[dimIdx] = dimSize;
-
-		_numElements = 1;
-		for( unsigned int d=0; d<_dimensions.size(); ++d )
-			_numElements *= _dimensions[d];
+        _numElements = numElements;
     }
 
     //------------------------------------------------------------------------------
@@ -112,7 +154,7 @@ namespace osgCompute
     }
 
     //------------------------------------------------------------------------------
-    unsigned int osgCompute::Memory::getNumElements() const
+    size_t osgCompute::Memory::getNumElements() const
     {
         return _numElements;
     }
@@ -150,6 +192,24 @@ namespace osgCompute
         return _subloadCallback.get(); 
     }
 
+    //------------------------------------------------------------------------------
+    void Memory::setPayload( Payload* payload ) 
+    { 
+        _payload = payload; 
+    }
+
+    //------------------------------------------------------------------------------
+    Payload* Memory::getPayload() 
+    { 
+        return _payload.get(); 
+    }
+
+    //------------------------------------------------------------------------------
+    const Payload* Memory::getPayload() const 
+    { 
+        return _payload.get(); 
+    }
+
     //------------------------------------------------------------------------------
     unsigned int Memory::getMapping( unsigned int ) const
     {
@@ -160,7 +220,7 @@ namespace osgCompute
     }
 
     //------------------------------------------------------------------------------
-    unsigned int Memory::getPitch( unsigned int hint /*= 0 */ ) const
+    size_t Memory::getPitch( unsigned int hint /*= 0 */ ) const
     {
         if( !_object.valid() )
             return computePitch();
@@ -212,6 +272,7 @@ namespace osgCompute
         _elementSize = 0;
         _pitch = 0;
         _numElements = 0;
+        _payload = NULL;
         Resource::clear();
     }
 
@@ -230,6 +291,24 @@ namespace osgCompute
     }
 
 
+    //------------------------------------------------------------------------------
+    bool Memory::evict()
+    {
+        return false;
+    }
+
+    //------------------------------------------------------------------------------
+    bool Memory::compress()
+    {
+        return false;
+    }
+
+    //------------------------------------------------------------------------------
+    size_t Memory::getCompressedByteSize() const
+    {
+        return 0;
+    }
+
     //------------------------------------------------------------------------------
     bool Memory::objectsReleased() const
     {
@@ -245,6 +324,27 @@ namespace osgCompute
         releaseObjectsLocal();
     }
 
+    //------------------------------------------------------------------------------
+    bool Memory::applyPayload()
+    {
+        if( !_payload.valid() )
+            return false;
+
+        // Detach first as the payload maps the memory
+        osg::ref_ptr<Payload> payload = _payload;
+        _payload = NULL;
+
+        if( !payload->decode() )
+        {
+            osg::notify( osg::WARN )  
+                << __FUNCTION__ << " " << getName() << ": cannot decode payload."
+                << std::endl;
+            return false;
+        }
+
+        return payload->apply( *this );
+    }
+
     //------------------------------------------------------------------------------
     MemoryObject* Memory::object( bool create /*= true*/ )
     {
@@ -315,7 +415,7 @@ namespace osgCompute
     }
 
     //------------------------------------------------------------------------------
-    unsigned int Memory::getAllocatedByteSize( unsigned int mapping, unsigned int hint /*= 0 */ ) const
+    size_t Memory::getAllocatedByteSize( unsigned int mapping, unsigned int hint /*= 0 */ ) const
     {
         return 0;
     }
@@ -353,6 +453,23 @@ namespace osgCompute
     /////////////////////////////////////////////////////////////////////////////////////////////////
     // PUBLIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
     /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    bool GLMemory::requestReadback( unsigned int )
+    {
+        return false;
+    }
+
+    //------------------------------------------------------------------------------
+    bool GLMemory::isReadbackReady( unsigned int ) const
+    {
+        return false;
+    }
+
+    //------------------------------------------------------------------------------
+    void GLMemory::addDirtyRegion( size_t, size_t, unsigned int )
+    {
+    }
+
     //------------------------------------------------------------------------------
     void GLMemory::releaseObjects()
     {
@@ -0,0 +1,230 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+
+#include <set>
+#include <climits>
+#include <osg/Notify>
+#include <osgCompute/Device>
+#include <osgCompute/MemoryBudget>
+
+namespace osgCompute
+{
+    osg::ref_ptr<MemoryBudget> MemoryBudget::s_memoryBudget = NULL;
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    MemoryBudget* MemoryBudget::instance()
+    {
+        if( !s_memoryBudget.valid() )
+            s_memoryBudget = new MemoryBudget;
+
+        return s_memoryBudget.get();
+    }
+
+    //------------------------------------------------------------------------------
+    void MemoryBudget::setBudget( unsigned int device, size_t byteSize )
+    {
+        _devices[device]._budget = byteSize;
+    }
+
+    //------------------------------------------------------------------------------
+    size_t MemoryBudget::getBudget( unsigned int device ) const
+    {
+        DeviceBudgetMapCnstItr itr = _devices.find( device );
+        return (itr != _devices.end())? (*itr).second._budget : 0;
+    }
+
+    //------------------------------------------------------------------------------
+    size_t MemoryBudget::getUsage( unsigned int device ) const
+    {
+        DeviceBudgetMapCnstItr itr = _devices.find( device );
+        return (itr != _devices.end())? (*itr).second._usage : 0;
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int MemoryBudget::getNumEvictions() const
+    {
+        return _numEvictions;
+    }
+
+    //------------------------------------------------------------------------------
+    size_t MemoryBudget::getEvictedByteSize() const
+    {
+        return _evictedByteSize;
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int MemoryBudget::getNumRestores() const
+    {
+        return _numRestores;
+    }
+
+    //------------------------------------------------------------------------------
+    void MemoryBudget::resetCounters()
+    {
+        _numEvictions = 0;
+        _evictedByteSize = 0;
+        _numRestores = 0;
+    }
+
+    //------------------------------------------------------------------------------
+    bool MemoryBudget::reserve( Memory& memory, size_t byteSize )
+    {
+        unsigned int device = Device::getCurrentIdx();
+        DeviceBudget& budget = _devices[device];
+        if( budget._budget == 0 )
+            return true;
+
+        if( byteSize > budget._budget )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << " " << memory.getName() << ": allocation of "
+                << byteSize << " bytes exceeds the budget of device " << device << "."
+                << std::endl;
+
+            return false;
+        }
+
+        std::set< MemoryObject* > skipped;
+        while( budget._usage + byteSize > budget._budget )
+        {
+            // Find least recently mapped memory of this device
+            EntryMapItr lru = _entries.end();
+            for( EntryMapItr itr = _entries.begin(); itr != _entries.end(); ++itr )
+            {
+                Entry& entry = (*itr).second;
+                if( entry._device != device || entry._lastUse >= _launchTick ||
+                    entry._memory.get() == &memory || skipped.find( (*itr).first ) != skipped.end() )
+                    continue;
+
+                if( lru == _entries.end() || entry._lastUse < (*lru).second._lastUse )
+                    lru = itr;
+            }
+
+            if( lru == _entries.end() )
+            {
+                osg::notify(osg::WARN)
+                    << __FUNCTION__ << " " << memory.getName() << ": cannot evict enough memory from device " 
+                    << device << " to allocate " << byteSize << " bytes."
+                    << std::endl;
+
+                return false;
+            }
+
+            MemoryObject* object = (*lru).first;
+            size_t evictedByteSize = (*lru).second._byteSize;
+            osg::ref_ptr<Memory> victim = (*lru).second._memory.get();
+            if( !victim.valid() || !victim->evict() )
+            {
+                skipped.insert( object );
+                continue;
+            }
+
+            // Memory must have been released during evict()
+            if( _entries.find( object ) != _entries.end() )
+                release( *object );
+
+            ++_numEvictions;
+            _evictedByteSize += evictedByteSize;
+        }
+
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    void MemoryBudget::allocated( Memory& memory, MemoryObject& object, size_t byteSize )
+    {
+        EntryMapItr itr = _entries.find( &object );
+        if( itr == _entries.end() )
+        {
+            if( object._numEvictions != 0 )
+                ++_numRestores;
+
+            Entry entry;
+            entry._memory = &memory;
+            entry._device = Device::getCurrentIdx();
+            entry._byteSize = 0;
+            entry._lastUse = ++_tick;
+            itr = _entries.insert( std::make_pair( &object, entry ) ).first;
+        }
+
+        (*itr).second._byteSize += byteSize;
+        _devices[(*itr).second._device]._usage += byteSize;
+    }
+
+    //------------------------------------------------------------------------------
+    void MemoryBudget::update( Memory& memory, MemoryObject& object, size_t byteSize )
+    {
+        if( byteSize == 0 )
+        {
+            release( object );
+            return;
+        }
+
+        EntryMapItr itr = _entries.find( &object );
+        if( itr == _entries.end() )
+        {
+            allocated( memory, object, byteSize );
+            return;
+        }
+
+        DeviceBudget& budget = _devices[(*itr).second._device];
+        budget._usage -= (*itr).second._byteSize;
+        budget._usage += byteSize;
+        (*itr).second._byteSize = byteSize;
+        (*itr).second._lastUse = ++_tick;
+    }
+
+    //------------------------------------------------------------------------------
+    void MemoryBudget::release( MemoryObject& object )
+    {
+        EntryMapItr itr = _entries.find( &object );
+        if( itr == _entries.end() )
+            return;
+
+        _devices[(*itr).second._device]._usage -= (*itr).second._byteSize;
+        _entries.erase( itr );
+    }
+
+    //------------------------------------------------------------------------------
+    void MemoryBudget::touch( MemoryObject& object )
+    {
+        EntryMapItr itr = _entries.find( &object );
+        if( itr != _entries.end() )
+            (*itr).second._lastUse = ++_tick;
+    }
+
+    //------------------------------------------------------------------------------
+    void MemoryBudget::beginLaunch()
+    {
+        _launchTick = _tick + 1;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PROTECTED FUNCTIONS //////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    MemoryBudget::MemoryBudget()
+        : osg::Referenced(),
+          _tick( 0 ),
+          _launchTick( UINT_MAX ),
+          _numEvictions( 0 ),
+          _evictedByteSize( 0 ),
+          _numRestores( 0 )
+    {
+    }
+}
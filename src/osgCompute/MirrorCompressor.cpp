@@ -0,0 +1,359 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+
+#include <vector>
+#include <memory.h>
+#include <osgCompute/MirrorCompressor>
+
+namespace osgCompute
+{
+    osg::ref_ptr<MirrorCompressor> MirrorCompressor::s_mirrorCompressor = NULL;
+
+    // Parameters of the LZ4 block format
+    static const size_t LZ4_MIN_MATCH = 4;
+    static const size_t LZ4_LAST_LITERALS = 5;
+    static const size_t LZ4_MF_LIMIT = 12;
+    static const size_t LZ4_MAX_OFFSET = 65535;
+    static const unsigned int LZ4_HASH_LOG = 12;
+
+    //------------------------------------------------------------------------------
+    static inline unsigned int lz4Read32( const unsigned char* ptr )
+    {
+        unsigned int value;
+        memcpy( &value, ptr, sizeof(unsigned int) );
+        return value;
+    }
+
+    //------------------------------------------------------------------------------
+    static inline unsigned int lz4Hash( unsigned int value )
+    {
+        return (value * 2654435761U) >> (32 - LZ4_HASH_LOG);
+    }
+
+    //------------------------------------------------------------------------------
+    static inline unsigned char* lz4WriteLength( unsigned char* op, size_t length )
+    {
+        // Lengths of 15 and more continue with
+        // bytes of 255 and a final remainder
+        for( ; length >= 255; length -= 255 )
+            *op++ = 255;
+
+        *op++ = static_cast<unsigned char>( length );
+        return op;
+    }
+
+    //------------------------------------------------------------------------------
+    static inline bool lz4ReadLength( const unsigned char*& ip, const unsigned char* iend, size_t& length )
+    {
+        unsigned char byte;
+        do
+        {
+            if( ip >= iend )
+                return false;
+
+            byte = *ip++;
+            length += byte;
+        }
+        while( byte == 255 );
+
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    static unsigned char* lz4WriteSequence( unsigned char* op, const unsigned char* anchor, size_t numLiterals, size_t offset, size_t matchLength )
+    {
+        unsigned char* token = op++;
+        *token = static_cast<unsigned char>( ((numLiterals < 15)? numLiterals : 15) << 4 );
+        if( numLiterals >= 15 )
+            op = lz4WriteLength( op, numLiterals - 15 );
+
+        memcpy( op, anchor, numLiterals );
+        op += numLiterals;
+
+        // The last sequence consists of literals only
+        if( offset == 0 )
+            return op;
+
+        *op++ = static_cast<unsigned char>( offset & 0xFF );
+        *op++ = static_cast<unsigned char>( offset >> 8 );
+
+        matchLength -= LZ4_MIN_MATCH;
+        *token |= static_cast<unsigned char>( (matchLength < 15)? matchLength : 15 );
+        if( matchLength >= 15 )
+            op = lz4WriteLength( op, matchLength - 15 );
+
+        return op;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    MirrorCompressor* MirrorCompressor::instance()
+    {
+        if( !s_mirrorCompressor.valid() )
+            s_mirrorCompressor = new MirrorCompressor;
+
+        return s_mirrorCompressor.get();
+    }
+
+    //------------------------------------------------------------------------------
+    void MirrorCompressor::setIdleFrames( unsigned int idleFrames )
+    {
+        _idleFrames = idleFrames;
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int MirrorCompressor::getIdleFrames() const
+    {
+        return _idleFrames;
+    }
+
+    //------------------------------------------------------------------------------
+    size_t MirrorCompressor::getCompressedByteSize() const
+    {
+        size_t byteSize = 0;
+        for( EntryMapCnstItr itr = _entries.begin(); itr != _entries.end(); ++itr )
+        {
+            osg::ref_ptr<Memory> memory = (*itr).second._memory.get();
+            if( memory.valid() )
+                byteSize += memory->getCompressedByteSize();
+        }
+
+        return byteSize;
+    }
+
+    //------------------------------------------------------------------------------
+    size_t MirrorCompressor::getUncompressedByteSize() const
+    {
+        size_t byteSize = 0;
+        for( EntryMapCnstItr itr = _entries.begin(); itr != _entries.end(); ++itr )
+        {
+            osg::ref_ptr<Memory> memory = (*itr).second._memory.get();
+            if( memory.valid() && memory->getCompressedByteSize() != 0 )
+                byteSize += memory->getByteSize( MAP_HOST );
+        }
+
+        return byteSize;
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int MirrorCompressor::getNumCompressions() const
+    {
+        return _numCompressions;
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int MirrorCompressor::getNumDecompressions() const
+    {
+        return _numDecompressions;
+    }
+
+    //------------------------------------------------------------------------------
+    void MirrorCompressor::resetCounters()
+    {
+        _numCompressions = 0;
+        _numDecompressions = 0;
+    }
+
+    //------------------------------------------------------------------------------
+    void MirrorCompressor::frame( unsigned int frameNumber )
+    {
+        if( _frameValid && frameNumber == _frameNumber )
+            return;
+
+        _frameNumber = frameNumber;
+        _frameValid = true;
+
+        EntryMapItr itr = _entries.begin();
+        while( itr != _entries.end() )
+        {
+            Entry& entry = (*itr).second;
+            osg::ref_ptr<Memory> memory = entry._memory.get();
+            if( !memory.valid() )
+            {
+                _entries.erase( itr++ );
+                continue;
+            }
+
+            if( _idleFrames != 0 && memory->getCompressedByteSize() == 0 && 
+                _frameNumber - entry._lastUse >= _idleFrames )
+            {
+                if( memory->compress() )
+                    ++_numCompressions;
+
+                // Memory which does not compress
+                // is checked again after idle frames
+                entry._lastUse = _frameNumber;
+            }
+
+            ++itr;
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    void MirrorCompressor::touch( Memory& memory )
+    {
+        Entry& entry = _entries[&memory];
+        if( entry._memory.get() != &memory )
+            entry._memory = &memory;
+
+        entry._lastUse = _frameNumber;
+    }
+
+    //------------------------------------------------------------------------------
+    void MirrorCompressor::restored( Memory& memory )
+    {
+        ++_numDecompressions;
+        touch( memory );
+    }
+
+    //------------------------------------------------------------------------------
+    size_t MirrorCompressor::compressBound( size_t byteSize )
+    {
+        return byteSize + byteSize/255 + 16;
+    }
+
+    //------------------------------------------------------------------------------
+    size_t MirrorCompressor::compress( const void* src, size_t srcSize, void* dst, size_t dstCapacity )
+    {
+        if( dstCapacity < compressBound( srcSize ) )
+            return 0;
+
+        const unsigned char* base = static_cast<const unsigned char*>( src );
+        const unsigned char* ip = base;
+        const unsigned char* anchor = base;
+        const unsigned char* iend = base + srcSize;
+        unsigned char* op = static_cast<unsigned char*>( dst );
+
+        if( srcSize > LZ4_MF_LIMIT )
+        {
+            // Matches must not start within the last 12 bytes
+            // and must not cover the last 5 bytes of the block
+            const unsigned char* mflimit = iend - LZ4_MF_LIMIT;
+            const unsigned char* matchlimit = iend - LZ4_LAST_LITERALS;
+            std::vector<const unsigned char*> table( 1 << LZ4_HASH_LOG, static_cast<const unsigned char*>(NULL) );
+
+            while( ip <= mflimit )
+            {
+                unsigned int sequence = lz4Read32( ip );
+                const unsigned char*& slot = table[ lz4Hash( sequence ) ];
+                const unsigned char* ref = slot;
+                slot = ip;
+
+                if( ref == NULL || static_cast<size_t>(ip - ref) > LZ4_MAX_OFFSET || lz4Read32( ref ) != sequence )
+                {
+                    ++ip;
+                    continue;
+                }
+
+                // Extend the match in both directions
+                while( ip > anchor && ref > base && ip[-1] == ref[-1] )
+                {
+                    --ip;
+                    --ref;
+                }
+
+                const unsigned char* matchEnd = ip + LZ4_MIN_MATCH;
+                const unsigned char* refEnd = ref + LZ4_MIN_MATCH;
+                while( matchEnd < matchlimit && *matchEnd == *refEnd )
+                {
+                    ++matchEnd;
+                    ++refEnd;
+                }
+
+                op = lz4WriteSequence( op, anchor, ip - anchor, ip - ref, matchEnd - ip );
+                ip = matchEnd;
+                anchor = ip;
+            }
+        }
+
+        op = lz4WriteSequence( op, anchor, iend - anchor, 0, 0 );
+        return op - static_cast<unsigned char*>( dst );
+    }
+
+    //------------------------------------------------------------------------------
+    bool MirrorCompressor::decompress( const void* src, size_t srcSize, void* dst, size_t dstSize )
+    {
+        const unsigned char* ip = static_cast<const unsigned char*>( src );
+        const unsigned char* iend = ip + srcSize;
+        unsigned char* base = static_cast<unsigned char*>( dst );
+        unsigned char* op = base;
+        unsigned char* oend = base + dstSize;
+
+        while( ip < iend )
+        {
+            unsigned char token = *ip++;
+
+            //////////////
+            // LITERALS //
+            //////////////
+            size_t numLiterals = token >> 4;
+            if( numLiterals == 15 && !lz4ReadLength( ip, iend, numLiterals ) )
+                return false;
+
+            if( numLiterals > static_cast<size_t>(iend - ip) || numLiterals > static_cast<size_t>(oend - op) )
+                return false;
+
+            memcpy( op, ip, numLiterals );
+            ip += numLiterals;
+            op += numLiterals;
+
+            // The last sequence ends after the literals
+            if( ip == iend )
+                break;
+
+            ///////////
+            // MATCH //
+            ///////////
+            if( iend - ip < 2 )
+                return false;
+
+            size_t offset = ip[0] | (ip[1] << 8);
+            ip += 2;
+            if( offset == 0 || offset > static_cast<size_t>(op - base) )
+                return false;
+
+            size_t matchLength = token & 0xF;
+            if( matchLength == 15 && !lz4ReadLength( ip, iend, matchLength ) )
+                return false;
+
+            matchLength += LZ4_MIN_MATCH;
+            if( matchLength > static_cast<size_t>(oend - op) )
+                return false;
+
+            // Matches might overlap the output
+            const unsigned char* ref = op - offset;
+            for( size_t b=0; b<matchLength; ++b )
+                *op++ = *ref++;
+        }
+
+        return (op == oend);
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PROTECTED FUNCTIONS //////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    MirrorCompressor::MirrorCompressor()
+        : osg::Referenced(),
+          _idleFrames( 0 ),
+          _frameNumber( 0 ),
+          _frameValid( false ),
+          _numCompressions( 0 ),
+          _numDecompressions( 0 )
+    {
+    }
+}
@@ -0,0 +1,206 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+
+
+#include <OpenThreads/ScopedLock>
+#include <osgCompute/Payload>
+
+namespace osgCompute
+{
+    class PayloadThread : public OpenThreads::Thread
+    {
+    public:
+        PayloadThread( PayloadLoader& loader ) 
+            : OpenThreads::Thread(), _loader( loader ) {}
+
+        virtual void run()
+        {
+            osg::ref_ptr<Payload> payload;
+            while( (payload = _loader.next()).valid() )
+            {
+                payload->decode();
+                _loader.finished();
+            }
+        }
+
+    protected:
+        PayloadLoader&      _loader;
+    };
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    Payload::Payload()
+        : osg::Referenced(),
+          _decoded( false ),
+          _valid( false )
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    bool Payload::decode()
+    {
+        // Concurrent callers wait until the first one has finished
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock( _mutex );
+        if( !_decoded )
+        {
+            _valid = decodeImplementation();
+            _decoded = true;
+        }
+
+        return _valid;
+    }
+
+    //------------------------------------------------------------------------------
+    bool Payload::isDecoded() const
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock( _mutex );
+        return _decoded;
+    }
+
+    //------------------------------------------------------------------------------
+    PayloadLoader* PayloadLoader::instance()
+    {
+        static osg::ref_ptr<PayloadLoader> s_payloadLoader = new PayloadLoader;
+        return s_payloadLoader.get();
+    }
+
+    //------------------------------------------------------------------------------
+    void PayloadLoader::setNumThreads( unsigned int numThreads )
+    {
+        stop();
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock( _mutex );
+        _numThreads = numThreads;
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int PayloadLoader::getNumThreads() const
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock( _mutex );
+        return _numThreads;
+    }
+
+    //------------------------------------------------------------------------------
+    void PayloadLoader::submit( Payload& payload )
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock( _mutex );
+        if( _numThreads == 0 )
+            return;
+
+        if( _threads.empty() )
+        {
+            _done = false;
+            for( unsigned int t=0; t<_numThreads; ++t )
+            {
+                PayloadThread* thread = new PayloadThread( *this );
+                thread->start();
+                _threads.push_back( thread );
+            }
+        }
+
+        _queue.push_back( &payload );
+        ++_numPending;
+        _queueCondition.signal();
+    }
+
+    //------------------------------------------------------------------------------
+    void PayloadLoader::wait()
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock( _mutex );
+        while( _numPending > 0 && !_threads.empty() )
+            _finishedCondition.wait( &_mutex );
+    }
+
+    //------------------------------------------------------------------------------
+    void PayloadLoader::stop()
+    {
+        std::vector< PayloadThread* > threads;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock( _mutex );
+            _done = true;
+            threads.swap( _threads );
+            _queueCondition.broadcast();
+        }
+
+        for( std::vector< PayloadThread* >::iterator itr = threads.begin(); itr != threads.end(); ++itr )
+        {
+            (*itr)->join();
+            delete (*itr);
+        }
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock( _mutex );
+        _queue.clear();
+        _numPending = 0;
+        _finishedCondition.broadcast();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PROTECTED FUNCTIONS //////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    PayloadLoader::PayloadLoader()
+        : osg::Referenced(),
+          _numThreads( static_cast<unsigned int>( OpenThreads::GetNumberOfProcessors() ) ),
+          _numPending( 0 ),
+          _done( false )
+    {
+        if( _numThreads == 0 )
+            _numThreads = 1;
+    }
+
+    //------------------------------------------------------------------------------
+    PayloadLoader::~PayloadLoader()
+    {
+        stop();
+    }
+
+    //------------------------------------------------------------------------------
+    osg::ref_ptr<Payload> PayloadLoader::next()
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock( _mutex );
+        while( !_done )
+        {
+            if( _queue.empty() )
+            {
+                _queueCondition.wait( &_mutex );
+                continue;
+            }
+
+            osg::ref_ptr<Payload> payload = _queue.front();
+            _queue.pop_front();
+
+            // Skip payloads which are not referenced by a memory object 
+            // anymore, i.e. which have been applied or released already
+            if( payload->referenceCount() > 1 )
+                return payload;
+
+            --_numPending;
+            _finishedCondition.broadcast();
+        }
+
+        return NULL;
+    }
+
+    //------------------------------------------------------------------------------
+    void PayloadLoader::finished()
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock( _mutex );
+        if( _numPending > 0 )
+            --_numPending;
+        _finishedCondition.broadcast();
+    }
+}
@@ -13,30 +13,150 @@
 * The full license is in LICENSE file included with this distribution.
 */
 
+#include <map>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/ScopedLock>
 #include <osgDB/Registry>
 #include <osgDB/FileUtils>
 #include <osgCompute/Program>
 
 namespace osgCompute
 {   
+    struct ProgramFactory
+    {
+        ProgramFactory() : _createProgramFunc(NULL), _static(false) {}
+
+        OSGCOMPUTE_CREATE_PROGRAM_FUNCTION_PTR  _createProgramFunc;
+        // keeps dynamic libraries loaded as long as the factory is cached
+        osg::ref_ptr<osgDB::DynamicLibrary>     _library;
+        bool                                    _static;
+    };
+
+    typedef std::map< std::string, ProgramFactory >                 ProgramFactoryMap;
+    typedef std::map< std::string, ProgramFactory >::iterator       ProgramFactoryMapItr;
+    typedef std::map< std::string, std::string >                    LibraryPathMap;
+    typedef std::map< std::string, std::string >::iterator          LibraryPathMapItr;
+
+    // Function local statics are valid during static initialization
+    // of other translation units (see OSGCOMPUTE_REGISTER_PROGRAM)
+    static ProgramFactoryMap& getProgramFactories()
+    {
+        static ProgramFactoryMap s_factories;
+        return s_factories;
+    }
+
+    static LibraryPathMap& getLibraryPaths()
+    {
+        static LibraryPathMap s_paths;
+        return s_paths;
+    }
+
+    static OpenThreads::Mutex& getProgramMutex()
+    {
+        static OpenThreads::Mutex s_mutex;
+        return s_mutex;
+    }
+
 	/////////////////////////////////////////////////////////////////////////////////////////////////
 	// STATIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
 	/////////////////////////////////////////////////////////////////////////////////////////////////
 	//------------------------------------------------------------------------------
 	bool Program::existsProgram( const std::string& libraryName )
 	{
+		{
+			OpenThreads::ScopedLock<OpenThreads::Mutex> lock( getProgramMutex() );
+			if( getProgramFactories().find( libraryName ) != getProgramFactories().end() ||
+				getLibraryPaths().find( libraryName ) != getLibraryPaths().end() )
+				return true;
+		}
+
+		// Search without the lock so that several 
+		// libraries can be searched in parallel
 		std::string curLibraryName = osgDB::Registry::instance()->createLibraryNameForNodeKit( libraryName );
 		std::string fullPath = osgDB::findLibraryFile( curLibraryName );
 		if( fullPath.empty() )
 			return false;
 
+		// Only successful searches are cached as the
+		// library might be installed later on
+		OpenThreads::ScopedLock<OpenThreads::Mutex> lock( getProgramMutex() );
+		getLibraryPaths()[libraryName] = fullPath;
 		return true;
 	}
 
+	//------------------------------------------------------------------------------
+	void Program::registerProgram( const std::string& libraryName, OSGCOMPUTE_CREATE_PROGRAM_FUNCTION_PTR createProgramFunc )
+	{
+		if( libraryName.empty() || createProgramFunc == NULL )
+			return;
+
+		OpenThreads::ScopedLock<OpenThreads::Mutex> lock( getProgramMutex() );
+		ProgramFactory& factory = getProgramFactories()[libraryName];
+		factory._createProgramFunc = createProgramFunc;
+		factory._library = NULL;
+		factory._static = true;
+	}
+
+	//------------------------------------------------------------------------------
+	void Program::unregisterProgram( const std::string& libraryName )
+	{
+		OpenThreads::ScopedLock<OpenThreads::Mutex> lock( getProgramMutex() );
+		getProgramFactories().erase( libraryName );
+		getLibraryPaths().erase( libraryName );
+	}
+
+	//------------------------------------------------------------------------------
+	void Program::clearProgramCache()
+	{
+		OpenThreads::ScopedLock<OpenThreads::Mutex> lock( getProgramMutex() );
+		getLibraryPaths().clear();
+
+		ProgramFactoryMapItr itr = getProgramFactories().begin();
+		while( itr != getProgramFactories().end() )
+		{
+			if( !(*itr).second._static )
+				getProgramFactories().erase( itr++ );
+			else
+				++itr;
+		}
+	}
+
 	//------------------------------------------------------------------------------
 	Program* Program::loadProgram( const std::string& libraryName )
 	{
-		std::string curLibraryName = osgDB::Registry::instance()->createLibraryNameForNodeKit( libraryName );
+		// Registered and previously loaded programs are
+		// created without any file system access
+		OSGCOMPUTE_CREATE_PROGRAM_FUNCTION_PTR registeredFunc = NULL;
+		{
+			OpenThreads::ScopedLock<OpenThreads::Mutex> lock( getProgramMutex() );
+			ProgramFactoryMapItr itr = getProgramFactories().find( libraryName );
+			if( itr != getProgramFactories().end() )
+				registeredFunc = (*itr).second._createProgramFunc;
+		}
+
+		if( registeredFunc != NULL )
+		{
+			Program* registeredProgram = (*registeredFunc)();
+			if( registeredProgram && registeredProgram->getLibraryName().empty() )
+			{
+				registeredProgram->setLibraryName( libraryName );
+				registeredProgram->addIdentifier( libraryName );
+			}
+
+			return registeredProgram;
+		}
+
+		// Paths found by existsProgram() are loaded without another search
+		std::string curLibraryName;
+		{
+			OpenThreads::ScopedLock<OpenThreads::Mutex> lock( getProgramMutex() );
+			LibraryPathMapItr itr = getLibraryPaths().find( libraryName );
+			if( itr != getLibraryPaths().end() )
+				curLibraryName = (*itr).second;
+		}
+
+		if( curLibraryName.empty() )
+			curLibraryName = osgDB::Registry::instance()->createLibraryNameForNodeKit( libraryName );
 		
 		if( osgDB::Registry::instance()->loadLibrary( curLibraryName ) ==  osgDB::Registry::NOT_LOADED )
 		{
@@ -68,6 +188,17 @@ namespace osgCompute
 			return NULL;
 		}
 
+		{
+			OpenThreads::ScopedLock<OpenThreads::Mutex> lock( getProgramMutex() );
+			// The library might have registered itself during the load
+			// (see OSGCOMPUTE_REGISTER_PROGRAM). Such a factory is only 
+			// valid as long as the library is loaded.
+			ProgramFactory& factory = getProgramFactories()[libraryName];
+			factory._createProgramFunc = createProgramFunc;
+			factory._library = programLibrary;
+			factory._static = false;
+		}
+
 		Program* loadedProgram = (*createProgramFunc)();
 		if( loadedProgram && loadedProgram->getLibraryName().empty() )
         {
@@ -138,6 +269,11 @@ namespace osgCompute
     {
     }
 
+    //------------------------------------------------------------------------------
+    void Program::acceptParameters( osg::Referenced& params )
+    {
+    }
+
     //------------------------------------------------------------------------------
     bool Program::usesResource( const std::string& handle ) const 
     { 
@@ -0,0 +1,167 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*                                                                     
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*                                                                     
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of 
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+
+#include <vector>
+#include <algorithm>
+#include <osg/NodeVisitor>
+#include <osgCompute/Runner>
+
+namespace osgCompute
+{
+    typedef std::pair< int, Computation* >                  RenderComputation;
+    typedef std::vector< RenderComputation >                RenderComputationList;
+    typedef std::vector< RenderComputation >::iterator      RenderComputationListItr;
+
+    static bool lessComputeOrderNum( const RenderComputation& lhs, const RenderComputation& rhs )
+    {
+        return lhs.first < rhs.first;
+    }
+
+    //! Collects computations which are executed during rendering
+    class RenderComputationCollector : public osg::NodeVisitor
+    {
+    public:
+        RenderComputationCollector()
+            : osg::NodeVisitor( osg::NodeVisitor::TRAVERSE_ACTIVE_CHILDREN ) {}
+
+        virtual void apply( osg::Group& group )
+        {
+            Computation* computation = dynamic_cast<Computation*>( &group );
+            if( computation != NULL )
+            {
+                unsigned int computeOrder = computation->getComputeOrder();
+                if( computation->isEnabled() && (computeOrder & OSGCOMPUTE_RENDER) == OSGCOMPUTE_RENDER )
+                {
+                    if( (computeOrder & OSGCOMPUTE_POSTRENDER) == OSGCOMPUTE_POSTRENDER )
+                        _postRender.push_back( RenderComputation( computation->getComputeOrderNum(), computation ) );
+                    else
+                        _preRender.push_back( RenderComputation( computation->getComputeOrderNum(), computation ) );
+                }
+                else if( (computeOrder & OSGCOMPUTE_NORENDER) == OSGCOMPUTE_NORENDER )
+                {
+                    // Children are not rendered
+                    return;
+                }
+            }
+
+            traverse( group );
+        }
+
+        RenderComputationList _preRender;
+        RenderComputationList _postRender;
+    };
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    Runner::Runner()
+        : osg::Referenced()
+    {
+        _frameStamp = new osg::FrameStamp;
+        _frameStamp->setFrameNumber( 0 );
+        _frameStamp->setReferenceTime( 0.0 );
+        _frameStamp->setSimulationTime( 0.0 );
+
+        _updateVisitor = new osgUtil::UpdateVisitor;
+        _updateVisitor->setFrameStamp( _frameStamp.get() );
+
+        _startTick = osg::Timer::instance()->tick();
+    }
+
+    //------------------------------------------------------------------------------
+    void Runner::setSceneData( osg::Node* node )
+    {
+        _sceneData = node;
+    }
+
+    //------------------------------------------------------------------------------
+    osg::Node* Runner::getSceneData()
+    {
+        return _sceneData.get();
+    }
+
+    //------------------------------------------------------------------------------
+    const osg::Node* Runner::getSceneData() const
+    {
+        return _sceneData.get();
+    }
+
+    //------------------------------------------------------------------------------
+    void Runner::frame()
+    {
+        if( !_sceneData.valid() )
+            return;
+
+        Computation::setHeadless( true );
+
+        // Advance frame
+        double referenceTime = osg::Timer::instance()->delta_s( _startTick, osg::Timer::instance()->tick() );
+        _frameStamp->setFrameNumber( _frameStamp->getFrameNumber() + 1 );
+        _frameStamp->setReferenceTime( referenceTime );
+        _frameStamp->setSimulationTime( referenceTime );
+
+        // Update traversal launches all UPDATE computations
+        _updateVisitor->reset();
+        _updateVisitor->setFrameStamp( _frameStamp.get() );
+        _updateVisitor->setTraversalNumber( _frameStamp->getFrameNumber() );
+        _sceneData->accept( *_updateVisitor );
+
+        // There is no rendering. Launch
+        // PRE_RENDER and POST_RENDER computations directly
+        launchRenderComputations();
+    }
+
+    //------------------------------------------------------------------------------
+    void Runner::run( unsigned int numFrames )
+    {
+        for( unsigned int f=0; f<numFrames; ++f )
+            frame();
+    }
+
+    //------------------------------------------------------------------------------
+    osg::FrameStamp* Runner::getFrameStamp()
+    {
+        return _frameStamp.get();
+    }
+
+    //------------------------------------------------------------------------------
+    const osg::FrameStamp* Runner::getFrameStamp() const
+    {
+        return _frameStamp.get();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PROTECTED FUNCTIONS //////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    void Runner::launchRenderComputations()
+    {
+        RenderComputationCollector collector;
+        collector.setTraversalNumber( _frameStamp->getFrameNumber() );
+        _sceneData->accept( collector );
+
+        // Keep the traversal order for computations
+        // with the same compute order number
+        std::stable_sort( collector._preRender.begin(), collector._preRender.end(), lessComputeOrderNum );
+        std::stable_sort( collector._postRender.begin(), collector._postRender.end(), lessComputeOrderNum );
+
+        for( RenderComputationListItr itr = collector._preRender.begin(); itr != collector._preRender.end(); ++itr )
+            (*itr).second->launch();
+
+        for( RenderComputationListItr itr = collector._postRender.begin(); itr != collector._postRender.end(); ++itr )
+            (*itr).second->launch();
+    }
+}
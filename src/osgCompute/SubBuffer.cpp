@@ -0,0 +1,321 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+
+#include <osg/Notify>
+#include <osgCompute/SubBuffer>
+
+namespace osgCompute
+{   
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    SubBuffer::SubBuffer()
+        : Memory()
+    {
+        clearLocal();
+        // Please note that virtual functions className() and libraryName() are called
+        // during observeResource() which will only develop until this class.
+        // However if contructor of a subclass calls this function again observeResource
+        // will change the className and libraryName of the observed pointer.
+        ResourceObserver::instance()->observeResource( *this );
+    }
+
+    //------------------------------------------------------------------------------
+    void SubBuffer::setParent( Memory* parent )
+    {
+        // Reference the memory of a sub-buffer directly
+        SubBuffer* parentSubBuffer = dynamic_cast<SubBuffer*>( parent );
+        if( parentSubBuffer != NULL )
+        {
+            for( unsigned int d=0; d<3; ++d )
+                _parentOrigin[d] = parentSubBuffer->_parentOrigin[d] + parentSubBuffer->getOrigin(d);
+
+            parent = parentSubBuffer->getParent();
+        }
+        else
+        {
+            for( unsigned int d=0; d<3; ++d )
+                _parentOrigin[d] = 0;
+        }
+
+        _parent = parent;
+    }
+
+    //------------------------------------------------------------------------------
+    Memory* SubBuffer::getParent()
+    {
+        return _parent.get();
+    }
+
+    //------------------------------------------------------------------------------
+    const Memory* SubBuffer::getParent() const
+    {
+        return _parent.get();
+    }
+
+    //------------------------------------------------------------------------------
+    void SubBuffer::setOrigin( unsigned int x, unsigned int y /*= 0*/, unsigned int z /*= 0*/ )
+    {
+        _origin[0] = x;
+        _origin[1] = y;
+        _origin[2] = z;
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int SubBuffer::getOrigin( unsigned int dimIdx ) const
+    {
+        if( dimIdx >= 3 )
+            return 0;
+
+        return _origin[dimIdx];
+    }
+
+    //------------------------------------------------------------------------------
+    size_t SubBuffer::getByteOffset( unsigned int mapping ) const
+    {
+        if( !_parent.valid() )
+            return 0;
+
+        return size_t(_parentOrigin[2] + _origin[2]) * getSlicePitch( mapping ) +
+               size_t(_parentOrigin[1] + _origin[1]) * getRowPitch( mapping ) +
+               size_t(_parentOrigin[0] + _origin[0]) * getMappedElementSize( mapping );
+    }
+
+    //------------------------------------------------------------------------------
+    size_t SubBuffer::getRowPitch( unsigned int mapping ) const
+    {
+        if( !_parent.valid() )
+            return 0;
+
+        // Host memory is not padded
+        if( (mapping & MAP_HOST) == mapping )
+            return size_t(_parent->getElementSize()) * _parent->getDimension(0);
+        else
+            return _parent->getPitch();
+    }
+
+    //------------------------------------------------------------------------------
+    size_t SubBuffer::getSlicePitch( unsigned int mapping ) const
+    {
+        if( !_parent.valid() )
+            return 0;
+
+        size_t rows = (_parent->getNumDimensions() > 1)? _parent->getDimension(1) : 1;
+        return rows * getRowPitch( mapping );
+    }
+
+    //------------------------------------------------------------------------------
+    bool SubBuffer::isValid() const
+    {
+        if( !_parent.valid() || getNumDimensions() == 0 || _parent->getElementSize() == 0 )
+            return false;
+
+        if( getNumDimensions() > _parent->getNumDimensions() || getNumDimensions() > 3 )
+            return false;
+
+        for( unsigned int d=0; d<3; ++d )
+        {
+            size_t extent = (d < getNumDimensions())? getDimension(d) : 1;
+            size_t parentExtent = (d < _parent->getNumDimensions())? _parent->getDimension(d) : 1;
+            if( size_t(_parentOrigin[d]) + _origin[d] + extent > parentExtent )
+                return false;
+        }
+
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    void* SubBuffer::map( unsigned int mapping/* = MAP_DEVICE*/, size_t offset/* = 0*/, unsigned int hint/* = 0*/ )
+    {
+        if( mapping == UNMAP )
+        {
+            unmap( hint );
+            return NULL;
+        }
+
+        if( !supportsMapping( mapping, hint ) )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << " " << getName() << ": mapping is not supported by sub-buffers."
+                << std::endl;
+
+            return NULL;
+        }
+
+        if( !isValid() )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << " " << getName() << ": sub-buffer does not fit into its parent."
+                << std::endl;
+
+            return NULL;
+        }
+
+        return _parent->map( mapping, getByteOffset(mapping) + offset, hint );
+    }
+
+    //------------------------------------------------------------------------------
+    void SubBuffer::unmap( unsigned int hint/* = 0*/ )
+    {
+        if( _parent.valid() )
+            _parent->unmap( hint );
+    }
+
+    //------------------------------------------------------------------------------
+    bool SubBuffer::reset( unsigned int hint/* = 0*/ )
+    {
+        // The state of the memory is shared 
+        // with the parent and all other sub-buffers
+        if( !_parent.valid() )
+            return false;
+
+        return _parent->reset( hint );
+    }
+
+    //------------------------------------------------------------------------------
+    bool SubBuffer::supportsMapping( unsigned int mapping, unsigned int hint/* = 0*/ ) const
+    {
+        if( !_parent.valid() )
+            return false;
+
+        // Arrays cannot be addressed partially
+        if( (mapping & MAP_DEVICE_ARRAY) == MAP_DEVICE_ARRAY )
+            return false;
+
+        return _parent->supportsMapping( mapping, hint );
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int SubBuffer::getMapping( unsigned int hint/* = 0*/ ) const
+    {
+        if( !_parent.valid() )
+            return UNMAP;
+
+        return _parent->getMapping( hint );
+    }
+
+    //------------------------------------------------------------------------------
+    size_t SubBuffer::getPitch( unsigned int hint/* = 0*/ ) const
+    {
+        if( !_parent.valid() )
+            return 0;
+
+        return _parent->getPitch( hint );
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int SubBuffer::getElementSize() const
+    {
+        if( !_parent.valid() )
+            return Memory::getElementSize();
+
+        return _parent->getElementSize();
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int SubBuffer::getStorageElementSize() const
+    {
+        if( !_parent.valid() )
+            return Memory::getStorageElementSize();
+
+        return _parent->getStorageElementSize();
+    }
+
+    //------------------------------------------------------------------------------
+    size_t SubBuffer::getAllocatedByteSize( unsigned int, unsigned int ) const
+    {
+        // Memory is allocated by the parent only
+        return 0;
+    }
+
+    //------------------------------------------------------------------------------
+    size_t SubBuffer::getByteSize( unsigned int mapping, unsigned int ) const
+    {
+        if( !isValid() || !supportsMapping( mapping ) )
+            return 0;
+
+        // Bytes from the first to the last element
+        size_t width = getDimension(0);
+        size_t height = (getNumDimensions() > 1)? getDimension(1) : 1;
+        size_t depth = (getNumDimensions() > 2)? getDimension(2) : 1;
+
+        return (depth - 1) * getSlicePitch( mapping ) + 
+               (height - 1) * getRowPitch( mapping ) +
+               width * getMappedElementSize( mapping );
+    }
+
+    //------------------------------------------------------------------------------
+    void SubBuffer::clear()
+    {
+        clearLocal();
+        Memory::clear();
+    }
+
+    //------------------------------------------------------------------------------
+    void SubBuffer::releaseObjects()
+    {
+        // Do not release the parent as other 
+        // resources might still reference it
+        Memory::releaseObjects();
+    }
+
+    //------------------------------------------------------------------------------
+    bool SubBuffer::objectsReleased() const
+    {
+        if( !_parent.valid() )
+            return true;
+
+        return _parent->objectsReleased();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PROTECTED FUNCTIONS //////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    SubBuffer::~SubBuffer()
+    {
+        clearLocal();
+    }
+
+    //------------------------------------------------------------------------------
+    void SubBuffer::clearLocal()
+    {
+        _parent = NULL;
+        _origin[0] = 0;
+        _origin[1] = 0;
+        _origin[2] = 0;
+        _parentOrigin[0] = 0;
+        _parentOrigin[1] = 0;
+        _parentOrigin[2] = 0;
+    }
+
+    //------------------------------------------------------------------------------
+    size_t SubBuffer::computePitch() const
+    {
+        return getPitch();
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int SubBuffer::getMappedElementSize( unsigned int mapping ) const
+    {
+        // Host memory keeps the elements as they are whereas 
+        // device memory might store them in a compact format
+        if( (mapping & MAP_HOST) == mapping )
+            return getElementSize();
+        else
+            return getStorageElementSize();
+    }
+}
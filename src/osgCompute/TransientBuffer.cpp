@@ -0,0 +1,210 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+
+#include <osg/Notify>
+#include <osgCompute/TransientBuffer>
+
+namespace osgCompute
+{   
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    TransientBuffer::TransientBuffer()
+        : Memory()
+    {
+        clearLocal();
+        // Please note that virtual functions className() and libraryName() are called
+        // during observeResource() which will only develop until this class.
+        // However if contructor of a subclass calls this function again observeResource
+        // will change the className and libraryName of the observed pointer.
+        ResourceObserver::instance()->observeResource( *this );
+    }
+
+    //------------------------------------------------------------------------------
+    void TransientBuffer::setStore( Memory* store, size_t offset )
+    {
+        _store = store;
+        _storeOffset = offset;
+    }
+
+    //------------------------------------------------------------------------------
+    Memory* TransientBuffer::getStore()
+    {
+        return _store.get();
+    }
+
+    //------------------------------------------------------------------------------
+    const Memory* TransientBuffer::getStore() const
+    {
+        return _store.get();
+    }
+
+    //------------------------------------------------------------------------------
+    size_t TransientBuffer::getStoreOffset() const
+    {
+        return _storeOffset;
+    }
+
+    //------------------------------------------------------------------------------
+    void* TransientBuffer::map( unsigned int mapping/* = MAP_DEVICE*/, size_t offset/* = 0*/, unsigned int hint/* = 0*/ )
+    {
+        if( mapping == UNMAP )
+        {
+            unmap( hint );
+            return NULL;
+        }
+
+        if( !_store.valid() )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << " " << getName() << ": buffer has not been placed by a computation."
+                << std::endl;
+
+            return NULL;
+        }
+
+        if( !supportsMapping( mapping, hint ) )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << " " << getName() << ": mapping is not supported by transient buffers."
+                << std::endl;
+
+            return NULL;
+        }
+
+        if( _storeOffset + getAllElementsSize() > _store->getByteSize( mapping ) )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << " " << getName() << ": buffer does not fit into its store."
+                << std::endl;
+
+            return NULL;
+        }
+
+        return _store->map( mapping, _storeOffset + offset, hint );
+    }
+
+    //------------------------------------------------------------------------------
+    void TransientBuffer::unmap( unsigned int hint/* = 0*/ )
+    {
+        if( _store.valid() )
+            _store->unmap( hint );
+    }
+
+    //------------------------------------------------------------------------------
+    bool TransientBuffer::reset( unsigned int )
+    {
+        // The content is undefined before 
+        // the first program writes to it
+        return _store.valid();
+    }
+
+    //------------------------------------------------------------------------------
+    bool TransientBuffer::supportsMapping( unsigned int mapping, unsigned int hint/* = 0*/ ) const
+    {
+        if( !_store.valid() )
+            return false;
+
+        // Arrays cannot be addressed partially
+        if( (mapping & MAP_DEVICE_ARRAY) == MAP_DEVICE_ARRAY )
+            return false;
+
+        return _store->supportsMapping( mapping, hint );
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int TransientBuffer::getMapping( unsigned int hint/* = 0*/ ) const
+    {
+        if( !_store.valid() )
+            return UNMAP;
+
+        return _store->getMapping( hint );
+    }
+
+    //------------------------------------------------------------------------------
+    size_t TransientBuffer::getPitch( unsigned int ) const
+    {
+        return computePitch();
+    }
+
+    //------------------------------------------------------------------------------
+    size_t TransientBuffer::getAllocatedByteSize( unsigned int, unsigned int ) const
+    {
+        // Memory is allocated by the store only
+        return 0;
+    }
+
+    //------------------------------------------------------------------------------
+    size_t TransientBuffer::getByteSize( unsigned int mapping, unsigned int ) const
+    {
+        if( (mapping & MAP_DEVICE_ARRAY) == MAP_DEVICE_ARRAY )
+            return 0;
+
+        return getAllElementsSize();
+    }
+
+    //------------------------------------------------------------------------------
+    void TransientBuffer::clear()
+    {
+        clearLocal();
+        Memory::clear();
+    }
+
+    //------------------------------------------------------------------------------
+    void TransientBuffer::releaseObjects()
+    {
+        // The store is released by the computation
+        Memory::releaseObjects();
+    }
+
+    //------------------------------------------------------------------------------
+    bool TransientBuffer::objectsReleased() const
+    {
+        if( !_store.valid() )
+            return true;
+
+        return _store->objectsReleased();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PROTECTED FUNCTIONS //////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    TransientBuffer::~TransientBuffer()
+    {
+        clearLocal();
+    }
+
+    //------------------------------------------------------------------------------
+    void TransientBuffer::clearLocal()
+    {
+        _store = NULL;
+        _storeOffset = 0;
+    }
+
+    //------------------------------------------------------------------------------
+    size_t TransientBuffer::computePitch() const
+    {
+        if( getNumDimensions() == 0 || getElementSize() == 0 ) 
+            return 0;
+
+        // 1-dimensional layout
+        if( getNumDimensions() < 2 )
+            return getAllElementsSize();
+
+        return size_t(getElementSize()) * getDimension(0);
+    }
+}
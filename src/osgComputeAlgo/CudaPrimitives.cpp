@@ -0,0 +1,289 @@
+#include <osg/Notify>
+#include <cuda_runtime.h>
+#include <osgComputeAlgo/CudaPrimitives>
+
+extern "C" size_t algoScratchSize( unsigned int n );
+
+extern "C" bool algoReduce( 
+    const void* in, void* result, unsigned int n, unsigned int type, unsigned int op, 
+    void* scratch, size_t scratchSize );
+
+extern "C" bool algoScan( 
+    const void* in, void* out, unsigned int n, unsigned int type, unsigned int op, bool inclusive, 
+    void* scratch, size_t scratchSize );
+
+extern "C" bool algoSegmentedReduce( 
+    const void* in, unsigned int n, const unsigned int* offsets, void* out, unsigned int numSegments, 
+    unsigned int type, unsigned int op );
+
+extern "C" bool algoSegmentedScan( 
+    const void* in, const unsigned int* flags, void* out, unsigned int n, unsigned int type, unsigned int op, bool inclusive, 
+    void* scratch, size_t scratchSize );
+
+extern "C" bool algoCompact( 
+    const void* in, const unsigned int* flags, void* out, unsigned int capacity, unsigned int* numSelected, 
+    unsigned int n, unsigned int elementSize, void* scratch, size_t scratchSize );
+
+extern "C" bool algoSortByKey( 
+    unsigned int* keys, unsigned int* values, unsigned int n, unsigned int type, bool descending, unsigned int keyBits, 
+    void* scratch, size_t scratchSize );
+
+namespace osgCuda
+{
+    //------------------------------------------------------------------------------
+    static void* mapTarget( osgCompute::Memory& output, const osgCompute::Memory& input )
+    {
+        // Memory which is read and written must be synchronized
+        return output.map( (&output == &input)? osgCompute::MAP_DEVICE : osgCompute::MAP_DEVICE_TARGET );
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    Primitives::Primitives()
+        : osgCompute::Primitives(),
+          _scratch( NULL ),
+          _scratchSize( 0 )
+    {
+        clearLocal();
+        // Please note that virtual functions className() and libraryName() are called
+        // during observeResource() which will only develop until this class.
+        // However if contructor of a subclass calls this function again observeResource
+        // will change the className and libraryName of the observed pointer.
+        osgCompute::ResourceObserver::instance()->observeResource( *this );
+    }
+
+    //------------------------------------------------------------------------------
+    bool Primitives::reduce( osgCompute::Memory& input, osgCompute::Memory& result, DataType type, Operation op /*= OP_SUM*/, size_t count /*= 0*/ )
+    {
+        count = getCount( input, count );
+        if( !checkMemory( input, 4, count ) || !checkMemory( result, 4, 1 ) || !checkCount( count ) || !allocScratch( count ) )
+            return false;
+
+        const void* in = input.map( osgCompute::MAP_DEVICE_SOURCE );
+        void* out = mapTarget( result, input );
+        if( in == NULL || out == NULL )
+            return false;
+
+        return algoReduce( in, out, static_cast<unsigned int>(count), type, op, _scratch, _scratchSize );
+    }
+
+    //------------------------------------------------------------------------------
+    bool Primitives::inclusiveScan( osgCompute::Memory& input, osgCompute::Memory& output, DataType type, Operation op /*= OP_SUM*/, size_t count /*= 0*/ )
+    {
+        return scan( input, output, type, op, true, count );
+    }
+
+    //------------------------------------------------------------------------------
+    bool Primitives::exclusiveScan( osgCompute::Memory& input, osgCompute::Memory& output, DataType type, Operation op /*= OP_SUM*/, size_t count /*= 0*/ )
+    {
+        return scan( input, output, type, op, false, count );
+    }
+
+    //------------------------------------------------------------------------------
+    bool Primitives::segmentedReduce( osgCompute::Memory& input, osgCompute::Memory& offsets, osgCompute::Memory& output, DataType type, Operation op /*= OP_SUM*/, size_t numSegments /*= 0*/ )
+    {
+        if( numSegments == 0 && offsets.getNumElements() > 0 )
+            numSegments = offsets.getNumElements() - 1;
+
+        if( !checkMemory( input, 4, 0 ) || !checkMemory( offsets, 4, numSegments + 1 ) || !checkMemory( output, 4, numSegments ) ||
+            !checkCount( input.getNumElements() ) || !checkCount( numSegments ) )
+            return false;
+
+        if( numSegments == 0 )
+            return true;
+
+        const void* in = input.map( osgCompute::MAP_DEVICE_SOURCE );
+        const unsigned int* segs = static_cast<const unsigned int*>( offsets.map( osgCompute::MAP_DEVICE_SOURCE ) );
+        void* out = mapTarget( output, input );
+        if( in == NULL || segs == NULL || out == NULL )
+            return false;
+
+        return algoSegmentedReduce( in, static_cast<unsigned int>(input.getNumElements()), segs, out, static_cast<unsigned int>(numSegments), type, op );
+    }
+
+    //------------------------------------------------------------------------------
+    bool Primitives::segmentedScan( osgCompute::Memory& input, osgCompute::Memory& flags, osgCompute::Memory& output, DataType type, Operation op /*= OP_SUM*/, bool inclusive /*= true*/, size_t count /*= 0*/ )
+    {
+        count = getCount( input, count );
+        if( !checkMemory( input, 4, count ) || !checkMemory( flags, 4, count ) || !checkMemory( output, 4, count ) || 
+            !checkCount( count ) || !allocScratch( count ) )
+            return false;
+
+        if( count == 0 )
+            return true;
+
+        const void* in = input.map( osgCompute::MAP_DEVICE_SOURCE );
+        const unsigned int* heads = static_cast<const unsigned int*>( flags.map( osgCompute::MAP_DEVICE_SOURCE ) );
+        void* out = mapTarget( output, input );
+        if( in == NULL || heads == NULL || out == NULL )
+            return false;
+
+        return algoSegmentedScan( in, heads, out, static_cast<unsigned int>(count), type, op, inclusive, _scratch, _scratchSize );
+    }
+
+    //------------------------------------------------------------------------------
+    bool Primitives::compact( osgCompute::Memory& input, osgCompute::Memory& flags, osgCompute::Memory& output, osgCompute::Memory& numSelected, size_t count /*= 0*/ )
+    {
+        if( &input == &output )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << " " << getName() << ": input and output must be different memory objects."
+                << std::endl;
+
+            return false;
+        }
+
+        count = getCount( input, count );
+        if( !checkMemory( flags, 4, count ) || !checkMemory( output, input.getElementSize(), 0 ) || 
+            !checkMemory( numSelected, 4, 1 ) || !checkMemory( input, 0, count ) || 
+            !checkCount( count ) || !checkCount( output.getNumElements() ) || !allocScratch( count ) )
+            return false;
+
+        const void* in = input.map( osgCompute::MAP_DEVICE_SOURCE );
+        const unsigned int* selected = static_cast<const unsigned int*>( flags.map( osgCompute::MAP_DEVICE_SOURCE ) );
+        void* out = output.map( osgCompute::MAP_DEVICE_TARGET );
+        unsigned int* result = static_cast<unsigned int*>( numSelected.map( osgCompute::MAP_DEVICE_TARGET ) );
+        if( in == NULL || selected == NULL || out == NULL || result == NULL )
+            return false;
+
+        return algoCompact( in, selected, out, static_cast<unsigned int>(output.getNumElements()), result, 
+                            static_cast<unsigned int>(count), input.getElementSize(), _scratch, _scratchSize );
+    }
+
+    //------------------------------------------------------------------------------
+    bool Primitives::sortByKey( osgCompute::Memory& keys, osgCompute::Memory* values, DataType type, size_t count /*= 0*/, bool descending /*= false*/, unsigned int keyBits /*= 32*/ )
+    {
+        count = getCount( keys, count );
+        if( !checkMemory( keys, 4, count ) || (values != NULL && !checkMemory( *values, 4, count )) || 
+            !checkCount( count ) || !allocScratch( count ) )
+            return false;
+
+        if( count < 2 )
+            return true;
+
+        unsigned int* keyPtr = static_cast<unsigned int*>( keys.map( osgCompute::MAP_DEVICE ) );
+        unsigned int* valuePtr = (values != NULL)? static_cast<unsigned int*>( values->map( osgCompute::MAP_DEVICE ) ) : NULL;
+        if( keyPtr == NULL || (values != NULL && valuePtr == NULL) )
+            return false;
+
+        if( type != TYPE_UINT || keyBits > 32 )
+            keyBits = 32;
+
+        return algoSortByKey( keyPtr, valuePtr, static_cast<unsigned int>(count), type, descending, keyBits, _scratch, _scratchSize );
+    }
+
+    //------------------------------------------------------------------------------
+    size_t Primitives::getScratchSize() const
+    {
+        return _scratchSize;
+    }
+
+    //------------------------------------------------------------------------------
+    void Primitives::clear()
+    {
+        clearLocal();
+        osgCompute::Primitives::clear();
+    }
+
+    //------------------------------------------------------------------------------
+    void Primitives::releaseObjects()
+    {
+        if( _scratch != NULL )
+        {
+            cudaError res = cudaFree( _scratch );
+            if( res != cudaSuccess )
+            {
+                osg::notify(osg::FATAL)
+                    <<__FUNCTION__ << ": error during cudaFree(). "
+                    <<cudaGetErrorString(res)<<std::endl;
+            }
+        }
+
+        _scratch = NULL;
+        _scratchSize = 0;
+        osgCompute::Primitives::releaseObjects();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PROTECTED FUNCTIONS //////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    Primitives::~Primitives()
+    {
+        clearLocal();
+    }
+
+    //------------------------------------------------------------------------------
+    void Primitives::clearLocal()
+    {
+        if( _scratch != NULL )
+            cudaFree( _scratch );
+
+        _scratch = NULL;
+        _scratchSize = 0;
+    }
+
+    //------------------------------------------------------------------------------
+    bool Primitives::checkCount( size_t count ) const
+    {
+        // Kernels index elements with unsigned integers
+        if( count > 0xFFFFFFFF )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << " " << getName() << ": cannot process more than 2^32-1 elements."
+                << std::endl;
+
+            return false;
+        }
+
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    bool Primitives::allocScratch( size_t count )
+    {
+        size_t scratchSize = algoScratchSize( static_cast<unsigned int>(count) );
+        if( scratchSize <= _scratchSize )
+            return true;
+
+        if( _scratch != NULL )
+            cudaFree( _scratch );
+
+        _scratch = NULL;
+        _scratchSize = 0;
+
+        cudaError res = cudaMalloc( &_scratch, scratchSize );
+        if( res != cudaSuccess )
+        {
+            osg::notify(osg::FATAL)
+                << __FUNCTION__ << " " << getName() << ": error during cudaMalloc(). "
+                << cudaGetErrorString(res) << std::endl;
+
+            _scratch = NULL;
+            return false;
+        }
+
+        _scratchSize = scratchSize;
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    bool Primitives::scan( osgCompute::Memory& input, osgCompute::Memory& output, DataType type, Operation op, bool inclusive, size_t count )
+    {
+        count = getCount( input, count );
+        if( !checkMemory( input, 4, count ) || !checkMemory( output, 4, count ) || !checkCount( count ) || !allocScratch( count ) )
+            return false;
+
+        if( count == 0 )
+            return true;
+
+        const void* in = input.map( osgCompute::MAP_DEVICE_SOURCE );
+        void* out = mapTarget( output, input );
+        if( in == NULL || out == NULL )
+            return false;
+
+        return algoScan( in, out, static_cast<unsigned int>(count), type, op, inclusive, _scratch, _scratchSize );
+    }
+}
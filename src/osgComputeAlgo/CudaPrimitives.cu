@@ -0,0 +1,838 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+
+#include <cuda_runtime.h>
+
+#define ALGO_BLOCK_SIZE     256
+#define ALGO_REDUCE_BLOCKS  64
+#define ALGO_RADIX_BITS     4
+#define ALGO_RADIX_DIGITS   16
+
+// Values of osgCompute::Primitives::DataType
+#define ALGO_TYPE_INT       0
+#define ALGO_TYPE_UINT      1
+#define ALGO_TYPE_FLOAT     2
+
+// Values of osgCompute::Primitives::Operation
+#define ALGO_OP_SUM         0
+#define ALGO_OP_MIN         1
+#define ALGO_OP_MAX         2
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// OPERATIONS ////////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+template<typename T> struct AlgoLimits {};
+
+template<> struct AlgoLimits<int>
+{
+    __device__ static int lowest() { return (-2147483647 - 1); }
+    __device__ static int highest() { return 2147483647; }
+};
+
+template<> struct AlgoLimits<unsigned int>
+{
+    __device__ static unsigned int lowest() { return 0u; }
+    __device__ static unsigned int highest() { return 0xFFFFFFFFu; }
+};
+
+template<> struct AlgoLimits<float>
+{
+    __device__ static float lowest() { return __int_as_float( (int)0xFF800000 ); }
+    __device__ static float highest() { return __int_as_float( (int)0x7F800000 ); }
+};
+
+//------------------------------------------------------------------------------
+template<typename T> struct AlgoSum
+{
+    typedef T Value;
+    __device__ static T identity() { return T(0); }
+    __device__ static T apply( T a, T b ) { return a + b; }
+};
+
+//------------------------------------------------------------------------------
+template<typename T> struct AlgoMin
+{
+    typedef T Value;
+    __device__ static T identity() { return AlgoLimits<T>::highest(); }
+    __device__ static T apply( T a, T b ) { return (b < a)? b : a; }
+};
+
+//------------------------------------------------------------------------------
+template<typename T> struct AlgoMax
+{
+    typedef T Value;
+    __device__ static T identity() { return AlgoLimits<T>::lowest(); }
+    __device__ static T apply( T a, T b ) { return (a < b)? b : a; }
+};
+
+//------------------------------------------------------------------------------
+// A value together with a flag which marks the first element of a segment
+template<typename T> struct AlgoSegment
+{
+    unsigned int    _head;
+    T               _value;
+};
+
+//------------------------------------------------------------------------------
+// Combining segments is associative. So segmented scans are 
+// computed with the same scan as any other operation.
+template<typename T, typename Op> struct AlgoSegmentOp
+{
+    typedef AlgoSegment<T> Value;
+
+    __device__ static Value identity() 
+    { 
+        Value result;
+        result._head = 0;
+        result._value = Op::identity();
+        return result;
+    }
+
+    __device__ static Value apply( Value a, Value b ) 
+    { 
+        Value result;
+        result._head = a._head | b._head;
+        result._value = b._head ? b._value : Op::apply( a._value, b._value );
+        return result;
+    }
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// DEVICE FUNCTIONS //////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+inline __device__
+unsigned int blockIndex()
+{
+    return blockIdx.y * gridDim.x + blockIdx.x;
+}
+
+//------------------------------------------------------------------------------
+// Must be called by all threads of the block
+template<typename Op>
+inline __device__
+typename Op::Value blockReduce( typename Op::Value value, typename Op::Value* shared )
+{
+    shared[threadIdx.x] = value;
+    __syncthreads();
+
+    for( unsigned int stride = blockDim.x / 2; stride > 0; stride >>= 1 )
+    {
+        if( threadIdx.x < stride )
+            shared[threadIdx.x] = Op::apply( shared[threadIdx.x], shared[threadIdx.x + stride] );
+
+        __syncthreads();
+    }
+
+    typename Op::Value result = shared[0];
+    __syncthreads();
+    return result;
+}
+
+//------------------------------------------------------------------------------
+// Must be called by all threads of the block. Shared 
+// memory must hold two values per thread.
+template<typename Op>
+inline __device__
+typename Op::Value blockInclusiveScan( typename Op::Value value, typename Op::Value* shared )
+{
+    unsigned int out = 0;
+    shared[threadIdx.x] = value;
+    __syncthreads();
+
+    for( unsigned int offset = 1; offset < blockDim.x; offset <<= 1 )
+    {
+        unsigned int in = out;
+        out = 1 - out;
+
+        if( threadIdx.x >= offset )
+            shared[out * blockDim.x + threadIdx.x] = Op::apply( shared[in * blockDim.x + threadIdx.x - offset], shared[in * blockDim.x + threadIdx.x] );
+        else
+            shared[out * blockDim.x + threadIdx.x] = shared[in * blockDim.x + threadIdx.x];
+
+        __syncthreads();
+    }
+
+    typename Op::Value result = shared[out * blockDim.x + threadIdx.x];
+    __syncthreads();
+    return result;
+}
+
+//------------------------------------------------------------------------------
+// Must be called by all threads of the block. Digits of the first numValid 
+// threads must be sorted. Stores the range of positions of each digit.
+inline __device__
+void blockDigitRanges( unsigned int digit, unsigned int numValid, unsigned int* digits, unsigned int* starts, unsigned int* ends )
+{
+    digits[threadIdx.x] = digit;
+    if( threadIdx.x < ALGO_RADIX_DIGITS )
+    {
+        starts[threadIdx.x] = 0;
+        ends[threadIdx.x] = 0;
+    }
+    __syncthreads();
+
+    if( threadIdx.x < numValid )
+    {
+        if( threadIdx.x == 0 || digits[threadIdx.x - 1] != digit )
+            starts[digit] = threadIdx.x;
+        if( threadIdx.x == numValid - 1 || digits[threadIdx.x + 1] != digit )
+            ends[digit] = threadIdx.x + 1;
+    }
+    __syncthreads();
+}
+
+//------------------------------------------------------------------------------
+inline __device__
+unsigned int toRadixKey( unsigned int key, unsigned int type, bool descending )
+{
+    // Map signed integers and floats to unsigned 
+    // integers of the same order
+    if( type == ALGO_TYPE_INT )
+        key ^= 0x80000000u;
+    else if( type == ALGO_TYPE_FLOAT )
+        key = (key & 0x80000000u)? ~key : (key | 0x80000000u);
+
+    return descending? ~key : key;
+}
+
+//------------------------------------------------------------------------------
+inline __device__
+unsigned int fromRadixKey( unsigned int key, unsigned int type, bool descending )
+{
+    if( descending )
+        key = ~key;
+
+    if( type == ALGO_TYPE_INT )
+        key ^= 0x80000000u;
+    else if( type == ALGO_TYPE_FLOAT )
+        key = (key & 0x80000000u)? (key & 0x7FFFFFFFu) : ~key;
+
+    return key;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS //////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+template<typename Op>
+__global__
+void reduceKernel( const typename Op::Value* in, typename Op::Value* out, unsigned int n )
+{
+    __shared__ typename Op::Value shared[ALGO_BLOCK_SIZE];
+
+    typename Op::Value value = Op::identity();
+    for( unsigned int idx = blockIdx.x * blockDim.x + threadIdx.x; idx < n; idx += gridDim.x * blockDim.x )
+        value = Op::apply( value, in[idx] );
+
+    value = blockReduce<Op>( value, shared );
+    if( threadIdx.x == 0 )
+        out[blockIdx.x] = value;
+}
+
+//------------------------------------------------------------------------------
+template<typename Op>
+__global__
+void scanBlocksKernel( const typename Op::Value* in, typename Op::Value* out, typename Op::Value* blockSums, unsigned int n )
+{
+    __shared__ typename Op::Value shared[2*ALGO_BLOCK_SIZE];
+
+    unsigned int block = blockIndex();
+    if( block * blockDim.x >= n )
+        return;
+
+    unsigned int idx = block * blockDim.x + threadIdx.x;
+    typename Op::Value value = (idx < n)? in[idx] : Op::identity();
+
+    value = blockInclusiveScan<Op>( value, shared );
+    if( idx < n )
+        out[idx] = value;
+
+    if( blockSums != NULL && threadIdx.x == blockDim.x - 1 )
+        blockSums[block] = value;
+}
+
+//------------------------------------------------------------------------------
+template<typename Op>
+__global__
+void addBlockSumsKernel( typename Op::Value* out, const typename Op::Value* blockSums, unsigned int n )
+{
+    unsigned int block = blockIndex();
+    unsigned int idx = block * blockDim.x + threadIdx.x;
+    if( block == 0 || idx >= n )
+        return;
+
+    out[idx] = Op::apply( blockSums[block - 1], out[idx] );
+}
+
+//------------------------------------------------------------------------------
+template<typename Op>
+__global__
+void shiftKernel( const typename Op::Value* in, typename Op::Value* out, unsigned int n )
+{
+    unsigned int idx = blockIndex() * blockDim.x + threadIdx.x;
+    if( idx >= n )
+        return;
+
+    out[idx] = (idx == 0)? Op::identity() : in[idx - 1];
+}
+
+//------------------------------------------------------------------------------
+template<typename T>
+__global__
+void packSegmentsKernel( const T* in, const unsigned int* flags, AlgoSegment<T>* segments, unsigned int n )
+{
+    unsigned int idx = blockIndex() * blockDim.x + threadIdx.x;
+    if( idx >= n )
+        return;
+
+    AlgoSegment<T> segment;
+    segment._head = (idx == 0 || flags[idx] != 0)? 1 : 0;
+    segment._value = in[idx];
+    segments[idx] = segment;
+}
+
+//------------------------------------------------------------------------------
+template<typename Op>
+__global__
+void unpackSegmentsKernel( const AlgoSegment<typename Op::Value>* segments, const unsigned int* flags, typename Op::Value* out, unsigned int n, bool inclusive )
+{
+    unsigned int idx = blockIndex() * blockDim.x + threadIdx.x;
+    if( idx >= n )
+        return;
+
+    if( inclusive )
+        out[idx] = segments[idx]._value;
+    else
+        out[idx] = (idx == 0 || flags[idx] != 0)? Op::identity() : segments[idx - 1]._value;
+}
+
+//------------------------------------------------------------------------------
+template<typename Op>
+__global__
+void segmentedReduceKernel( const typename Op::Value* in, unsigned int n, const unsigned int* offsets, typename Op::Value* out, unsigned int numSegments )
+{
+    __shared__ typename Op::Value shared[ALGO_BLOCK_SIZE];
+
+    unsigned int segment = blockIndex();
+    if( segment >= numSegments )
+        return;
+
+    unsigned int first = min( offsets[segment], n );
+    unsigned int last = min( offsets[segment + 1], n );
+
+    typename Op::Value value = Op::identity();
+    for( unsigned int idx = first + threadIdx.x; idx < last; idx += blockDim.x )
+        value = Op::apply( value, in[idx] );
+
+    value = blockReduce<Op>( value, shared );
+    if( threadIdx.x == 0 )
+        out[segment] = value;
+}
+
+//------------------------------------------------------------------------------
+__global__
+void predicateKernel( const unsigned int* flags, unsigned int* predicates, unsigned int n )
+{
+    unsigned int idx = blockIndex() * blockDim.x + threadIdx.x;
+    if( idx >= n )
+        return;
+
+    predicates[idx] = (flags[idx] != 0)? 1 : 0;
+}
+
+//------------------------------------------------------------------------------
+__global__
+void compactKernel( const char* in, const unsigned int* flags, const unsigned int* positions, char* out, 
+                    unsigned int n, unsigned int capacity, unsigned int elementSize )
+{
+    unsigned int idx = blockIndex() * blockDim.x + threadIdx.x;
+    if( idx >= n || flags[idx] == 0 )
+        return;
+
+    // Elements which do not fit are dropped
+    unsigned int dst = positions[idx] - 1;
+    if( dst >= capacity )
+        return;
+
+    if( (elementSize & 3) == 0 )
+    {
+        const unsigned int* src = reinterpret_cast<const unsigned int*>( &in[(size_t)idx * elementSize] );
+        unsigned int* trg = reinterpret_cast<unsigned int*>( &out[(size_t)dst * elementSize] );
+        for( unsigned int w=0; w<elementSize/4; ++w )
+            trg[w] = src[w];
+    }
+    else
+    {
+        const char* src = &in[(size_t)idx * elementSize];
+        char* trg = &out[(size_t)dst * elementSize];
+        for( unsigned int b=0; b<elementSize; ++b )
+            trg[b] = src[b];
+    }
+}
+
+//------------------------------------------------------------------------------
+__global__
+void countKernel( const unsigned int* positions, unsigned int n, unsigned int* numSelected )
+{
+    *numSelected = positions[n - 1];
+}
+
+//------------------------------------------------------------------------------
+__global__
+void transformKeysKernel( unsigned int* keys, unsigned int n, unsigned int type, bool descending, bool toRadix )
+{
+    unsigned int idx = blockIndex() * blockDim.x + threadIdx.x;
+    if( idx >= n )
+        return;
+
+    keys[idx] = toRadix ? toRadixKey( keys[idx], type, descending ) : fromRadixKey( keys[idx], type, descending );
+}
+
+//------------------------------------------------------------------------------
+__global__
+void radixSortBlocksKernel( unsigned int* keys, unsigned int* values, unsigned int n, unsigned int shift, unsigned int* histogram )
+{
+    __shared__ unsigned int shared[2*ALGO_BLOCK_SIZE];
+    __shared__ unsigned int sharedKeys[ALGO_BLOCK_SIZE];
+    __shared__ unsigned int sharedSrc[ALGO_BLOCK_SIZE];
+    __shared__ unsigned int starts[ALGO_RADIX_DIGITS];
+    __shared__ unsigned int ends[ALGO_RADIX_DIGITS];
+    __shared__ unsigned int numZeros;
+
+    unsigned int numBlocks = (n + blockDim.x - 1) / blockDim.x;
+    unsigned int block = blockIndex();
+    if( block >= numBlocks )
+        return;
+
+    // Padding keys have the largest digit and 
+    // stay behind the keys of the block
+    unsigned int base = block * blockDim.x;
+    unsigned int numValid = min( blockDim.x, n - base );
+    unsigned int key = (threadIdx.x < numValid)? keys[base + threadIdx.x] : 0xFFFFFFFFu;
+    unsigned int src = threadIdx.x;
+
+    // Stable split of the block by each bit of the digit
+    for( unsigned int bit=shift; bit<shift+ALGO_RADIX_BITS; ++bit )
+    {
+        unsigned int isZero = ((key >> bit) & 1)? 0 : 1;
+        unsigned int zeros = blockInclusiveScan< AlgoSum<unsigned int> >( isZero, shared );
+        if( threadIdx.x == blockDim.x - 1 )
+            numZeros = zeros;
+        __syncthreads();
+
+        unsigned int dst = isZero? zeros - 1 : numZeros + threadIdx.x - zeros;
+        sharedKeys[dst] = key;
+        sharedSrc[dst] = src;
+        __syncthreads();
+
+        key = sharedKeys[threadIdx.x];
+        src = sharedSrc[threadIdx.x];
+        __syncthreads();
+    }
+
+    unsigned int digit = (key >> shift) & (ALGO_RADIX_DIGITS - 1);
+    blockDigitRanges( digit, numValid, shared, starts, ends );
+
+    // Histograms are stored digit by digit so that a scan
+    // returns the first position of each digit in each block
+    if( threadIdx.x < ALGO_RADIX_DIGITS )
+        histogram[threadIdx.x * numBlocks + block] = ends[threadIdx.x] - starts[threadIdx.x];
+
+    // Each block only reorders its own elements
+    unsigned int value = (values != NULL && threadIdx.x < numValid)? values[base + src] : 0;
+    __syncthreads();
+
+    if( threadIdx.x >= numValid )
+        return;
+
+    keys[base + threadIdx.x] = key;
+    if( values != NULL )
+        values[base + threadIdx.x] = value;
+}
+
+//------------------------------------------------------------------------------
+__global__
+void radixScatterKernel( const unsigned int* keysIn, const unsigned int* valuesIn, unsigned int* keysOut, unsigned int* valuesOut,
+                         unsigned int n, unsigned int shift, const unsigned int* histogram, const unsigned int* positions )
+{
+    __shared__ unsigned int digits[ALGO_BLOCK_SIZE];
+    __shared__ unsigned int starts[ALGO_RADIX_DIGITS];
+    __shared__ unsigned int ends[ALGO_RADIX_DIGITS];
+
+    unsigned int numBlocks = (n + blockDim.x - 1) / blockDim.x;
+    unsigned int block = blockIndex();
+    if( block >= numBlocks )
+        return;
+
+    // Keys of each block are sorted by the digit
+    unsigned int base = block * blockDim.x;
+    unsigned int numValid = min( blockDim.x, n - base );
+    unsigned int idx = base + threadIdx.x;
+    unsigned int key = (threadIdx.x < numValid)? keysIn[idx] : 0xFFFFFFFFu;
+    unsigned int digit = (key >> shift) & (ALGO_RADIX_DIGITS - 1);
+    blockDigitRanges( digit, numValid, digits, starts, ends );
+
+    if( threadIdx.x >= numValid )
+        return;
+
+    unsigned int bucket = digit * numBlocks + block;
+    unsigned int dst = positions[bucket] - histogram[bucket] + threadIdx.x - starts[digit];
+    keysOut[dst] = key;
+    if( valuesIn != NULL )
+        valuesOut[dst] = valuesIn[idx];
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// HOST FUNCTIONS ////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+// Temporary device memory which is handed out one after another
+struct AlgoScratch
+{
+    char*   _ptr;
+    size_t  _size;
+    size_t  _used;
+};
+
+//------------------------------------------------------------------------------
+static size_t scratchBytes( size_t count, size_t valueSize )
+{
+    return (count * valueSize + 255) & ~size_t(255);
+}
+
+//------------------------------------------------------------------------------
+template<typename T>
+static T* scratchAlloc( AlgoScratch& scratch, size_t count )
+{
+    size_t bytes = scratchBytes( count, sizeof(T) );
+    if( scratch._used + bytes > scratch._size )
+        return NULL;
+
+    T* ptr = reinterpret_cast<T*>( &scratch._ptr[scratch._used] );
+    scratch._used += bytes;
+    return ptr;
+}
+
+//------------------------------------------------------------------------------
+static size_t scanScratchSize( unsigned int n, size_t valueSize )
+{
+    size_t size = 0;
+    while( n > ALGO_BLOCK_SIZE )
+    {
+        n = (n + ALGO_BLOCK_SIZE - 1) / ALGO_BLOCK_SIZE;
+        size += scratchBytes( n, valueSize );
+    }
+
+    return size;
+}
+
+//------------------------------------------------------------------------------
+static dim3 gridOf( unsigned int numBlocks )
+{
+    // Grids are limited to 65535 blocks per dimension
+    if( numBlocks <= 65535 )
+        return dim3( numBlocks, 1, 1 );
+
+    unsigned int rows = (numBlocks + 65534) / 65535;
+    return dim3( (numBlocks + rows - 1) / rows, rows, 1 );
+}
+
+//------------------------------------------------------------------------------
+static dim3 gridFor( unsigned int n )
+{
+    return gridOf( (n + ALGO_BLOCK_SIZE - 1) / ALGO_BLOCK_SIZE );
+}
+
+//------------------------------------------------------------------------------
+// Inclusive scan of n values. Input and output might be the same.
+template<typename Op>
+static bool scanDevice( const typename Op::Value* in, typename Op::Value* out, unsigned int n, AlgoScratch& scratch )
+{
+    unsigned int numBlocks = (n + ALGO_BLOCK_SIZE - 1) / ALGO_BLOCK_SIZE;
+    if( numBlocks <= 1 )
+    {
+        scanBlocksKernel<Op><<< 1, ALGO_BLOCK_SIZE >>>( in, out, NULL, n );
+        return true;
+    }
+
+    typename Op::Value* blockSums = scratchAlloc<typename Op::Value>( scratch, numBlocks );
+    if( blockSums == NULL )
+        return false;
+
+    scanBlocksKernel<Op><<< gridOf(numBlocks), ALGO_BLOCK_SIZE >>>( in, out, blockSums, n );
+    if( !scanDevice<Op>( blockSums, blockSums, numBlocks, scratch ) )
+        return false;
+
+    addBlockSumsKernel<Op><<< gridOf(numBlocks), ALGO_BLOCK_SIZE >>>( out, blockSums, n );
+    return true;
+}
+
+//------------------------------------------------------------------------------
+struct AlgoArgs
+{
+    const void*             _in;
+    void*                   _out;
+    const unsigned int*     _flags;
+    unsigned int            _n;
+    unsigned int            _numSegments;
+    bool                    _inclusive;
+    AlgoScratch             _scratch;
+};
+
+//------------------------------------------------------------------------------
+template<typename T, typename Op> struct AlgoReduce
+{
+    static bool run( AlgoArgs& args )
+    {
+        T* partials = scratchAlloc<T>( args._scratch, ALGO_REDUCE_BLOCKS );
+        if( partials == NULL )
+            return false;
+
+        unsigned int numBlocks = (args._n + ALGO_BLOCK_SIZE - 1) / ALGO_BLOCK_SIZE;
+        if( numBlocks > ALGO_REDUCE_BLOCKS ) numBlocks = ALGO_REDUCE_BLOCKS;
+        if( numBlocks == 0 ) numBlocks = 1;
+
+        reduceKernel<Op><<< numBlocks, ALGO_BLOCK_SIZE >>>( static_cast<const T*>(args._in), partials, args._n );
+        reduceKernel<Op><<< 1, ALGO_BLOCK_SIZE >>>( partials, static_cast<T*>(args._out), numBlocks );
+        return true;
+    }
+};
+
+//------------------------------------------------------------------------------
+template<typename T, typename Op> struct AlgoScan
+{
+    static bool run( AlgoArgs& args )
+    {
+        if( args._inclusive )
+            return scanDevice<Op>( static_cast<const T*>(args._in), static_cast<T*>(args._out), args._n, args._scratch );
+
+        // Scan into temporary memory first as 
+        // input and output might be the same
+        T* scanned = scratchAlloc<T>( args._scratch, args._n );
+        if( scanned == NULL || !scanDevice<Op>( static_cast<const T*>(args._in), scanned, args._n, args._scratch ) )
+            return false;
+
+        shiftKernel<Op><<< gridFor(args._n), ALGO_BLOCK_SIZE >>>( scanned, static_cast<T*>(args._out), args._n );
+        return true;
+    }
+};
+
+//------------------------------------------------------------------------------
+template<typename T, typename Op> struct AlgoSegmentedScan
+{
+    static bool run( AlgoArgs& args )
+    {
+        AlgoSegment<T>* segments = scratchAlloc< AlgoSegment<T> >( args._scratch, args._n );
+        if( segments == NULL )
+            return false;
+
+        packSegmentsKernel<T><<< gridFor(args._n), ALGO_BLOCK_SIZE >>>( static_cast<const T*>(args._in), args._flags, segments, args._n );
+        if( !scanDevice< AlgoSegmentOp<T,Op> >( segments, segments, args._n, args._scratch ) )
+            return false;
+
+        unpackSegmentsKernel<Op><<< gridFor(args._n), ALGO_BLOCK_SIZE >>>( segments, args._flags, static_cast<T*>(args._out), args._n, args._inclusive );
+        return true;
+    }
+};
+
+//------------------------------------------------------------------------------
+template<typename T, typename Op> struct AlgoSegmentedReduce
+{
+    static bool run( AlgoArgs& args )
+    {
+        segmentedReduceKernel<Op><<< gridOf(args._numSegments), ALGO_BLOCK_SIZE >>>( 
+            static_cast<const T*>(args._in), args._n, args._flags, static_cast<T*>(args._out), args._numSegments );
+        return true;
+    }
+};
+
+//------------------------------------------------------------------------------
+template< template<typename,typename> class Fn, typename T >
+static bool dispatchOp( unsigned int op, AlgoArgs& args )
+{
+    switch( op )
+    {
+    case ALGO_OP_MIN: return Fn< T, AlgoMin<T> >::run( args );
+    case ALGO_OP_MAX: return Fn< T, AlgoMax<T> >::run( args );
+    default: return Fn< T, AlgoSum<T> >::run( args );
+    }
+}
+
+//------------------------------------------------------------------------------
+template< template<typename,typename> class Fn >
+static bool dispatch( unsigned int type, unsigned int op, AlgoArgs& args )
+{
+    switch( type )
+    {
+    case ALGO_TYPE_INT: return dispatchOp< Fn, int >( op, args );
+    case ALGO_TYPE_UINT: return dispatchOp< Fn, unsigned int >( op, args );
+    case ALGO_TYPE_FLOAT: return dispatchOp< Fn, float >( op, args );
+    default: return false;
+    }
+}
+
+//------------------------------------------------------------------------------
+static AlgoArgs makeArgs( const void* in, void* out, unsigned int n, void* scratch, size_t scratchSize )
+{
+    AlgoArgs args;
+    args._in = in;
+    args._out = out;
+    args._flags = NULL;
+    args._n = n;
+    args._numSegments = 0;
+    args._inclusive = true;
+    args._scratch._ptr = static_cast<char*>( scratch );
+    args._scratch._size = scratchSize;
+    args._scratch._used = 0;
+    return args;
+}
+
+//------------------------------------------------------------------------------
+extern "C" __host__
+size_t algoScratchSize( unsigned int n )
+{
+    // Upper bound of the temporary memory of all operations
+    unsigned int numBlocks = (n + ALGO_BLOCK_SIZE - 1) / ALGO_BLOCK_SIZE;
+    unsigned int numBuckets = numBlocks * ALGO_RADIX_DIGITS;
+
+    return 2 * scratchBytes( n, 8 ) + 
+           scanScratchSize( n, 8 ) + 
+           2 * scratchBytes( numBuckets, 4 ) + 
+           scanScratchSize( numBuckets, 4 ) + 
+           scratchBytes( ALGO_REDUCE_BLOCKS, 8 );
+}
+
+//------------------------------------------------------------------------------
+extern "C" __host__
+bool algoReduce( const void* in, void* result, unsigned int n, unsigned int type, unsigned int op, void* scratch, size_t scratchSize )
+{
+    AlgoArgs args = makeArgs( in, result, n, scratch, scratchSize );
+    return dispatch<AlgoReduce>( type, op, args );
+}
+
+//------------------------------------------------------------------------------
+extern "C" __host__
+bool algoScan( const void* in, void* out, unsigned int n, unsigned int type, unsigned int op, bool inclusive, void* scratch, size_t scratchSize )
+{
+    if( n == 0 )
+        return true;
+
+    AlgoArgs args = makeArgs( in, out, n, scratch, scratchSize );
+    args._inclusive = inclusive;
+    return dispatch<AlgoScan>( type, op, args );
+}
+
+//------------------------------------------------------------------------------
+extern "C" __host__
+bool algoSegmentedReduce( const void* in, unsigned int n, const unsigned int* offsets, void* out, unsigned int numSegments, unsigned int type, unsigned int op )
+{
+    if( numSegments == 0 )
+        return true;
+
+    AlgoArgs args = makeArgs( in, out, n, NULL, 0 );
+    args._flags = offsets;
+    args._numSegments = numSegments;
+    return dispatch<AlgoSegmentedReduce>( type, op, args );
+}
+
+//------------------------------------------------------------------------------
+extern "C" __host__
+bool algoSegmentedScan( const void* in, const unsigned int* flags, void* out, unsigned int n, unsigned int type, unsigned int op, bool inclusive, void* scratch, size_t scratchSize )
+{
+    if( n == 0 )
+        return true;
+
+    AlgoArgs args = makeArgs( in, out, n, scratch, scratchSize );
+    args._flags = flags;
+    args._inclusive = inclusive;
+    return dispatch<AlgoSegmentedScan>( type, op, args );
+}
+
+//------------------------------------------------------------------------------
+extern "C" __host__
+bool algoCompact( const void* in, const unsigned int* flags, void* out, unsigned int capacity, unsigned int* numSelected, 
+                  unsigned int n, unsigned int elementSize, void* scratch, size_t scratchSize )
+{
+    if( n == 0 )
+        return cudaMemset( numSelected, 0, sizeof(unsigned int) ) == cudaSuccess;
+
+    AlgoScratch tmp = { static_cast<char*>( scratch ), scratchSize, 0 };
+    unsigned int* positions = scratchAlloc<unsigned int>( tmp, n );
+    if( positions == NULL )
+        return false;
+
+    predicateKernel<<< gridFor(n), ALGO_BLOCK_SIZE >>>( flags, positions, n );
+    if( !scanDevice< AlgoSum<unsigned int> >( positions, positions, n, tmp ) )
+        return false;
+
+    compactKernel<<< gridFor(n), ALGO_BLOCK_SIZE >>>( static_cast<const char*>(in), flags, positions, static_cast<char*>(out), n, capacity, elementSize );
+    countKernel<<< 1, 1 >>>( positions, n, numSelected );
+    return true;
+}
+
+//------------------------------------------------------------------------------
+extern "C" __host__
+bool algoSortByKey( unsigned int* keys, unsigned int* values, unsigned int n, unsigned int type, bool descending, unsigned int keyBits, 
+                    void* scratch, size_t scratchSize )
+{
+    if( n < 2 )
+        return true;
+
+    unsigned int numBlocks = (n + ALGO_BLOCK_SIZE - 1) / ALGO_BLOCK_SIZE;
+    unsigned int numBuckets = numBlocks * ALGO_RADIX_DIGITS;
+
+    AlgoScratch tmp = { static_cast<char*>( scratch ), scratchSize, 0 };
+    unsigned int* tmpKeys = scratchAlloc<unsigned int>( tmp, n );
+    unsigned int* tmpValues = (values != NULL)? scratchAlloc<unsigned int>( tmp, n ) : NULL;
+    unsigned int* histogram = scratchAlloc<unsigned int>( tmp, numBuckets );
+    unsigned int* positions = scratchAlloc<unsigned int>( tmp, numBuckets );
+    if( tmpKeys == NULL || (values != NULL && tmpValues == NULL) || histogram == NULL || positions == NULL )
+        return false;
+
+    transformKeysKernel<<< gridFor(n), ALGO_BLOCK_SIZE >>>( keys, n, type, descending, true );
+
+    unsigned int* srcKeys = keys;
+    unsigned int* srcValues = values;
+    unsigned int* dstKeys = tmpKeys;
+    unsigned int* dstValues = tmpValues;
+    for( unsigned int shift=0; shift<keyBits; shift+=ALGO_RADIX_BITS )
+    {
+        // Sorts each block by the digit and counts the digits of each block
+        radixSortBlocksKernel<<< gridOf(numBlocks), ALGO_BLOCK_SIZE >>>( srcKeys, srcValues, n, shift, histogram );
+
+        // Scratch memory of the scan is reused in each pass
+        AlgoScratch scanTmp = tmp;
+        if( !scanDevice< AlgoSum<unsigned int> >( histogram, positions, numBuckets, scanTmp ) )
+            return false;
+
+        radixScatterKernel<<< gridOf(numBlocks), ALGO_BLOCK_SIZE >>>( srcKeys, srcValues, dstKeys, dstValues, n, shift, histogram, positions );
+
+        unsigned int* swapKeys = srcKeys; srcKeys = dstKeys; dstKeys = swapKeys;
+        unsigned int* swapValues = srcValues; srcValues = dstValues; dstValues = swapValues;
+    }
+
+    // Sorted keys must be located in the input memory
+    if( srcKeys != keys )
+    {
+        cudaMemcpy( keys, srcKeys, n * sizeof(unsigned int), cudaMemcpyDeviceToDevice );
+        if( values != NULL )
+            cudaMemcpy( values, srcValues, n * sizeof(unsigned int), cudaMemcpyDeviceToDevice );
+    }
+
+    transformKeysKernel<<< gridFor(n), ALGO_BLOCK_SIZE >>>( keys, n, type, descending, false );
+    return true;
+}
@@ -0,0 +1,130 @@
+#include <osg/Notify>
+#include <cuda_runtime.h>
+#include <osgComputeAlgo/CudaSpatialGrid>
+
+extern "C" size_t gridScratchSize( unsigned int n, unsigned int numCells );
+
+extern "C" bool gridBuild( 
+    const float* positions, unsigned int stride, unsigned int n, 
+    float originX, float originY, float originZ, float cellSize, 
+    unsigned int dimX, unsigned int dimY, unsigned int dimZ,
+    unsigned int* cellStart, unsigned int* cellEnd, unsigned int* indices, 
+    void* scratch, size_t scratchSize );
+
+namespace osgCuda
+{
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    SpatialGrid::SpatialGrid()
+        : osgCompute::SpatialGrid(),
+          _scratch( NULL ),
+          _scratchSize( 0 )
+    {
+        clearLocal();
+        // Please note that virtual functions className() and libraryName() are called
+        // during observeResource() which will only develop until this class.
+        // However if contructor of a subclass calls this function again observeResource
+        // will change the className and libraryName of the observed pointer.
+        osgCompute::ResourceObserver::instance()->observeResource( *this );
+    }
+
+    //------------------------------------------------------------------------------
+    bool SpatialGrid::build( osgCompute::Memory& positions, size_t count /*= 0*/ )
+    {
+        if( count == 0 )
+            count = positions.getNumElements();
+
+        if( !checkBuild( positions, count ) )
+            return false;
+
+        unsigned int numCells = static_cast<unsigned int>( getNumCells() );
+        if( !allocScratch( gridScratchSize( static_cast<unsigned int>(count), numCells ) ) )
+            return false;
+
+        const float* pos = static_cast<const float*>( positions.map( osgCompute::MAP_DEVICE_SOURCE ) );
+        unsigned int* cellStart = static_cast<unsigned int*>( _cellStart->map( osgCompute::MAP_DEVICE_TARGET ) );
+        unsigned int* cellEnd = static_cast<unsigned int*>( _cellEnd->map( osgCompute::MAP_DEVICE_TARGET ) );
+        unsigned int* indices = static_cast<unsigned int*>( _indices->map( osgCompute::MAP_DEVICE_TARGET ) );
+        if( (pos == NULL && count > 0) || cellStart == NULL || cellEnd == NULL || indices == NULL )
+            return false;
+
+        return gridBuild( pos, positions.getElementSize() / sizeof(float), static_cast<unsigned int>(count),
+                          _origin.x(), _origin.y(), _origin.z(), _cellSize, 
+                          _dimensions[0], _dimensions[1], _dimensions[2],
+                          cellStart, cellEnd, indices, _scratch, _scratchSize );
+    }
+
+    //------------------------------------------------------------------------------
+    void SpatialGrid::clear()
+    {
+        clearLocal();
+        osgCompute::SpatialGrid::clear();
+    }
+
+    //------------------------------------------------------------------------------
+    void SpatialGrid::releaseObjects()
+    {
+        if( _scratch != NULL )
+        {
+            cudaError res = cudaFree( _scratch );
+            if( res != cudaSuccess )
+            {
+                osg::notify(osg::FATAL)
+                    <<__FUNCTION__ << ": error during cudaFree(). "
+                    <<cudaGetErrorString(res)<<std::endl;
+            }
+        }
+
+        _scratch = NULL;
+        _scratchSize = 0;
+        osgCompute::SpatialGrid::releaseObjects();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PROTECTED FUNCTIONS //////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    SpatialGrid::~SpatialGrid()
+    {
+        clearLocal();
+    }
+
+    //------------------------------------------------------------------------------
+    void SpatialGrid::clearLocal()
+    {
+        if( _scratch != NULL )
+            cudaFree( _scratch );
+
+        _scratch = NULL;
+        _scratchSize = 0;
+    }
+
+    //------------------------------------------------------------------------------
+    bool SpatialGrid::allocScratch( size_t scratchSize )
+    {
+        if( scratchSize <= _scratchSize )
+            return true;
+
+        if( _scratch != NULL )
+            cudaFree( _scratch );
+
+        _scratch = NULL;
+        _scratchSize = 0;
+
+        cudaError res = cudaMalloc( &_scratch, scratchSize );
+        if( res != cudaSuccess )
+        {
+            osg::notify(osg::FATAL)
+                << __FUNCTION__ << " " << getName() << ": error during cudaMalloc(). "
+                << cudaGetErrorString(res) << std::endl;
+
+            _scratch = NULL;
+            return false;
+        }
+
+        _scratchSize = scratchSize;
+        return true;
+    }
+}
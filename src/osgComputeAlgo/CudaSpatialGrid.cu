@@ -0,0 +1,161 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+
+#include <cuda_runtime.h>
+
+#define GRID_BLOCK_SIZE     256
+
+// Values of osgCompute::Primitives::DataType and Operation
+#define GRID_TYPE_UINT      1
+#define GRID_OP_SUM         0
+
+// See CudaPrimitives.cu
+extern "C" size_t algoScratchSize( unsigned int n );
+extern "C" bool algoScan( const void* in, void* out, unsigned int n, unsigned int type, unsigned int op, bool inclusive, void* scratch, size_t scratchSize );
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// DEVICE FUNCTIONS //////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+inline __device__
+unsigned int gridIndex()
+{
+    return (blockIdx.y * gridDim.x + blockIdx.x) * blockDim.x + threadIdx.x;
+}
+
+//------------------------------------------------------------------------------
+// Must match osgCompute::SpatialGrid::getCell()
+inline __device__
+unsigned int cellCoord( float pos, float origin, float cellSize, unsigned int dim )
+{
+    float c = floorf( (pos - origin) / cellSize );
+    if( !(c > 0.0f) ) 
+        return 0;
+    else if( c >= float(dim - 1) )
+        return dim - 1;
+    else
+        return (unsigned int)c;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// GLOBAL FUNCTIONS //////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+__global__
+void gridCellKernel( const float* positions, unsigned int stride, unsigned int n, 
+                     float3 origin, float cellSize, uint3 dims, 
+                     unsigned int* counts, unsigned int* cells, unsigned int* ranks )
+{
+    unsigned int idx = gridIndex();
+    if( idx >= n )
+        return;
+
+    const float* pos = &positions[idx * stride];
+    unsigned int cell = cellCoord( pos[0], origin.x, cellSize, dims.x ) +
+                        (cellCoord( pos[1], origin.y, cellSize, dims.y ) + 
+                         cellCoord( pos[2], origin.z, cellSize, dims.z ) * dims.y) * dims.x;
+
+    // The rank of the particle within its cell 
+    // determines its position in the index list
+    cells[idx] = cell;
+    ranks[idx] = atomicAdd( &counts[cell], 1 );
+}
+
+//------------------------------------------------------------------------------
+__global__
+void gridScatterKernel( const unsigned int* cells, const unsigned int* ranks, const unsigned int* cellStart, unsigned int* indices, unsigned int n )
+{
+    unsigned int idx = gridIndex();
+    if( idx >= n )
+        return;
+
+    indices[cellStart[cells[idx]] + ranks[idx]] = idx;
+}
+
+//------------------------------------------------------------------------------
+__global__
+void gridEndKernel( const unsigned int* cellStart, unsigned int* cellEnd, unsigned int numCells )
+{
+    unsigned int idx = gridIndex();
+    if( idx >= numCells )
+        return;
+
+    // Cell end holds the number of particles so far
+    cellEnd[idx] += cellStart[idx];
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// HOST FUNCTIONS ////////////////////////////////////////////////////////////////////////////////////////////
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//------------------------------------------------------------------------------
+static size_t gridBytes( size_t n )
+{
+    return (n * sizeof(unsigned int) + 255) & ~size_t(255);
+}
+
+//------------------------------------------------------------------------------
+static dim3 gridFor( unsigned int n )
+{
+    // Grids are limited to 65535 blocks per dimension
+    unsigned int numBlocks = (n + GRID_BLOCK_SIZE - 1) / GRID_BLOCK_SIZE;
+    if( numBlocks <= 65535 )
+        return dim3( numBlocks, 1, 1 );
+
+    unsigned int rows = (numBlocks + 65534) / 65535;
+    return dim3( (numBlocks + rows - 1) / rows, rows, 1 );
+}
+
+//------------------------------------------------------------------------------
+extern "C" __host__
+size_t gridScratchSize( unsigned int n, unsigned int numCells )
+{
+    return 2 * gridBytes( n ) + algoScratchSize( numCells );
+}
+
+//------------------------------------------------------------------------------
+extern "C" __host__
+bool gridBuild( const float* positions, unsigned int stride, unsigned int n, 
+                float originX, float originY, float originZ, float cellSize, 
+                unsigned int dimX, unsigned int dimY, unsigned int dimZ,
+                unsigned int* cellStart, unsigned int* cellEnd, unsigned int* indices, 
+                void* scratch, size_t scratchSize )
+{
+    unsigned int numCells = dimX * dimY * dimZ;
+    if( scratchSize < gridScratchSize( n, numCells ) )
+        return false;
+
+    unsigned int* cells = static_cast<unsigned int*>( scratch );
+    unsigned int* ranks = reinterpret_cast<unsigned int*>( static_cast<char*>(scratch) + gridBytes( n ) );
+    void* scanScratch = static_cast<char*>(scratch) + 2 * gridBytes( n );
+
+    // Count the particles of each cell within cell end
+    if( cudaMemset( cellEnd, 0, numCells * sizeof(unsigned int) ) != cudaSuccess )
+        return false;
+
+    if( n > 0 )
+        gridCellKernel<<< gridFor(n), GRID_BLOCK_SIZE >>>( positions, stride, n, 
+            make_float3( originX, originY, originZ ), cellSize, make_uint3( dimX, dimY, dimZ ), 
+            cellEnd, cells, ranks );
+
+    // Cell start is the exclusive prefix sum of the counts
+    if( !algoScan( cellEnd, cellStart, numCells, GRID_TYPE_UINT, GRID_OP_SUM, false, scanScratch, scratchSize - 2 * gridBytes( n ) ) )
+        return false;
+
+    if( n > 0 )
+        gridScatterKernel<<< gridFor(n), GRID_BLOCK_SIZE >>>( cells, ranks, cellStart, indices, n );
+
+    gridEndKernel<<< gridFor(numCells), GRID_BLOCK_SIZE >>>( cellStart, cellEnd, numCells );
+    return true;
+}
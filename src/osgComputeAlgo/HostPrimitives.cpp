@@ -0,0 +1,918 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+
+#include <string.h>
+#include <algorithm>
+#include <limits>
+#include <vector>
+#include <osg/Notify>
+#include <OpenThreads/Thread>
+#include <osgCompute/HostWorkers>
+#include <osgComputeAlgo/HostPrimitives>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#   define OSGCOMPUTEALGO_SSE 1
+#   include <emmintrin.h>
+#endif
+
+namespace osgCompute
+{
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // OPERATIONS ///////////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    template<typename T> struct SumOp
+    {
+        static T identity() { return T(0); }
+        static T apply( T a, T b ) { return a + b; }
+    };
+
+    //------------------------------------------------------------------------------
+    template<typename T> struct MinOp
+    {
+        static T identity() 
+        { 
+            return std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : (std::numeric_limits<T>::max)(); 
+        }
+        static T apply( T a, T b ) { return (b < a)? b : a; }
+    };
+
+    //------------------------------------------------------------------------------
+    template<typename T> struct MaxOp
+    {
+        static T identity() 
+        { 
+            return std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : (std::numeric_limits<T>::min)(); 
+        }
+        static T apply( T a, T b ) { return (a < b)? b : a; }
+    };
+
+    //------------------------------------------------------------------------------
+    template<typename T, typename Op> struct RangeReducer
+    {
+        static T reduce( const T* data, size_t n )
+        {
+            // Independent accumulators allow the 
+            // compiler to vectorize the loop
+            T acc0 = Op::identity(), acc1 = Op::identity(), acc2 = Op::identity(), acc3 = Op::identity();
+
+            size_t i = 0;
+            for( ; i + 4 <= n; i += 4 )
+            {
+                acc0 = Op::apply( acc0, data[i] );
+                acc1 = Op::apply( acc1, data[i+1] );
+                acc2 = Op::apply( acc2, data[i+2] );
+                acc3 = Op::apply( acc3, data[i+3] );
+            }
+            for( ; i < n; ++i )
+                acc0 = Op::apply( acc0, data[i] );
+
+            return Op::apply( Op::apply( acc0, acc1 ), Op::apply( acc2, acc3 ) );
+        }
+    };
+
+#if defined(OSGCOMPUTEALGO_SSE)
+    //------------------------------------------------------------------------------
+    template<typename Op> struct SSEFloatReducer
+    {
+        static float reduce( const float* data, size_t n )
+        {
+            __m128 acc = _mm_set1_ps( Op::identity() );
+
+            size_t i = 0;
+            for( ; i + 4 <= n; i += 4 )
+                acc = Op::apply( acc, _mm_loadu_ps( &data[i] ) );
+
+            float lanes[4];
+            _mm_storeu_ps( lanes, acc );
+            float result = Op::apply( Op::apply( lanes[0], lanes[1] ), Op::apply( lanes[2], lanes[3] ) );
+            for( ; i < n; ++i )
+                result = Op::apply( result, data[i] );
+
+            return result;
+        }
+    };
+
+    struct SSESumOp : public SumOp<float> { using SumOp<float>::apply; static __m128 apply( __m128 a, __m128 b ) { return _mm_add_ps( a, b ); } };
+    struct SSEMinOp : public MinOp<float> { using MinOp<float>::apply; static __m128 apply( __m128 a, __m128 b ) { return _mm_min_ps( a, b ); } };
+    struct SSEMaxOp : public MaxOp<float> { using MaxOp<float>::apply; static __m128 apply( __m128 a, __m128 b ) { return _mm_max_ps( a, b ); } };
+
+    template<> struct RangeReducer< float, SumOp<float> > : public SSEFloatReducer<SSESumOp> {};
+    template<> struct RangeReducer< float, MinOp<float> > : public SSEFloatReducer<SSEMinOp> {};
+    template<> struct RangeReducer< float, MaxOp<float> > : public SSEFloatReducer<SSEMaxOp> {};
+
+    //------------------------------------------------------------------------------
+    template<typename T> struct SSEIntSumReducer
+    {
+        static T reduce( const T* data, size_t n )
+        {
+            // Two's complement addition is the same 
+            // for signed and unsigned integers
+            __m128i acc = _mm_setzero_si128();
+
+            size_t i = 0;
+            for( ; i + 4 <= n; i += 4 )
+                acc = _mm_add_epi32( acc, _mm_loadu_si128( reinterpret_cast<const __m128i*>( &data[i] ) ) );
+
+            T lanes[4];
+            _mm_storeu_si128( reinterpret_cast<__m128i*>( lanes ), acc );
+            T result = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+            for( ; i < n; ++i )
+                result += data[i];
+
+            return result;
+        }
+    };
+
+    template<> struct RangeReducer< int, SumOp<int> > : public SSEIntSumReducer<int> {};
+    template<> struct RangeReducer< unsigned int, SumOp<unsigned int> > : public SSEIntSumReducer<unsigned int> {};
+#endif
+
+    //------------------------------------------------------------------------------
+    static void chunk( size_t count, unsigned int thread, unsigned int numThreads, size_t& begin, size_t& end )
+    {
+        // Chunks are multiples of 16 elements
+        HostWorkers::getRange( count, 16, thread, numThreads, begin, end );
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // JOBS /////////////////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    template<typename T, typename Op>
+    class ReduceJob : public HostJob
+    {
+    public:
+        ReduceJob( const T* data, size_t count, unsigned int numThreads ) 
+            : _data( data ), _count( count ), _partials( numThreads, Op::identity() ) {}
+
+        virtual void execute( unsigned int thread, unsigned int numThreads )
+        {
+            size_t begin, end;
+            chunk( _count, thread, numThreads, begin, end );
+            _partials[thread] = RangeReducer<T,Op>::reduce( _data + begin, end - begin );
+        }
+
+        T getResult() const
+        {
+            T result = Op::identity();
+            for( unsigned int t=0; t<_partials.size(); ++t )
+                result = Op::apply( result, _partials[t] );
+
+            return result;
+        }
+
+    private:
+        const T*        _data;
+        size_t          _count;
+        std::vector<T>  _partials;
+    };
+
+    //------------------------------------------------------------------------------
+    template<typename T, typename Op>
+    class ScanJob : public HostJob
+    {
+    public:
+        ScanJob( const T* in, T* out, size_t count, bool inclusive, unsigned int numThreads ) 
+            : _in( in ), _out( out ), _count( count ), _inclusive( inclusive ), 
+              _carries( numThreads, Op::identity() ), _phase( 0 ) {}
+
+        virtual void execute( unsigned int thread, unsigned int numThreads )
+        {
+            size_t begin, end;
+            chunk( _count, thread, numThreads, begin, end );
+
+            if( _phase == 0 )
+            {
+                _carries[thread] = RangeReducer<T,Op>::reduce( _in + begin, end - begin );
+                return;
+            }
+
+            T carry = _carries[thread];
+            for( size_t i=begin; i<end; ++i )
+            {
+                T next = Op::apply( carry, _in[i] );
+                _out[i] = _inclusive ? next : carry;
+                carry = next;
+            }
+        }
+
+        void nextPhase()
+        {
+            // Turn the totals of the chunks into 
+            // the carries of the chunks
+            T carry = Op::identity();
+            for( unsigned int t=0; t<_carries.size(); ++t )
+            {
+                T total = _carries[t];
+                _carries[t] = carry;
+                carry = Op::apply( carry, total );
+            }
+
+            _phase = 1;
+        }
+
+    private:
+        const T*        _in;
+        T*              _out;
+        size_t          _count;
+        bool            _inclusive;
+        std::vector<T>  _carries;
+        unsigned int    _phase;
+    };
+
+    //------------------------------------------------------------------------------
+    template<typename T, typename Op>
+    class SegmentedScanJob : public HostJob
+    {
+    public:
+        SegmentedScanJob( const T* in, const unsigned int* flags, T* out, size_t count, bool inclusive, unsigned int numThreads ) 
+            : _in( in ), _flags( flags ), _out( out ), _count( count ), _inclusive( inclusive ), 
+              _carries( numThreads, Op::identity() ), _heads( numThreads, 0 ), _phase( 0 ) {}
+
+        virtual void execute( unsigned int thread, unsigned int numThreads )
+        {
+            size_t begin, end;
+            chunk( _count, thread, numThreads, begin, end );
+
+            if( _phase == 0 )
+            {
+                // Total of the last segment of the chunk
+                T total = Op::identity();
+                for( size_t i=begin; i<end; ++i )
+                {
+                    if( _flags[i] != 0 )
+                    {
+                        _heads[thread] = 1;
+                        total = _in[i];
+                    }
+                    else
+                    {
+                        total = Op::apply( total, _in[i] );
+                    }
+                }
+
+                _carries[thread] = total;
+                return;
+            }
+
+            T carry = _carries[thread];
+            for( size_t i=begin; i<end; ++i )
+            {
+                if( _flags[i] != 0 || i == 0 )
+                    carry = Op::identity();
+
+                T next = Op::apply( carry, _in[i] );
+                _out[i] = _inclusive ? next : carry;
+                carry = next;
+            }
+        }
+
+        void nextPhase()
+        {
+            T carry = Op::identity();
+            for( unsigned int t=0; t<_carries.size(); ++t )
+            {
+                T total = _carries[t];
+                _carries[t] = carry;
+                carry = (_heads[t] != 0)? total : Op::apply( carry, total );
+            }
+
+            _phase = 1;
+        }
+
+    private:
+        const T*                    _in;
+        const unsigned int*         _flags;
+        T*                          _out;
+        size_t                      _count;
+        bool                        _inclusive;
+        std::vector<T>              _carries;
+        std::vector<unsigned char>  _heads;
+        unsigned int                _phase;
+    };
+
+    //------------------------------------------------------------------------------
+    template<typename T, typename Op>
+    class SegmentedReduceJob : public HostJob
+    {
+    public:
+        SegmentedReduceJob( const T* in, size_t count, const unsigned int* offsets, T* out, size_t numSegments ) 
+            : _in( in ), _count( count ), _offsets( offsets ), _out( out ), _numSegments( numSegments ) {}
+
+        virtual void execute( unsigned int thread, unsigned int numThreads )
+        {
+            size_t begin, end;
+            chunk( _numSegments, thread, numThreads, begin, end );
+
+            for( size_t s=begin; s<end; ++s )
+            {
+                size_t first = (std::min)( size_t(_offsets[s]), _count );
+                size_t last = (std::min)( size_t(_offsets[s+1]), _count );
+                _out[s] = (first < last)? RangeReducer<T,Op>::reduce( _in + first, last - first ) : Op::identity();
+            }
+        }
+
+    private:
+        const T*            _in;
+        size_t              _count;
+        const unsigned int* _offsets;
+        T*                  _out;
+        size_t              _numSegments;
+    };
+
+    //------------------------------------------------------------------------------
+    class CompactJob : public HostJob
+    {
+    public:
+        CompactJob( const char* in, const unsigned int* flags, char* out, size_t count, unsigned int elementSize, unsigned int numThreads ) 
+            : _in( in ), _flags( flags ), _out( out ), _count( count ), _elementSize( elementSize ), _capacity( 0 ),
+              _offsets( numThreads, 0 ), _numSelected( 0 ), _phase( 0 ) {}
+
+        virtual void execute( unsigned int thread, unsigned int numThreads )
+        {
+            size_t begin, end;
+            chunk( _count, thread, numThreads, begin, end );
+
+            if( _phase == 0 )
+            {
+                size_t numSelected = 0;
+                for( size_t i=begin; i<end; ++i )
+                    numSelected += (_flags[i] != 0)? 1 : 0;
+
+                _offsets[thread] = numSelected;
+                return;
+            }
+
+            // Elements which do not fit are dropped
+            size_t dst = _offsets[thread];
+            if( _elementSize == sizeof(unsigned int) )
+            {
+                const unsigned int* in = reinterpret_cast<const unsigned int*>( _in );
+                unsigned int* out = reinterpret_cast<unsigned int*>( _out );
+                for( size_t i=begin; i<end && dst<_capacity; ++i )
+                    if( _flags[i] != 0 )
+                        out[dst++] = in[i];
+            }
+            else
+            {
+                for( size_t i=begin; i<end && dst<_capacity; ++i )
+                    if( _flags[i] != 0 )
+                        memcpy( &_out[(dst++) * _elementSize], &_in[i * _elementSize], _elementSize );
+            }
+        }
+
+        void nextPhase()
+        {
+            size_t offset = 0;
+            for( unsigned int t=0; t<_offsets.size(); ++t )
+            {
+                size_t numSelected = _offsets[t];
+                _offsets[t] = offset;
+                offset += numSelected;
+            }
+
+            _numSelected = offset;
+            _phase = 1;
+        }
+
+        size_t getNumSelected() const { return _numSelected; }
+        void setOutput( char* out, size_t capacity ) { _out = out; _capacity = capacity; }
+
+    private:
+        const char*                 _in;
+        const unsigned int*         _flags;
+        char*                       _out;
+        size_t                      _count;
+        unsigned int                _elementSize;
+        size_t                      _capacity;
+        std::vector<size_t>         _offsets;
+        size_t                      _numSelected;
+        unsigned int                _phase;
+    };
+
+    //------------------------------------------------------------------------------
+    class RadixSortJob : public HostJob
+    {
+    public:
+        RadixSortJob( unsigned int* keys, unsigned int* values, unsigned int* tmpKeys, unsigned int* tmpValues, size_t count, unsigned int numThreads ) 
+            : _keys( keys ), _values( values ), _tmpKeys( tmpKeys ), _tmpValues( tmpValues ), _count( count ), 
+              _offsets( numThreads * 256 ), _shift( 0 ), _phase( 0 ) {}
+
+        virtual void execute( unsigned int thread, unsigned int numThreads )
+        {
+            size_t begin, end;
+            chunk( _count, thread, numThreads, begin, end );
+
+            size_t* offsets = &_offsets[thread * 256];
+            if( _phase == 0 )
+            {
+                for( unsigned int d=0; d<256; ++d )
+                    offsets[d] = 0;
+
+                for( size_t i=begin; i<end; ++i )
+                    ++offsets[ (_keys[i] >> _shift) & 0xFF ];
+
+                return;
+            }
+
+            // Elements of a chunk keep their order
+            // and so the sort is stable
+            for( size_t i=begin; i<end; ++i )
+            {
+                unsigned int key = _keys[i];
+                size_t dst = offsets[ (key >> _shift) & 0xFF ]++;
+                _tmpKeys[dst] = key;
+                if( _values != NULL )
+                    _tmpValues[dst] = _values[i];
+            }
+        }
+
+        bool nextPhase()
+        {
+            // Digits are placed one after another and within 
+            // a digit the chunks are placed in their order
+            unsigned int numThreads = _offsets.size() / 256;
+            size_t offset = 0;
+            for( unsigned int d=0; d<256; ++d )
+            {
+                size_t digitCount = 0;
+                for( unsigned int t=0; t<numThreads; ++t )
+                {
+                    size_t count = _offsets[t * 256 + d];
+                    _offsets[t * 256 + d] = offset;
+                    offset += count;
+                    digitCount += count;
+                }
+
+                // All keys share the same digit
+                if( digitCount == _count )
+                    return false;
+            }
+
+            _phase = 1;
+            return true;
+        }
+
+        void nextPass( unsigned int shift )
+        {
+            if( _phase == 1 )
+            {
+                std::swap( _keys, _tmpKeys );
+                std::swap( _values, _tmpValues );
+            }
+
+            _shift = shift;
+            _phase = 0;
+        }
+
+        unsigned int* getKeys() const { return _keys; }
+        unsigned int* getValues() const { return _values; }
+
+    private:
+        unsigned int*           _keys;
+        unsigned int*           _values;
+        unsigned int*           _tmpKeys;
+        unsigned int*           _tmpValues;
+        size_t                  _count;
+        std::vector<size_t>     _offsets;
+        unsigned int            _shift;
+        unsigned int            _phase;
+    };
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // DISPATCH /////////////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    template<typename T, typename Op>
+    static void reduceTyped( HostWorkers& workers, const void* input, void* result, size_t count )
+    {
+        ReduceJob<T,Op> job( static_cast<const T*>(input), count, workers.getNumThreads() );
+        workers.run( job );
+        *static_cast<T*>(result) = job.getResult();
+    }
+
+    //------------------------------------------------------------------------------
+    template<typename T, typename Op>
+    static void scanTyped( HostWorkers& workers, const void* input, void* output, size_t count, bool inclusive )
+    {
+        ScanJob<T,Op> job( static_cast<const T*>(input), static_cast<T*>(output), count, inclusive, workers.getNumThreads() );
+        if( workers.getNumThreads() > 1 )
+            workers.run( job );
+
+        job.nextPhase();
+        workers.run( job );
+    }
+
+    //------------------------------------------------------------------------------
+    template<typename T, typename Op>
+    static void segmentedScanTyped( HostWorkers& workers, const void* input, const unsigned int* flags, void* output, size_t count, bool inclusive )
+    {
+        SegmentedScanJob<T,Op> job( static_cast<const T*>(input), flags, static_cast<T*>(output), count, inclusive, workers.getNumThreads() );
+        if( workers.getNumThreads() > 1 )
+            workers.run( job );
+
+        job.nextPhase();
+        workers.run( job );
+    }
+
+    //------------------------------------------------------------------------------
+    template<typename T, typename Op>
+    static void segmentedReduceTyped( HostWorkers& workers, const void* input, size_t count, const unsigned int* offsets, void* output, size_t numSegments )
+    {
+        SegmentedReduceJob<T,Op> job( static_cast<const T*>(input), count, offsets, static_cast<T*>(output), numSegments );
+        workers.run( job );
+    }
+
+    //------------------------------------------------------------------------------
+    static unsigned int toRadixKey( unsigned int key, Primitives::DataType type, bool descending )
+    {
+        // Map signed integers and floats to unsigned 
+        // integers of the same order
+        if( type == Primitives::TYPE_INT )
+            key ^= 0x80000000u;
+        else if( type == Primitives::TYPE_FLOAT )
+            key = (key & 0x80000000u)? ~key : (key | 0x80000000u);
+
+        return descending? ~key : key;
+    }
+
+    //------------------------------------------------------------------------------
+    static unsigned int fromRadixKey( unsigned int key, Primitives::DataType type, bool descending )
+    {
+        if( descending )
+            key = ~key;
+
+        if( type == Primitives::TYPE_INT )
+            key ^= 0x80000000u;
+        else if( type == Primitives::TYPE_FLOAT )
+            key = (key & 0x80000000u)? (key & 0x7FFFFFFFu) : ~key;
+
+        return key;
+    }
+
+    //------------------------------------------------------------------------------
+    static void* mapTarget( Memory& output, const Memory& input )
+    {
+        // Memory which is read and written must be synchronized
+        return output.map( (&output == &input)? MAP_HOST : MAP_HOST_TARGET );
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    HostPrimitives::HostPrimitives()
+        : Primitives(),
+          _workers( NULL )
+    {
+        clearLocal();
+        // Please note that virtual functions className() and libraryName() are called
+        // during observeResource() which will only develop until this class.
+        // However if contructor of a subclass calls this function again observeResource
+        // will change the className and libraryName of the observed pointer.
+        ResourceObserver::instance()->observeResource( *this );
+    }
+
+    //------------------------------------------------------------------------------
+    void HostPrimitives::setNumThreads( unsigned int numThreads )
+    {
+        if( numThreads == _numThreads )
+            return;
+
+        _workers = NULL;
+        _numThreads = numThreads;
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int HostPrimitives::getNumThreads() const
+    {
+        if( _numThreads != 0 )
+            return _numThreads;
+
+        int numProcessors = OpenThreads::GetNumberOfProcessors();
+        return (numProcessors > 0)? static_cast<unsigned int>(numProcessors) : 1;
+    }
+
+    //------------------------------------------------------------------------------
+    bool HostPrimitives::reduce( Memory& input, Memory& result, DataType type, Operation op /*= OP_SUM*/, size_t count /*= 0*/ )
+    {
+        count = getCount( input, count );
+        if( !checkMemory( input, 4, count ) || !checkMemory( result, 4, 1 ) )
+            return false;
+
+        const void* in = input.map( MAP_HOST_SOURCE );
+        void* out = mapTarget( result, input );
+        if( in == NULL || out == NULL )
+            return false;
+
+        switch( type )
+        {
+        case TYPE_INT:
+            if( op == OP_MIN ) reduceTyped< int, MinOp<int> >( workers(), in, out, count );
+            else if( op == OP_MAX ) reduceTyped< int, MaxOp<int> >( workers(), in, out, count );
+            else reduceTyped< int, SumOp<int> >( workers(), in, out, count );
+            break;
+        case TYPE_UINT:
+            if( op == OP_MIN ) reduceTyped< unsigned int, MinOp<unsigned int> >( workers(), in, out, count );
+            else if( op == OP_MAX ) reduceTyped< unsigned int, MaxOp<unsigned int> >( workers(), in, out, count );
+            else reduceTyped< unsigned int, SumOp<unsigned int> >( workers(), in, out, count );
+            break;
+        case TYPE_FLOAT:
+            if( op == OP_MIN ) reduceTyped< float, MinOp<float> >( workers(), in, out, count );
+            else if( op == OP_MAX ) reduceTyped< float, MaxOp<float> >( workers(), in, out, count );
+            else reduceTyped< float, SumOp<float> >( workers(), in, out, count );
+            break;
+        }
+
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    bool HostPrimitives::inclusiveScan( Memory& input, Memory& output, DataType type, Operation op /*= OP_SUM*/, size_t count /*= 0*/ )
+    {
+        return scan( input, output, type, op, true, count );
+    }
+
+    //------------------------------------------------------------------------------
+    bool HostPrimitives::exclusiveScan( Memory& input, Memory& output, DataType type, Operation op /*= OP_SUM*/, size_t count /*= 0*/ )
+    {
+        return scan( input, output, type, op, false, count );
+    }
+
+    //------------------------------------------------------------------------------
+    bool HostPrimitives::segmentedReduce( Memory& input, Memory& offsets, Memory& output, DataType type, Operation op /*= OP_SUM*/, size_t numSegments /*= 0*/ )
+    {
+        if( numSegments == 0 && offsets.getNumElements() > 0 )
+            numSegments = offsets.getNumElements() - 1;
+
+        if( !checkMemory( input, 4, 0 ) || !checkMemory( offsets, 4, numSegments + 1 ) || !checkMemory( output, 4, numSegments ) )
+            return false;
+
+        if( numSegments == 0 )
+            return true;
+
+        const void* in = input.map( MAP_HOST_SOURCE );
+        const unsigned int* segs = static_cast<const unsigned int*>( offsets.map( MAP_HOST_SOURCE ) );
+        void* out = mapTarget( output, input );
+        if( in == NULL || segs == NULL || out == NULL )
+            return false;
+
+        size_t count = input.getNumElements();
+        switch( type )
+        {
+        case TYPE_INT:
+            if( op == OP_MIN ) segmentedReduceTyped< int, MinOp<int> >( workers(), in, count, segs, out, numSegments );
+            else if( op == OP_MAX ) segmentedReduceTyped< int, MaxOp<int> >( workers(), in, count, segs, out, numSegments );
+            else segmentedReduceTyped< int, SumOp<int> >( workers(), in, count, segs, out, numSegments );
+            break;
+        case TYPE_UINT:
+            if( op == OP_MIN ) segmentedReduceTyped< unsigned int, MinOp<unsigned int> >( workers(), in, count, segs, out, numSegments );
+            else if( op == OP_MAX ) segmentedReduceTyped< unsigned int, MaxOp<unsigned int> >( workers(), in, count, segs, out, numSegments );
+            else segmentedReduceTyped< unsigned int, SumOp<unsigned int> >( workers(), in, count, segs, out, numSegments );
+            break;
+        case TYPE_FLOAT:
+            if( op == OP_MIN ) segmentedReduceTyped< float, MinOp<float> >( workers(), in, count, segs, out, numSegments );
+            else if( op == OP_MAX ) segmentedReduceTyped< float, MaxOp<float> >( workers(), in, count, segs, out, numSegments );
+            else segmentedReduceTyped< float, SumOp<float> >( workers(), in, count, segs, out, numSegments );
+            break;
+        }
+
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    bool HostPrimitives::segmentedScan( Memory& input, Memory& flags, Memory& output, DataType type, Operation op /*= OP_SUM*/, bool inclusive /*= true*/, size_t count /*= 0*/ )
+    {
+        count = getCount( input, count );
+        if( !checkMemory( input, 4, count ) || !checkMemory( flags, 4, count ) || !checkMemory( output, 4, count ) )
+            return false;
+
+        if( count == 0 )
+            return true;
+
+        const void* in = input.map( MAP_HOST_SOURCE );
+        const unsigned int* heads = static_cast<const unsigned int*>( flags.map( MAP_HOST_SOURCE ) );
+        void* out = mapTarget( output, input );
+        if( in == NULL || heads == NULL || out == NULL )
+            return false;
+
+        switch( type )
+        {
+        case TYPE_INT:
+            if( op == OP_MIN ) segmentedScanTyped< int, MinOp<int> >( workers(), in, heads, out, count, inclusive );
+            else if( op == OP_MAX ) segmentedScanTyped< int, MaxOp<int> >( workers(), in, heads, out, count, inclusive );
+            else segmentedScanTyped< int, SumOp<int> >( workers(), in, heads, out, count, inclusive );
+            break;
+        case TYPE_UINT:
+            if( op == OP_MIN ) segmentedScanTyped< unsigned int, MinOp<unsigned int> >( workers(), in, heads, out, count, inclusive );
+            else if( op == OP_MAX ) segmentedScanTyped< unsigned int, MaxOp<unsigned int> >( workers(), in, heads, out, count, inclusive );
+            else segmentedScanTyped< unsigned int, SumOp<unsigned int> >( workers(), in, heads, out, count, inclusive );
+            break;
+        case TYPE_FLOAT:
+            if( op == OP_MIN ) segmentedScanTyped< float, MinOp<float> >( workers(), in, heads, out, count, inclusive );
+            else if( op == OP_MAX ) segmentedScanTyped< float, MaxOp<float> >( workers(), in, heads, out, count, inclusive );
+            else segmentedScanTyped< float, SumOp<float> >( workers(), in, heads, out, count, inclusive );
+            break;
+        }
+
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    bool HostPrimitives::compact( Memory& input, Memory& flags, Memory& output, Memory& numSelected, size_t count /*= 0*/ )
+    {
+        if( &input == &output )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << " " << getName() << ": input and output must be different memory objects."
+                << std::endl;
+
+            return false;
+        }
+
+        count = getCount( input, count );
+        if( !checkMemory( flags, 4, count ) || !checkMemory( output, input.getElementSize(), 0 ) || 
+            !checkMemory( numSelected, 4, 1 ) || !checkMemory( input, 0, count ) )
+            return false;
+
+        const char* in = static_cast<const char*>( input.map( MAP_HOST_SOURCE ) );
+        const unsigned int* selected = static_cast<const unsigned int*>( flags.map( MAP_HOST_SOURCE ) );
+        unsigned int* result = static_cast<unsigned int*>( numSelected.map( MAP_HOST_TARGET ) );
+        if( in == NULL || selected == NULL || result == NULL )
+            return false;
+
+        CompactJob job( in, selected, NULL, count, input.getElementSize(), workers().getNumThreads() );
+        workers().run( job );
+        job.nextPhase();
+
+        if( job.getNumSelected() > output.getNumElements() )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << " " << output.getName() << ": " << job.getNumSelected() 
+                << " elements are selected but output has " << output.getNumElements() << " elements only."
+                << std::endl;
+        }
+
+        char* out = static_cast<char*>( output.map( MAP_HOST_TARGET ) );
+        if( out == NULL )
+            return false;
+
+        job.setOutput( out, output.getNumElements() );
+        workers().run( job );
+
+        *result = static_cast<unsigned int>( job.getNumSelected() );
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    bool HostPrimitives::sortByKey( Memory& keys, Memory* values, DataType type, size_t count /*= 0*/, bool descending /*= false*/, unsigned int keyBits /*= 32*/ )
+    {
+        count = getCount( keys, count );
+        if( !checkMemory( keys, 4, count ) || (values != NULL && !checkMemory( *values, 4, count )) )
+            return false;
+
+        if( count < 2 )
+            return true;
+
+        unsigned int* keyPtr = static_cast<unsigned int*>( keys.map( MAP_HOST ) );
+        unsigned int* valuePtr = (values != NULL)? static_cast<unsigned int*>( values->map( MAP_HOST ) ) : NULL;
+        if( keyPtr == NULL || (values != NULL && valuePtr == NULL) )
+            return false;
+
+        if( type != TYPE_UINT || keyBits > 32 )
+            keyBits = 32;
+
+        // Sort transformed keys within temporary memory. Values
+        // are sorted within temporary memory as well and copied back. 
+        _keys.resize( 2 * count );
+        for( size_t i=0; i<count; ++i )
+            _keys[i] = toRadixKey( keyPtr[i], type, descending );
+
+        if( valuePtr != NULL )
+        {
+            _values.resize( 2 * count );
+            memcpy( &_values[0], valuePtr, count * sizeof(unsigned int) );
+        }
+
+        RadixSortJob job( &_keys[0], (valuePtr != NULL)? &_values[0] : NULL, 
+                          &_keys[count], (valuePtr != NULL)? &_values[count] : NULL, 
+                          count, workers().getNumThreads() );
+
+        for( unsigned int shift=0; shift<keyBits; shift+=8 )
+        {
+            job.nextPass( shift );
+            workers().run( job );
+            if( job.nextPhase() )
+                workers().run( job );
+        }
+        job.nextPass( 0 );
+
+        const unsigned int* sortedKeys = job.getKeys();
+        for( size_t i=0; i<count; ++i )
+            keyPtr[i] = fromRadixKey( sortedKeys[i], type, descending );
+
+        if( valuePtr != NULL )
+            memcpy( valuePtr, job.getValues(), count * sizeof(unsigned int) );
+
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    void HostPrimitives::clear()
+    {
+        clearLocal();
+        Primitives::clear();
+    }
+
+    //------------------------------------------------------------------------------
+    void HostPrimitives::releaseObjects()
+    {
+        _workers = NULL;
+
+        std::vector<unsigned int>().swap( _keys );
+        std::vector<unsigned int>().swap( _values );
+        Primitives::releaseObjects();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PROTECTED FUNCTIONS //////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    HostPrimitives::~HostPrimitives()
+    {
+        clearLocal();
+    }
+
+    //------------------------------------------------------------------------------
+    void HostPrimitives::clearLocal()
+    {
+        _workers = NULL;
+        _numThreads = 0;
+        _keys.clear();
+        _values.clear();
+    }
+
+    //------------------------------------------------------------------------------
+    HostWorkers& HostPrimitives::workers()
+    {
+        if( !_workers.valid() )
+        {
+            if( _numThreads == 0 )
+                _workers = HostWorkers::instance();
+            else
+                _workers = new HostWorkers( _numThreads );
+        }
+
+        return *_workers;
+    }
+
+    //------------------------------------------------------------------------------
+    bool HostPrimitives::scan( Memory& input, Memory& output, DataType type, Operation op, bool inclusive, size_t count )
+    {
+        count = getCount( input, count );
+        if( !checkMemory( input, 4, count ) || !checkMemory( output, 4, count ) )
+            return false;
+
+        if( count == 0 )
+            return true;
+
+        const void* in = input.map( MAP_HOST_SOURCE );
+        void* out = mapTarget( output, input );
+        if( in == NULL || out == NULL )
+            return false;
+
+        switch( type )
+        {
+        case TYPE_INT:
+            if( op == OP_MIN ) scanTyped< int, MinOp<int> >( workers(), in, out, count, inclusive );
+            else if( op == OP_MAX ) scanTyped< int, MaxOp<int> >( workers(), in, out, count, inclusive );
+            else scanTyped< int, SumOp<int> >( workers(), in, out, count, inclusive );
+            break;
+        case TYPE_UINT:
+            if( op == OP_MIN ) scanTyped< unsigned int, MinOp<unsigned int> >( workers(), in, out, count, inclusive );
+            else if( op == OP_MAX ) scanTyped< unsigned int, MaxOp<unsigned int> >( workers(), in, out, count, inclusive );
+            else scanTyped< unsigned int, SumOp<unsigned int> >( workers(), in, out, count, inclusive );
+            break;
+        case TYPE_FLOAT:
+            if( op == OP_MIN ) scanTyped< float, MinOp<float> >( workers(), in, out, count, inclusive );
+            else if( op == OP_MAX ) scanTyped< float, MaxOp<float> >( workers(), in, out, count, inclusive );
+            else scanTyped< float, SumOp<float> >( workers(), in, out, count, inclusive );
+            break;
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,118 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+
+#include <string.h>
+#include <osg/Notify>
+#include <osgComputeAlgo/HostSpatialGrid>
+
+namespace osgCompute
+{
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    HostSpatialGrid::HostSpatialGrid()
+        : SpatialGrid()
+    {
+        clearLocal();
+        // Please note that virtual functions className() and libraryName() are called
+        // during observeResource() which will only develop until this class.
+        // However if contructor of a subclass calls this function again observeResource
+        // will change the className and libraryName of the observed pointer.
+        ResourceObserver::instance()->observeResource( *this );
+    }
+
+    //------------------------------------------------------------------------------
+    bool HostSpatialGrid::build( Memory& positions, size_t count /*= 0*/ )
+    {
+        if( count == 0 )
+            count = positions.getNumElements();
+
+        if( !checkBuild( positions, count ) )
+            return false;
+
+        const float* pos = static_cast<const float*>( positions.map( MAP_HOST_SOURCE ) );
+        unsigned int* cellStart = static_cast<unsigned int*>( _cellStart->map( MAP_HOST_TARGET ) );
+        unsigned int* cellEnd = static_cast<unsigned int*>( _cellEnd->map( MAP_HOST_TARGET ) );
+        unsigned int* indices = static_cast<unsigned int*>( _indices->map( MAP_HOST_TARGET ) );
+        if( (pos == NULL && count > 0) || cellStart == NULL || cellEnd == NULL || indices == NULL )
+            return false;
+
+        /////////////////
+        // COUNT CELLS //
+        /////////////////
+        size_t numCells = getNumCells();
+        memset( cellEnd, 0, numCells * sizeof(unsigned int) );
+
+        size_t stride = positions.getElementSize() / sizeof(float);
+        _cells.resize( count );
+        for( size_t p=0; p<count; ++p, pos+=stride )
+        {
+            _cells[p] = getCell( osg::Vec3f( pos[0], pos[1], pos[2] ) );
+            ++cellEnd[_cells[p]];
+        }
+
+        ////////////////
+        // SCAN CELLS //
+        ////////////////
+        // Cell start is the exclusive prefix sum of the counts
+        unsigned int offset = 0;
+        for( size_t c=0; c<numCells; ++c )
+        {
+            cellStart[c] = offset;
+            offset += cellEnd[c];
+            cellEnd[c] = cellStart[c];
+        }
+
+        /////////////
+        // SCATTER //
+        /////////////
+        // Cell end serves as write position and 
+        // ends up behind the last index of the cell
+        for( size_t p=0; p<count; ++p )
+            indices[cellEnd[_cells[p]]++] = static_cast<unsigned int>( p );
+
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    void HostSpatialGrid::clear()
+    {
+        clearLocal();
+        SpatialGrid::clear();
+    }
+
+    //------------------------------------------------------------------------------
+    void HostSpatialGrid::releaseObjects()
+    {
+        std::vector<unsigned int>().swap( _cells );
+        SpatialGrid::releaseObjects();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PROTECTED FUNCTIONS //////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    HostSpatialGrid::~HostSpatialGrid()
+    {
+        clearLocal();
+    }
+
+    //------------------------------------------------------------------------------
+    void HostSpatialGrid::clearLocal()
+    {
+        _cells.clear();
+    }
+}
@@ -0,0 +1,78 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+
+#include <osg/Notify>
+#include <osgComputeAlgo/Primitives>
+
+namespace osgCompute
+{
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    Primitives::Primitives()
+        : Resource()
+    {
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PROTECTED FUNCTIONS //////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    Primitives::~Primitives()
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    bool Primitives::checkMemory( const Memory& memory, unsigned int elementSize, size_t count ) const
+    {
+        if( elementSize != 0 && memory.getElementSize() != elementSize )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << " " << memory.getName() << ": element size is " << memory.getElementSize()
+                << " but " << elementSize << " is required."
+                << std::endl;
+
+            return false;
+        }
+
+        if( memory.getStorageElementSize() != memory.getElementSize() )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << " " << memory.getName() << ": compact storage formats are not supported."
+                << std::endl;
+
+            return false;
+        }
+
+        if( memory.getNumElements() < count )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << " " << memory.getName() << ": memory has " << memory.getNumElements()
+                << " elements but " << count << " are required."
+                << std::endl;
+
+            return false;
+        }
+
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    size_t Primitives::getCount( const Memory& input, size_t count ) const
+    {
+        return (count != 0)? count : input.getNumElements();
+    }
+}
@@ -0,0 +1,262 @@
+/* osgCompute - Copyright (C) 2008-2009 SVT Group
+*
+* This library is free software; you can redistribute it and/or modify
+* it under the terms of the GNU Lesser General Public License as
+* published by the Free Software Foundation; either version 3 of
+* the License, or (at your option) any later version.
+*
+* This library is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU Lesse General Public License for more details.
+*
+* The full license is in LICENSE file included with this distribution.
+*/
+
+#include <math.h>
+#include <osg/Notify>
+#include <osgComputeAlgo/SpatialGrid>
+
+namespace osgCompute
+{
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    SpatialGrid::SpatialGrid()
+        : Resource()
+    {
+        clearLocal();
+    }
+
+    //------------------------------------------------------------------------------
+    void SpatialGrid::setOrigin( const osg::Vec3f& origin )
+    {
+        _origin = origin;
+    }
+
+    //------------------------------------------------------------------------------
+    const osg::Vec3f& SpatialGrid::getOrigin() const
+    {
+        return _origin;
+    }
+
+    //------------------------------------------------------------------------------
+    void SpatialGrid::setCellSize( float cellSize )
+    {
+        if( cellSize <= 0.0f )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << " " << getName() << ": cell size must be positive."
+                << std::endl;
+
+            return;
+        }
+
+        _cellSize = cellSize;
+    }
+
+    //------------------------------------------------------------------------------
+    float SpatialGrid::getCellSize() const
+    {
+        return _cellSize;
+    }
+
+    //------------------------------------------------------------------------------
+    void SpatialGrid::setDimension( unsigned int dimIdx, unsigned int dimSize )
+    {
+        if( dimIdx > 2 || dimSize == 0 )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << " " << getName() << ": invalid dimension " << dimIdx 
+                << " with " << dimSize << " cells."
+                << std::endl;
+
+            return;
+        }
+
+        _dimensions[dimIdx] = dimSize;
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int SpatialGrid::getDimension( unsigned int dimIdx ) const
+    {
+        return (dimIdx < 3)? _dimensions[dimIdx] : 1;
+    }
+
+    //------------------------------------------------------------------------------
+    size_t SpatialGrid::getNumCells() const
+    {
+        return size_t(_dimensions[0]) * size_t(_dimensions[1]) * size_t(_dimensions[2]);
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int SpatialGrid::getCell( const osg::Vec3f& position ) const
+    {
+        unsigned int cell[3];
+        for( unsigned int d=0; d<3; ++d )
+        {
+            float c = floorf( (position[d] - _origin[d]) / _cellSize );
+            if( !(c > 0.0f) ) // includes NaN
+                cell[d] = 0;
+            else if( c >= float(_dimensions[d] - 1) )
+                cell[d] = _dimensions[d] - 1;
+            else
+                cell[d] = static_cast<unsigned int>( c );
+        }
+
+        return cell[0] + (cell[1] + cell[2] * _dimensions[1]) * _dimensions[0];
+    }
+
+    //------------------------------------------------------------------------------
+    void SpatialGrid::setCellStart( Memory* cellStart )
+    {
+        _cellStart = cellStart;
+    }
+
+    //------------------------------------------------------------------------------
+    Memory* SpatialGrid::getCellStart()
+    {
+        return _cellStart.get();
+    }
+
+    //------------------------------------------------------------------------------
+    const Memory* SpatialGrid::getCellStart() const
+    {
+        return _cellStart.get();
+    }
+
+    //------------------------------------------------------------------------------
+    void SpatialGrid::setCellEnd( Memory* cellEnd )
+    {
+        _cellEnd = cellEnd;
+    }
+
+    //------------------------------------------------------------------------------
+    Memory* SpatialGrid::getCellEnd()
+    {
+        return _cellEnd.get();
+    }
+
+    //------------------------------------------------------------------------------
+    const Memory* SpatialGrid::getCellEnd() const
+    {
+        return _cellEnd.get();
+    }
+
+    //------------------------------------------------------------------------------
+    void SpatialGrid::setIndices( Memory* indices )
+    {
+        _indices = indices;
+    }
+
+    //------------------------------------------------------------------------------
+    Memory* SpatialGrid::getIndices()
+    {
+        return _indices.get();
+    }
+
+    //------------------------------------------------------------------------------
+    const Memory* SpatialGrid::getIndices() const
+    {
+        return _indices.get();
+    }
+
+    //------------------------------------------------------------------------------
+    void SpatialGrid::clear()
+    {
+        clearLocal();
+        Resource::clear();
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PROTECTED FUNCTIONS //////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    SpatialGrid::~SpatialGrid()
+    {
+        clearLocal();
+    }
+
+    //------------------------------------------------------------------------------
+    void SpatialGrid::clearLocal()
+    {
+        _origin.set( 0.0f, 0.0f, 0.0f );
+        _cellSize = 1.0f;
+        _dimensions[0] = 1;
+        _dimensions[1] = 1;
+        _dimensions[2] = 1;
+        _cellStart = NULL;
+        _cellEnd = NULL;
+        _indices = NULL;
+    }
+
+    //------------------------------------------------------------------------------
+    bool SpatialGrid::checkBuild( const Memory& positions, size_t count ) const
+    {
+        if( !_cellStart.valid() || !_cellEnd.valid() || !_indices.valid() )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << " " << getName() << ": cell start, cell end and indices must be set."
+                << std::endl;
+
+            return false;
+        }
+
+        if( positions.getElementSize() != 3*sizeof(float) && positions.getElementSize() != 4*sizeof(float) )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << " " << positions.getName() << ": positions must consist of three or four floats."
+                << std::endl;
+
+            return false;
+        }
+
+        if( positions.getStorageElementSize() != positions.getElementSize() )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << " " << positions.getName() << ": compact storage formats are not supported."
+                << std::endl;
+
+            return false;
+        }
+
+        // Cells and particles are indexed with unsigned integers
+        if( getNumCells() > 0xFFFFFFFF || count > 0xFFFFFFFF )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << " " << getName() << ": too many cells or particles."
+                << std::endl;
+
+            return false;
+        }
+
+        const Memory* required[3] = { _cellStart.get(), _cellEnd.get(), _indices.get() };
+        size_t numRequired[3] = { getNumCells(), getNumCells(), count };
+        for( unsigned int m=0; m<3; ++m )
+        {
+            if( required[m]->getElementSize() != sizeof(unsigned int) || required[m]->getStorageElementSize() != sizeof(unsigned int) ||
+                required[m]->getNumElements() < numRequired[m] )
+            {
+                osg::notify(osg::WARN)
+                    << __FUNCTION__ << " " << required[m]->getName() << ": memory requires " << numRequired[m] 
+                    << " elements of four bytes."
+                    << std::endl;
+
+                return false;
+            }
+        }
+
+        if( positions.getNumElements() < count )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << " " << positions.getName() << ": memory has " << positions.getNumElements()
+                << " elements but " << count << " are required."
+                << std::endl;
+
+            return false;
+        }
+
+        return true;
+    }
+}
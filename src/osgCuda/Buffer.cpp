@@ -1,10 +1,14 @@
 #include <memory.h>
+#include <vector>
 #if defined(__linux)
 #include <malloc.h>
 #endif
 #include <cuda_runtime.h>
 #include <driver_types.h>
 #include <osg/Notify>
+#include <osgCompute/LaunchPlan>
+#include <osgCompute/MemoryBudget>
+#include <osgCompute/MirrorCompressor>
 #include <osgCuda/Buffer>
 
 namespace osgCuda
@@ -17,7 +21,10 @@ namespace osgCuda
         void*							_devPtr;
         cudaArray*                      _devArray;
         void*							_hostPtr;
+        void*							_packedPtr;
+        size_t                          _packedSize;
         unsigned int                    _modifyCount;
+        unsigned int                    _evictedOp;
 
         BufferObject();
         virtual ~BufferObject();
@@ -37,13 +44,19 @@ namespace osgCuda
         _devPtr(NULL),
         _devArray(NULL),
         _hostPtr(NULL),
-        _modifyCount(UINT_MAX)
+        _packedPtr(NULL),
+        _packedSize(0),
+        _modifyCount(UINT_MAX),
+        _evictedOp(osgCompute::NO_SYNC)
     {
     }
 
     //------------------------------------------------------------------------------
     BufferObject::~BufferObject()
     {
+        if( NULL != _devPtr || NULL != _devArray )
+            osgCompute::MemoryBudget::instance()->release( *this );
+
         if( NULL != _devPtr)
         {
             cudaError res = cudaFree( _devPtr );
@@ -68,6 +81,9 @@ namespace osgCuda
 
         if( NULL != _hostPtr)
             free( _hostPtr );
+
+        if( NULL != _packedPtr )
+            free( _packedPtr );
     }
 
 
@@ -80,6 +96,8 @@ namespace osgCuda
         : osgCompute::Memory()
     {
         memset( &_formatDesc, 0x0, sizeof(cudaChannelFormatDesc) );
+        _serializeData = false;
+        _storageFormat = STORAGE_NATIVE;
         // Please note that virtual functions className() and libraryName() are called
         // during observeResource() which will only develop until this class.
         // However if contructor of a subclass calls this function again observeResource
@@ -88,7 +106,7 @@ namespace osgCuda
     }
 
     //------------------------------------------------------------------------------
-    void* Buffer::map( unsigned int mapping/* = osgCompute::MAP_DEVICE*/, unsigned int offset/* = 0*/, unsigned int hint )
+    void* Buffer::map( unsigned int mapping/* = osgCompute::MAP_DEVICE*/, size_t offset/* = 0*/, unsigned int hint )
     {
         if( mapping == osgCompute::UNMAP )
         {
@@ -96,6 +114,31 @@ namespace osgCuda
             return NULL;
         }
 
+        // Copy deferred content first
+        if( getPayload() != NULL )
+            applyPayload();
+
+        ////////////////////
+        // REPLAY MAPPING //
+        ////////////////////
+        osgCompute::LaunchPlan* plan = osgCompute::LaunchPlan::getActive();
+        const BufferObject* recordedObject = static_cast<const BufferObject*>( object(false) );
+        if( plan != NULL && plan->isReplaying() && recordedObject != NULL && !getSubloadCallback() &&
+            (!_image.valid() || _image->getModifiedCount() == recordedObject->_modifyCount) )
+        {
+            void* recordedPtr = plan->replay( *this, mapping, offset, hint );
+            if( recordedPtr != NULL )
+            {
+                // Replayed mappings count as accesses as well
+                if( mapping & osgCompute::MAP_HOST )
+                    osgCompute::MirrorCompressor::instance()->touch( *this );
+                else
+                    osgCompute::MemoryBudget::instance()->touch( *object(false) );
+
+                return recordedPtr;
+            }
+        }
+
         ////////////////////
         // RECEIVE HANDLE //
         ////////////////////
@@ -103,6 +146,7 @@ namespace osgCuda
         if( !memoryPtr )
             return NULL;
         BufferObject& memory = *memoryPtr;
+        unsigned int lastSyncOp = memory._syncOp;
 
         /////////////////////////////
         // CHECK FOR MODIFICATIONS //
@@ -113,6 +157,25 @@ namespace osgCuda
         if( (_image.valid() && _image->getModifiedCount() != memory._modifyCount ) )
             needsSetup = true;
 
+        ///////////////////////
+        // DECOMPRESS STREAM //
+        ///////////////////////
+        if( memory._packedPtr != NULL )
+        {
+            // Decompress host memory only if it is mapped
+            // or if the device memory is restored from it
+            bool needsHost = false;
+            if( mapping & osgCompute::MAP_HOST )
+                needsHost = true;
+            else if( (mapping & osgCompute::MAP_DEVICE_ARRAY) == osgCompute::MAP_DEVICE_ARRAY )
+                needsHost = (memory._devArray == NULL) || (memory._syncOp & osgCompute::SYNC_ARRAY);
+            else if( mapping & osgCompute::MAP_DEVICE )
+                needsHost = (memory._devPtr == NULL) || (memory._syncOp & osgCompute::SYNC_DEVICE);
+
+            if( needsHost && !decompress() )
+                return NULL;
+        }
+
         // current mapping
         memory._mapping = mapping;
 
@@ -148,6 +211,7 @@ namespace osgCuda
                 if( !sync( mapping ) )
                     return NULL;
 
+            osgCompute::MirrorCompressor::instance()->touch( *this );
             ptr = memory._hostPtr;
         }
         else if( (mapping & osgCompute::MAP_DEVICE_ARRAY) == osgCompute::MAP_DEVICE_ARRAY )
@@ -161,7 +225,9 @@ namespace osgCuda
                 if( !alloc( mapping ) )
                     return NULL;
 
-                firstLoad = true;
+                // evicted memory is restored from the host
+                firstLoad = !(memory._evictedOp & osgCompute::SYNC_ARRAY);
+                memory._evictedOp &= ~osgCompute::SYNC_ARRAY;
             }
 
             //////////////////
@@ -178,6 +244,7 @@ namespace osgCuda
                 if( !sync( mapping ) )
                     return NULL;
 
+            osgCompute::MemoryBudget::instance()->touch( memory );
             ptr = memory._devArray;
         }
 
@@ -192,7 +259,9 @@ namespace osgCuda
                 if( !alloc( mapping ) )
                     return NULL;
 
-                firstLoad = true;
+                // evicted memory is restored from the host
+                firstLoad = !(memory._evictedOp & osgCompute::SYNC_DEVICE);
+                memory._evictedOp &= ~osgCompute::SYNC_DEVICE;
             }
 
             //////////////////
@@ -209,6 +278,7 @@ namespace osgCuda
                 if( !sync( mapping ) )
                     return NULL;
 
+            osgCompute::MemoryBudget::instance()->touch( memory );
             ptr = memory._devPtr;
         }
         else
@@ -258,6 +328,23 @@ namespace osgCuda
             memory._syncOp |= osgCompute::SYNC_DEVICE;
         }
 
+        ////////////////////
+        // RECORD MAPPING //
+        ////////////////////
+        if( plan != NULL && (plan->isRecording() || plan->isReplaying()) )
+        {
+            // Only mappings which return the pointer 
+            // without any further operation can be replayed
+            unsigned int syncFlag = osgCompute::SYNC_DEVICE;
+            if( memory._mapping & osgCompute::MAP_HOST )
+                syncFlag = osgCompute::SYNC_HOST;
+            else if( (mapping & osgCompute::MAP_DEVICE_ARRAY) == osgCompute::MAP_DEVICE_ARRAY )
+                syncFlag = osgCompute::SYNC_ARRAY;
+
+            bool replayable = !firstLoad && !needsSetup && !getSubloadCallback() && !(lastSyncOp & syncFlag);
+            plan->record( *this, mapping, offset, hint, &static_cast<char*>(ptr)[offset], lastSyncOp, replayable );
+        }
+
         return &static_cast<char*>(ptr)[offset];
     }
 
@@ -294,6 +381,14 @@ namespace osgCuda
         memory._modifyCount = UINT_MAX;
         memory._syncOp = osgCompute::NO_SYNC;
 
+        // compressed host memory is outdated
+        if( memory._packedPtr != NULL )
+        {
+            free( memory._packedPtr );
+            memory._packedPtr = NULL;
+            memory._packedSize = 0;
+        }
+
         // clear host memory
         if( memory._hostPtr != NULL )
         {
@@ -313,7 +408,7 @@ namespace osgCuda
             cudaError res;
             if( getNumDimensions() == 3 )
             {
-                cudaPitchedPtr pitchedPtr = make_cudaPitchedPtr( memory._devPtr, memory._pitch, getDimension(0)*getElementSize(), getDimension(1) );
+                cudaPitchedPtr pitchedPtr = make_cudaPitchedPtr( memory._devPtr, memory._pitch, static_cast<size_t>(getDimension(0))*getStorageElementSize(), getDimension(1) );
                 cudaExtent extent = make_cudaExtent( getPitch(), getDimension(1), getDimension(2) );
                 res = cudaMemset3D( pitchedPtr, 0x0, extent );
                 if( res != cudaSuccess )
@@ -329,7 +424,7 @@ namespace osgCuda
             }
             else if( getNumDimensions() == 2 )
             {
-                res = cudaMemset2D( memory._devPtr, memory._pitch, 0x0, getDimension(0)*getElementSize(), getDimension(1) );
+                res = cudaMemset2D( memory._devPtr, memory._pitch, 0x0, static_cast<size_t>(getDimension(0))*getStorageElementSize(), getDimension(1) );
                 if( res != cudaSuccess )
                 {
                     osg::notify(osg::FATAL)
@@ -343,7 +438,7 @@ namespace osgCuda
             }
             else
             {
-                res = cudaMemset( memory._devPtr, 0x0, getAllElementsSize() );
+                res = cudaMemset( memory._devPtr, 0x0, getStorageSize() );
                 if( res != cudaSuccess )
                 {
                     osg::notify(osg::FATAL)
@@ -437,12 +532,16 @@ namespace osgCuda
                 return false;
             }
 
+            // Convert into the storage format
+            std::vector<unsigned char> packed;
+            data = packHost( data, packed );
+
             if( getNumDimensions() == 3 )
             {
                 cudaMemcpy3DParms memCpyParams = {0};
                 memCpyParams.dstArray = memory._devArray;
                 memCpyParams.kind = cudaMemcpyHostToDevice;
-                memCpyParams.srcPtr = make_cudaPitchedPtr((void*)data, getDimension(0)*getElementSize(), getDimension(0), getDimension(1));
+                memCpyParams.srcPtr = make_cudaPitchedPtr((void*)data, static_cast<size_t>(getDimension(0))*getStorageElementSize(), getDimension(0), getDimension(1));
 
                 cudaExtent arrayExtent = {0};
                 arrayExtent.width = getDimension(0);
@@ -464,7 +563,7 @@ namespace osgCuda
             }
             else if( getNumDimensions() == 2 )
             {
-                cudaError res = cudaMemcpy2DToArray( memory._devArray, 0, 0, data, getDimension(0)*getElementSize(), getDimension(0)*getElementSize(), getDimension(1), cudaMemcpyHostToDevice );  
+                cudaError res = cudaMemcpy2DToArray( memory._devArray, 0, 0, data, static_cast<size_t>(getDimension(0))*getStorageElementSize(), static_cast<size_t>(getDimension(0))*getStorageElementSize(), getDimension(1), cudaMemcpyHostToDevice );  
                 if( cudaSuccess != res )
                 {
                     osg::notify(osg::FATAL)
@@ -477,7 +576,7 @@ namespace osgCuda
             }
             else
             {
-                res = cudaMemcpyToArray(memory._devArray, 0, 0, data, getAllElementsSize(), cudaMemcpyHostToDevice);
+                res = cudaMemcpyToArray(memory._devArray, 0, 0, data, getStorageSize(), cudaMemcpyHostToDevice);
                 if( cudaSuccess != res )
                 {
                     osg::notify(osg::FATAL)
@@ -502,7 +601,7 @@ namespace osgCuda
         }
         else if( mapping & osgCompute::MAP_DEVICE )
         {
-            void* data = NULL;
+            const void* data = NULL;
             if( _image.valid() )
             {
                 data = _image->data();
@@ -517,13 +616,16 @@ namespace osgCuda
                 return false;
             }
 
+            // Convert into the storage format
+            std::vector<unsigned char> packed;
+            data = packHost( data, packed );
 
             if( getNumDimensions() == 3 )
             {
                 cudaMemcpy3DParms memcpyParams = {0};
                 memcpyParams.dstPtr = make_cudaPitchedPtr( memory._devPtr, memory._pitch, getDimension(0), getDimension(1) );
-                memcpyParams.srcPtr = make_cudaPitchedPtr( data, getDimension(0) * getElementSize(), getDimension(0), getDimension(1) );
-                memcpyParams.extent = make_cudaExtent( getDimension(0) * getElementSize(), getDimension(1), getDimension(2) );
+                memcpyParams.srcPtr = make_cudaPitchedPtr( (void*)data, static_cast<size_t>(getDimension(0)) * getStorageElementSize(), getDimension(0), getDimension(1) );
+                memcpyParams.extent = make_cudaExtent( static_cast<size_t>(getDimension(0)) * getStorageElementSize(), getDimension(1), getDimension(2) );
                 memcpyParams.kind = cudaMemcpyHostToDevice;
 
                 res = cudaMemcpy3D( &memcpyParams );
@@ -539,7 +641,7 @@ namespace osgCuda
             }
             else if( getNumDimensions() == 2 )
             {
-                res = cudaMemcpy2D( memory._devPtr, memory._pitch, data, getDimension(0) * getElementSize(), getDimension(0), getDimension(1), cudaMemcpyHostToDevice );
+                res = cudaMemcpy2D( memory._devPtr, memory._pitch, data, static_cast<size_t>(getDimension(0)) * getStorageElementSize(), getDimension(0), getDimension(1), cudaMemcpyHostToDevice );
                 if( cudaSuccess != res )
                 {
                     osg::notify(osg::FATAL)
@@ -552,7 +654,7 @@ namespace osgCuda
             }
             else
             {
-                res = cudaMemcpy( memory._devPtr,  data, getAllElementsSize(), cudaMemcpyHostToDevice );
+                res = cudaMemcpy( memory._devPtr,  data, getStorageSize(), cudaMemcpyHostToDevice );
                 if( cudaSuccess != res )
                 {
                     osg::notify(osg::FATAL)
@@ -631,6 +733,17 @@ namespace osgCuda
             return false;
         BufferObject& memory = *memoryPtr;
 
+        // Compact storage formats convert float values
+        if( !(mapping & osgCompute::MAP_HOST) && getStorageFormat() != STORAGE_NATIVE && 
+            (getElementSize() % sizeof(float)) != 0 )
+        {
+            osg::notify(osg::FATAL)
+                << __FUNCTION__ << " " << getName() << ":  storage format requires elements of float values."
+                << std::endl;
+
+            return false;
+        }
+
         //////////////////
         // ALLOC MEMORY //
         //////////////////
@@ -672,6 +785,16 @@ namespace osgCuda
                 return false;
             }
 
+            // Free device memory of cold buffers if necessary
+            if( !osgCompute::MemoryBudget::instance()->reserve( *this, getByteSize( mapping ) ) )
+            {
+                osg::notify(osg::FATAL)
+                    << __FUNCTION__ << " " << getName() << ":  device memory budget exceeded."
+                    << std::endl;
+
+                return false;
+            }
+
             if( getNumDimensions() == 3 )
             {
                 cudaExtent extent;
@@ -718,6 +841,8 @@ namespace osgCuda
                 }
             }
 
+            osgCompute::MemoryBudget::instance()->allocated( *this, memory, getAllocatedByteSize( mapping ) );
+
             if( memory._hostPtr != NULL || memory._devPtr != NULL )
                 memory._syncOp |= osgCompute::SYNC_ARRAY;
 
@@ -728,11 +853,21 @@ namespace osgCuda
             if( memory._devPtr != NULL )
                 return true;
 
+            // Free device memory of cold buffers if necessary
+            if( !osgCompute::MemoryBudget::instance()->reserve( *this, getByteSize( mapping ) ) )
+            {
+                osg::notify(osg::FATAL)
+                    << __FUNCTION__ << " " << getName() << ":  device memory budget exceeded."
+                    << std::endl;
+
+                return false;
+            }
+
             if( getNumDimensions() == 3 )
             {
                 cudaPitchedPtr pitchPtr;
                 cudaExtent extent;
-                extent.width = getDimension(0) * getElementSize();
+                extent.width = static_cast<size_t>(getDimension(0)) * getStorageElementSize();
                 extent.height = getDimension(1);
                 extent.depth = getDimension(2);
 
@@ -756,7 +891,7 @@ namespace osgCuda
             }
             else if( getNumDimensions() == 2 )
             {
-                cudaError_t res = cudaMallocPitch( &memory._devPtr, (size_t*)&memory._pitch, getDimension(0) * getElementSize(), getDimension(1) );
+                cudaError_t res = cudaMallocPitch( &memory._devPtr, (size_t*)&memory._pitch, static_cast<size_t>(getDimension(0)) * getStorageElementSize(), getDimension(1) );
                 if( cudaSuccess != res )
                 {
                     osg::notify(osg::FATAL)
@@ -769,11 +904,11 @@ namespace osgCuda
 
 
                 // clear memory
-                cudaMemset2D( memory._devPtr, memory._pitch, 0x0, getDimension(0)*getElementSize(), getDimension(1) );
+                cudaMemset2D( memory._devPtr, memory._pitch, 0x0, static_cast<size_t>(getDimension(0))*getStorageElementSize(), getDimension(1) );
             }
             else
             {
-                cudaError_t res = cudaMalloc( &memory._devPtr, getAllElementsSize() );
+                cudaError_t res = cudaMalloc( &memory._devPtr, getStorageSize() );
                 if( res != cudaSuccess )
                 {
                     osg::notify(osg::FATAL)
@@ -784,12 +919,12 @@ namespace osgCuda
                     return false;
                 }
 
-                memory._pitch = getDimension(0) * getElementSize();
+                memory._pitch = static_cast<size_t>(getDimension(0)) * getStorageElementSize();
                 // clear memory
-                cudaMemset( memory._devPtr, 0x0, getAllElementsSize() );
+                cudaMemset( memory._devPtr, 0x0, getStorageSize() );
             }
 
-            if( memory._pitch != (getDimension(0) * getElementSize()) )
+            if( memory._pitch != (static_cast<size_t>(getDimension(0)) * getStorageElementSize()) )
             {
                 int device = 0;
                 cudaGetDevice( &device );
@@ -803,6 +938,8 @@ namespace osgCuda
                     << std::endl;
             }
 
+            osgCompute::MemoryBudget::instance()->allocated( *this, memory, getAllocatedByteSize( mapping ) );
+
             if( memory._hostPtr != NULL || memory._devArray != NULL )
                 memory._syncOp |= osgCompute::SYNC_DEVICE;
 
@@ -850,13 +987,16 @@ namespace osgCuda
 
             if( (memory._syncOp & osgCompute::SYNC_DEVICE) )
             {
-                // Copy from host memory
+                // Copy from host memory in the storage format
+                std::vector<unsigned char> packed;
+                const void* hostPtr = packHost( memory._hostPtr, packed );
+
                 if( getNumDimensions() == 3 )
                 {
                     cudaMemcpy3DParms memCpyParams = {0};
                     memCpyParams.dstArray = memory._devArray;
                     memCpyParams.kind = cudaMemcpyHostToDevice;
-                    memCpyParams.srcPtr = make_cudaPitchedPtr(memory._hostPtr, getDimension(0)*getElementSize(), getDimension(0), getDimension(1));
+                    memCpyParams.srcPtr = make_cudaPitchedPtr((void*)hostPtr, static_cast<size_t>(getDimension(0))*getStorageElementSize(), getDimension(0), getDimension(1));
 
                     cudaExtent arrayExtent = {0};
                     arrayExtent.width = getDimension(0);
@@ -878,8 +1018,8 @@ namespace osgCuda
                 }
                 if( getNumDimensions() == 2 ) 
                 {
-                    res = cudaMemcpy2DToArray( memory._devArray, 0, 0, memory._hostPtr, 
-                        getDimension(0)*getElementSize(), getDimension(0)*getElementSize(), getDimension(1), 
+                    res = cudaMemcpy2DToArray( memory._devArray, 0, 0, hostPtr, 
+                        static_cast<size_t>(getDimension(0))*getStorageElementSize(), static_cast<size_t>(getDimension(0))*getStorageElementSize(), getDimension(1), 
                         cudaMemcpyHostToDevice );
                     if( cudaSuccess != res )
                     {
@@ -893,7 +1033,7 @@ namespace osgCuda
                 }
                 else
                 {
-                    res = cudaMemcpyToArray( memory._devArray, 0, 0, memory._hostPtr, getAllElementsSize(), cudaMemcpyHostToDevice);
+                    res = cudaMemcpyToArray( memory._devArray, 0, 0, hostPtr, getStorageSize(), cudaMemcpyHostToDevice);
                     if( cudaSuccess != res )
                     {
                         osg::notify(osg::FATAL)
@@ -936,7 +1076,7 @@ namespace osgCuda
                 else if( getNumDimensions() == 2 ) 
                 {
                     res = cudaMemcpy2DToArray( memory._devArray, 0, 0, memory._devPtr, 
-                                               memory._pitch,  getDimension(0)*getElementSize(), getDimension(1), 
+                                               memory._pitch,  static_cast<size_t>(getDimension(0))*getStorageElementSize(), getDimension(1), 
                                                cudaMemcpyDeviceToDevice );
                     if( cudaSuccess != res )
                     {
@@ -950,7 +1090,7 @@ namespace osgCuda
                 }
                 else
                 {
-                    res = cudaMemcpyToArray( memory._devArray, 0, 0, memory._devPtr, getAllElementsSize(), cudaMemcpyDeviceToDevice);
+                    res = cudaMemcpyToArray( memory._devArray, 0, 0, memory._devPtr, getStorageSize(), cudaMemcpyDeviceToDevice);
                     if( cudaSuccess != res )
                     {
                         osg::notify(osg::FATAL)
@@ -1022,7 +1162,7 @@ namespace osgCuda
                         memory._pitch,
                         memory._devArray,
                         0, 0,
-                        getDimension(0)* getElementSize(),
+                        static_cast<size_t>(getDimension(0))* getStorageElementSize(),
                         getDimension(1),
                         cudaMemcpyDeviceToDevice );
                     if( cudaSuccess != res )
@@ -1037,7 +1177,7 @@ namespace osgCuda
                 }
                 else
                 {
-                    res = cudaMemcpyFromArray( memory._devPtr, memory._devArray, 0, 0, getAllElementsSize(), cudaMemcpyDeviceToDevice );
+                    res = cudaMemcpyFromArray( memory._devPtr, memory._devArray, 0, 0, getStorageSize(), cudaMemcpyDeviceToDevice );
                     if( cudaSuccess != res )
                     {
                         osg::notify(osg::FATAL)
@@ -1051,15 +1191,19 @@ namespace osgCuda
             }
             else
             {
+                // Convert into the storage format
+                std::vector<unsigned char> packed;
+                const void* hostPtr = packHost( memory._hostPtr, packed );
+
                 if( getNumDimensions() == 3 )
                 {
                     cudaMemcpy3DParms memCpyParams = {0};
                     memCpyParams.dstPtr = make_cudaPitchedPtr(memory._devPtr,memory._pitch, getDimension(0), getDimension(1));
                     memCpyParams.kind = cudaMemcpyHostToDevice;
-                    memCpyParams.srcPtr = make_cudaPitchedPtr(memory._hostPtr,getElementSize()*getDimension(0), getDimension(0), getDimension(1));
+                    memCpyParams.srcPtr = make_cudaPitchedPtr((void*)hostPtr,getStorageElementSize()*getDimension(0), getDimension(0), getDimension(1));
 
                     cudaExtent arrayExtent = {0};
-                    arrayExtent.width = getElementSize()*getDimension(0);
+                    arrayExtent.width = getStorageElementSize()*getDimension(0);
                     arrayExtent.height = getDimension(1);
                     arrayExtent.depth = getDimension(2);
 
@@ -1078,8 +1222,8 @@ namespace osgCuda
                 }
                 else if( getNumDimensions() == 2 )
                 {
-                    res = cudaMemcpy2D( memory._devPtr, memory._pitch, memory._hostPtr, getElementSize()*getDimension(0), 
-                        getDimension(0)*getElementSize(), getDimension(1), cudaMemcpyHostToDevice );
+                    res = cudaMemcpy2D( memory._devPtr, memory._pitch, hostPtr, getStorageElementSize()*getDimension(0), 
+                        static_cast<size_t>(getDimension(0))*getStorageElementSize(), getDimension(1), cudaMemcpyHostToDevice );
                     if( cudaSuccess != res )
                     {
                         osg::notify(osg::FATAL)
@@ -1092,7 +1236,7 @@ namespace osgCuda
                 }
                 else
                 {
-                    res = cudaMemcpy( memory._devPtr, memory._hostPtr, getAllElementsSize(), cudaMemcpyHostToDevice );
+                    res = cudaMemcpy( memory._devPtr, hostPtr, getStorageSize(), cudaMemcpyHostToDevice );
                     if( cudaSuccess != res )
                     {
                         osg::notify(osg::FATAL)
@@ -1123,14 +1267,18 @@ namespace osgCuda
                 return false;
             }
 
+            // Receive the storage format first
+            std::vector<unsigned char> staged;
+            void* hostPtr = stageHost( memory._hostPtr, staged );
+
             if( (memory._syncOp & osgCompute::SYNC_DEVICE) )
             {
                 // Copy from array
                 if( getNumDimensions() == 3 )
                 {
                     cudaPitchedPtr pitchPtr = {0};
-                    pitchPtr.pitch = getDimension(0)*getElementSize();
-                    pitchPtr.ptr = memory._hostPtr;
+                    pitchPtr.pitch = static_cast<size_t>(getDimension(0))*getStorageElementSize();
+                    pitchPtr.ptr = hostPtr;
                     pitchPtr.xsize = getDimension(0);
                     pitchPtr.ysize = getDimension(1);
 
@@ -1160,11 +1308,11 @@ namespace osgCuda
                 else if( getNumDimensions() == 2 )
                 {
                     res = cudaMemcpy2DFromArray(
-                        memory._hostPtr,
-                        getDimension(0) * getElementSize(),
+                        hostPtr,
+                        static_cast<size_t>(getDimension(0)) * getStorageElementSize(),
                         memory._devArray,
                         0, 0,
-                        getDimension(0)*getElementSize(),
+                        static_cast<size_t>(getDimension(0))*getStorageElementSize(),
                         getDimension(1),
                         cudaMemcpyDeviceToHost );
                     if( cudaSuccess != res )
@@ -1179,7 +1327,7 @@ namespace osgCuda
                 }
                 else
                 {
-                    res = cudaMemcpyFromArray( memory._hostPtr, memory._devArray, 0, 0, getAllElementsSize(), cudaMemcpyDeviceToHost );
+                    res = cudaMemcpyFromArray( hostPtr, memory._devArray, 0, 0, getStorageSize(), cudaMemcpyDeviceToHost );
                     if( cudaSuccess != res )
                     {
                         osg::notify(osg::FATAL)
@@ -1196,12 +1344,12 @@ namespace osgCuda
                 if( getNumDimensions() == 3 )
                 {
                     cudaMemcpy3DParms memCpyParams = {0};
-                    memCpyParams.dstPtr = make_cudaPitchedPtr(memory._hostPtr,getElementSize()*getDimension(0), getDimension(0), getDimension(1));
+                    memCpyParams.dstPtr = make_cudaPitchedPtr(hostPtr,getStorageElementSize()*getDimension(0), getDimension(0), getDimension(1));
                     memCpyParams.kind = cudaMemcpyDeviceToHost;
                     memCpyParams.srcPtr = make_cudaPitchedPtr(memory._devPtr,memory._pitch, getDimension(0), getDimension(1));
 
                     cudaExtent arrayExtent = {0};
-                    arrayExtent.width = getElementSize()*getDimension(0);
+                    arrayExtent.width = getStorageElementSize()*getDimension(0);
                     arrayExtent.height = getDimension(1);
                     arrayExtent.depth = getDimension(2);
 
@@ -1220,8 +1368,8 @@ namespace osgCuda
                 }
                 else if( getNumDimensions() == 2 )
                 {
-                    res = cudaMemcpy2D( memory._hostPtr, getElementSize()*getDimension(0), memory._devPtr, memory._pitch, 
-                        getDimension(0)*getElementSize(), getDimension(1), cudaMemcpyDeviceToHost );
+                    res = cudaMemcpy2D( hostPtr, getStorageElementSize()*getDimension(0), memory._devPtr, memory._pitch, 
+                        static_cast<size_t>(getDimension(0))*getStorageElementSize(), getDimension(1), cudaMemcpyDeviceToHost );
                     if( cudaSuccess != res )
                     {
                         osg::notify(osg::FATAL)
@@ -1234,7 +1382,7 @@ namespace osgCuda
                 }
                 else
                 {
-                    res = cudaMemcpy( memory._hostPtr, memory._devPtr, getAllElementsSize(), cudaMemcpyDeviceToHost );
+                    res = cudaMemcpy( hostPtr, memory._devPtr, getStorageSize(), cudaMemcpyDeviceToHost );
                     if( cudaSuccess != res )
                     {
                         osg::notify(osg::FATAL)
@@ -1246,6 +1394,9 @@ namespace osgCuda
                 }
             }
 
+            // Convert into the host format
+            unpackHost( hostPtr, memory._hostPtr );
+
             memory._syncOp = memory._syncOp ^ osgCompute::SYNC_HOST;
             return true;
         }
@@ -1254,6 +1405,190 @@ namespace osgCuda
     }
 
 
+    //------------------------------------------------------------------------------
+    bool Buffer::decompress()
+    {
+        ////////////////////
+        // RECEIVE HANDLE //
+        ////////////////////
+        BufferObject* memoryPtr = dynamic_cast<BufferObject*>( object(false) );
+        if( !memoryPtr )
+            return false;
+        BufferObject& memory = *memoryPtr;
+
+        if( memory._packedPtr == NULL )
+            return true;
+
+        ///////////////////////
+        // DECOMPRESS MEMORY //
+        ///////////////////////
+        void* hostPtr = malloc( getAllElementsSize() );
+        if( NULL == hostPtr )
+        {
+            osg::notify(osg::FATAL)
+                << __FUNCTION__ << " " << getName() << ":  error during malloc()."
+                << std::endl;
+
+            return false;
+        }
+
+        // Outdated host memory is synchronized
+        // with the device memory afterwards
+        if( !(memory._syncOp & osgCompute::SYNC_HOST) &&
+            !osgCompute::MirrorCompressor::decompress( memory._packedPtr, memory._packedSize, hostPtr, getAllElementsSize() ) )
+        {
+            osg::notify(osg::FATAL)
+                << __FUNCTION__ << " " << getName() << ":  compressed host memory is corrupt."
+                << std::endl;
+
+            free( hostPtr );
+            return false;
+        }
+
+        free( memory._packedPtr );
+        memory._packedPtr = NULL;
+        memory._packedSize = 0;
+        memory._hostPtr = hostPtr;
+
+        osgCompute::MirrorCompressor::instance()->restored( *this );
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    bool Buffer::evict()
+    {
+        ////////////////////
+        // RECEIVE HANDLE //
+        ////////////////////
+        BufferObject* memoryPtr = dynamic_cast<BufferObject*>( object(false) );
+        if( !memoryPtr )
+            return false;
+        BufferObject& memory = *memoryPtr;
+
+        if( memory._devPtr == NULL && memory._devArray == NULL )
+            return false;
+
+        /////////////////////////
+        // MOVE TO HOST MEMORY //
+        /////////////////////////
+        if( !decompress() )
+            return false;
+
+        if( memory._hostPtr == NULL && !alloc( osgCompute::MAP_HOST ) )
+            return false;
+
+        if( (memory._syncOp & osgCompute::SYNC_HOST) && !sync( osgCompute::MAP_HOST ) )
+            return false;
+
+        osgCompute::MemoryBudget::instance()->release( memory );
+
+        ////////////////////////
+        // FREE DEVICE MEMORY //
+        ////////////////////////
+        if( NULL != memory._devPtr )
+        {
+            cudaError res = cudaFree( memory._devPtr );
+            if( res != cudaSuccess )
+            {
+                osg::notify(osg::FATAL)
+                    <<__FUNCTION__ << " " << getName() << ": error during cudaFree(). "
+                    <<cudaGetErrorString(res)<<std::endl;
+            }
+
+            memory._devPtr = NULL;
+            memory._evictedOp |= osgCompute::SYNC_DEVICE;
+            memory._syncOp |= osgCompute::SYNC_DEVICE;
+        }
+
+        if( NULL != memory._devArray )
+        {
+            cudaError res = cudaFreeArray( memory._devArray );
+            if( res != cudaSuccess )
+            {
+                osg::notify(osg::FATAL)
+                    <<__FUNCTION__ << " " << getName() << ": error during cudaFreeArray(). "
+                    <<cudaGetErrorString(res)<<std::endl;
+            }
+
+            memory._devArray = NULL;
+            memory._evictedOp |= osgCompute::SYNC_ARRAY;
+            memory._syncOp |= osgCompute::SYNC_ARRAY;
+        }
+
+        // The host memory is the current memory now. Mapped
+        // device pointers and recorded launch plans are invalid.
+        memory._syncOp &= ~osgCompute::SYNC_HOST;
+        memory._mapping = osgCompute::UNMAP;
+        ++memory._numEvictions;
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    bool Buffer::compress()
+    {
+        ////////////////////
+        // RECEIVE HANDLE //
+        ////////////////////
+        BufferObject* memoryPtr = dynamic_cast<BufferObject*>( object(false) );
+        if( !memoryPtr )
+            return false;
+        BufferObject& memory = *memoryPtr;
+
+        // Only current host memory is compressed
+        if( memory._hostPtr == NULL || memory._packedPtr != NULL || 
+            (memory._syncOp & osgCompute::SYNC_HOST) )
+            return false;
+
+        /////////////////////
+        // COMPRESS MEMORY //
+        /////////////////////
+        size_t byteSize = getAllElementsSize();
+        size_t boundSize = osgCompute::MirrorCompressor::compressBound( byteSize );
+        void* packedPtr = malloc( boundSize );
+        if( NULL == packedPtr )
+            return false;
+
+        size_t packedSize = osgCompute::MirrorCompressor::compress( memory._hostPtr, byteSize, packedPtr, boundSize );
+        if( packedSize == 0 || packedSize >= byteSize )
+        {
+            free( packedPtr );
+            return false;
+        }
+
+        // Release the unused part of the block
+        void* shrunkPtr = realloc( packedPtr, packedSize );
+        if( NULL != shrunkPtr )
+            packedPtr = shrunkPtr;
+
+        //////////////////////
+        // FREE HOST MEMORY //
+        //////////////////////
+        free( memory._hostPtr );
+        memory._hostPtr = NULL;
+        memory._packedPtr = packedPtr;
+        memory._packedSize = packedSize;
+
+        // Mapped host pointers and recorded 
+        // launch plans are invalid
+        if( memory._mapping & osgCompute::MAP_HOST )
+            memory._mapping = osgCompute::UNMAP;
+        ++memory._numEvictions;
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    size_t Buffer::getCompressedByteSize() const
+    {
+        ////////////////////
+        // RECEIVE HANDLE //
+        ////////////////////
+        const BufferObject* memoryPtr = dynamic_cast<const BufferObject*>( object(false) );
+        if( !memoryPtr )
+            return 0;
+
+        return memoryPtr->_packedSize;
+    }
+
     //------------------------------------------------------------------------------
     void Buffer::setImage( osg::Image* image )
     {
@@ -1262,7 +1597,7 @@ namespace osgCuda
     }
 
     //------------------------------------------------------------------------------
-    unsigned int Buffer::getAllocatedByteSize( unsigned int mapping, unsigned int hint /*= 0 */ ) const 
+    size_t Buffer::getAllocatedByteSize( unsigned int mapping, unsigned int hint /*= 0 */ ) const 
     { 
         ////////////////////
         // RECEIVE HANDLE //
@@ -1272,7 +1607,7 @@ namespace osgCuda
             return NULL;
         const BufferObject& memory = *memoryPtr;
 
-        unsigned int allocSize = 0;
+        size_t allocSize = 0;
         switch( mapping )
         {
         case osgCompute::MAP_DEVICE: case osgCompute::MAP_DEVICE_TARGET: case osgCompute::MAP_DEVICE_SOURCE:
@@ -1281,7 +1616,7 @@ namespace osgCuda
             }break;
         case osgCompute::MAP_HOST: case osgCompute::MAP_HOST_TARGET: case osgCompute::MAP_HOST_SOURCE:
             {
-                allocSize = (memory._hostPtr != NULL)? getByteSize( mapping, hint ) : 0;
+                allocSize = (memory._hostPtr != NULL)? getByteSize( mapping, hint ) : memory._packedSize;
             }break;
         case osgCompute::MAP_DEVICE_ARRAY: case osgCompute::MAP_DEVICE_ARRAY_TARGET:
             {
@@ -1293,9 +1628,9 @@ namespace osgCuda
     }
 
     //------------------------------------------------------------------------------
-    unsigned int Buffer::getByteSize( unsigned int mapping, unsigned int hint /*= 0 */ ) const
+    size_t Buffer::getByteSize( unsigned int mapping, unsigned int hint /*= 0 */ ) const
     {
-        unsigned int allocSize = 0;
+        size_t allocSize = 0;
         switch( mapping )
         {
         case osgCompute::MAP_DEVICE: case osgCompute::MAP_DEVICE_TARGET: case osgCompute::MAP_DEVICE_SOURCE:
@@ -1359,11 +1694,56 @@ namespace osgCuda
         _formatDesc = formatDesc;
     }
 
+    //------------------------------------------------------------------------------
+    void Buffer::setSerializeData( bool serializeData )
+    {
+        _serializeData = serializeData;
+    }
+
+    //------------------------------------------------------------------------------
+    bool Buffer::getSerializeData() const
+    {
+        return _serializeData;
+    }
+
+    //------------------------------------------------------------------------------
+    void Buffer::setStorageFormat( unsigned int storageFormat )
+    {
+        if( StorageConverter::getValueSize( storageFormat ) == 0 )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << " " << getName() << ":  unknown storage format " << storageFormat << "."
+                << std::endl;
+
+            return;
+        }
+
+        if( object(false) != NULL  )
+            releaseObjects();
+
+        _storageFormat = storageFormat;
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int Buffer::getStorageFormat() const
+    {
+        return _storageFormat;
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int Buffer::getStorageElementSize() const
+    {
+        if( _storageFormat == STORAGE_NATIVE )
+            return getElementSize();
+
+        return (getElementSize() / sizeof(float)) * StorageConverter::getValueSize( _storageFormat );
+    }
+
     /////////////////////////////////////////////////////////////////////////////////////////////////
     // PROTECTED FUNCTIONS //////////////////////////////////////////////////////////////////////////
     /////////////////////////////////////////////////////////////////////////////////////////////////
     //------------------------------------------------------------------------------
-    unsigned int Buffer::computePitch() const
+    size_t Buffer::computePitch() const
     {
         // Proof paramters
         if( getNumDimensions() == 0 || getElementSize() == 0 ) 
@@ -1371,18 +1751,56 @@ namespace osgCuda
 
         // 1-dimensional layout
         if ( getNumDimensions() < 2 )
-            return getElementSize() * getNumElements();
+            return getStorageElementSize() * getNumElements();
 
         int device;
         cudaGetDevice( &device );
         cudaDeviceProp devProp;
         cudaGetDeviceProperties( &devProp, device );
 
-        unsigned int remainingAlignmentBytes = (getDimension(0)*getElementSize()) % devProp.textureAlignment;
+        unsigned int remainingAlignmentBytes = (static_cast<size_t>(getDimension(0))*getStorageElementSize()) % devProp.textureAlignment;
         if( remainingAlignmentBytes != 0 )
-            return (getDimension(0)*getElementSize()) + (devProp.textureAlignment-remainingAlignmentBytes);
+            return (static_cast<size_t>(getDimension(0))*getStorageElementSize()) + (devProp.textureAlignment-remainingAlignmentBytes);
         else
-            return (getDimension(0)*getElementSize()); // no additional bytes required.
+            return (static_cast<size_t>(getDimension(0))*getStorageElementSize()); // no additional bytes required.
+    }
+
+    //------------------------------------------------------------------------------
+    size_t Buffer::getStorageSize() const
+    {
+        return getStorageElementSize() * getNumElements();
+    }
+
+    //------------------------------------------------------------------------------
+    const void* Buffer::packHost( const void* data, std::vector<unsigned char>& packed ) const
+    {
+        if( _storageFormat == STORAGE_NATIVE )
+            return data;
+
+        packed.resize( getStorageSize() );
+        StorageConverter::pack( _storageFormat, static_cast<const float*>(data), &packed[0], 
+                                getAllElementsSize() / sizeof(float) );
+        return &packed[0];
+    }
+
+    //------------------------------------------------------------------------------
+    void* Buffer::stageHost( void* hostPtr, std::vector<unsigned char>& staged ) const
+    {
+        if( _storageFormat == STORAGE_NATIVE )
+            return hostPtr;
+
+        staged.resize( getStorageSize() );
+        return &staged[0];
+    }
+
+    //------------------------------------------------------------------------------
+    void Buffer::unpackHost( const void* staged, void* hostPtr ) const
+    {
+        if( staged == hostPtr )
+            return;
+
+        StorageConverter::unpack( _storageFormat, staged, static_cast<float*>(hostPtr), 
+                                  getAllElementsSize() / sizeof(float) );
     }
 
     //------------------------------------------------------------------------------
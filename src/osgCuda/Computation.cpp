@@ -1,3 +1,4 @@
+#include <osgCuda/Buffer>
 #include <osgCuda/Computation>
 
 namespace osgCuda
@@ -11,4 +12,17 @@ namespace osgCuda
     {
 
     }
+
+    osgCompute::Memory* osgCuda::Computation::createTransientStore( size_t byteSize ) const
+    {
+        // Use large elements so that the number 
+        // of elements fits into a dimension
+        const unsigned int elementSize = 256;
+
+        osgCuda::Buffer* store = new osgCuda::Buffer;
+        store->setName( getName() + " transient store" );
+        store->setElementSize( elementSize );
+        store->setDimension( 0, static_cast<unsigned int>( (byteSize + elementSize - 1) / elementSize ) );
+        return store;
+    }
 }
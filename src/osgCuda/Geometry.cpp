@@ -10,6 +10,7 @@
 #include <cuda_gl_interop.h>
 #include <osg/observer_ptr>
 #include <osgCompute/Memory>
+#include <osgCompute/MemoryBudget>
 #include <osgCuda/Geometry>
 
 namespace osgCuda
@@ -71,18 +72,18 @@ namespace osgCuda
 		virtual osgCompute::GLMemoryAdapter* getAdapter(); 
 		virtual const osgCompute::GLMemoryAdapter* getAdapter() const; 
 
-        virtual void* map( unsigned int mapping = osgCompute::MAP_DEVICE, unsigned int offset = 0, unsigned int hint = 0 );
+        virtual void* map( unsigned int mapping = osgCompute::MAP_DEVICE, size_t offset = 0, unsigned int hint = 0 );
         virtual void unmap( unsigned int hint = 0 );
         virtual bool reset( unsigned int hint = 0 );
         virtual bool supportsMapping( unsigned int mapping, unsigned int hint = 0 ) const;
         virtual void mapAsRenderTarget();
-        virtual unsigned int getAllocatedByteSize( unsigned int mapping, unsigned int hint = 0 ) const;
-        virtual unsigned int getByteSize( unsigned int mapping = osgCompute::MAP_DEVICE, unsigned int hint = 0 ) const;
+        virtual size_t getAllocatedByteSize( unsigned int mapping, unsigned int hint = 0 ) const;
+        virtual size_t getByteSize( unsigned int mapping = osgCompute::MAP_DEVICE, unsigned int hint = 0 ) const;
 
         virtual unsigned int getElementSize() const;
         virtual unsigned int getDimension( unsigned int dimIdx ) const;
         virtual unsigned int getNumDimensions() const;
-        virtual unsigned int getNumElements() const;
+        virtual size_t getNumElements() const;
 
     protected:
         friend class Geometry;
@@ -92,9 +93,10 @@ namespace osgCuda
         bool setup( unsigned int mapping );
         bool alloc( unsigned int mapping );
         bool sync( unsigned int mapping );
+        virtual size_t getDeviceByteSize() const;
 
         virtual osgCompute::MemoryObject* createObject() const;
-        virtual unsigned int computePitch() const;
+        virtual size_t computePitch() const;
 
         osg::observer_ptr<osgCuda::Geometry>		_geomref;
     private:
@@ -112,12 +114,12 @@ namespace osgCuda
 
         META_Object(osgCuda,IndexedGeometryMemory)
 
-        virtual void* map( unsigned int mapping = osgCompute::MAP_DEVICE, unsigned int offset = 0, unsigned int hint = 0 );
+        virtual void* map( unsigned int mapping = osgCompute::MAP_DEVICE, size_t offset = 0, unsigned int hint = 0 );
         virtual void unmap( unsigned int hint = 0 );
         virtual bool reset( unsigned int hint = 0 );
         virtual bool supportsMapping( unsigned int mapping, unsigned int hint = 0 ) const;
 
-        virtual void* mapIndices( unsigned int mapping = osgCompute::MAP_DEVICE, unsigned int offset = 0, unsigned int hint = 0 );
+        virtual void* mapIndices( unsigned int mapping = osgCompute::MAP_DEVICE, size_t offset = 0, unsigned int hint = 0 );
         virtual void unmapIndices( unsigned int hint = 0 );
         virtual bool resetIndices( unsigned int hint = 0 );
 
@@ -132,6 +134,7 @@ namespace osgCuda
         bool setupIndices( unsigned int mapping );
         bool allocIndices( unsigned int mapping );
         bool syncIndices( unsigned int mapping );
+        virtual size_t getDeviceByteSize() const;
 
         mutable unsigned int                        _indicesByteSize;
 
@@ -159,6 +162,9 @@ namespace osgCuda
     //------------------------------------------------------------------------------
     GeometryObject::~GeometryObject()
     {
+        if( _graphicsResource != NULL )
+            osgCompute::MemoryBudget::instance()->release( *this );
+
         if( _devPtr != NULL )
         {
             cudaError res = cudaGraphicsUnmapResources( 1, &_graphicsResource );
@@ -205,6 +211,9 @@ namespace osgCuda
     //------------------------------------------------------------------------------
     IndexedGeometryObject::~IndexedGeometryObject()
     {
+        if( _graphicsIdxResource != NULL )
+            osgCompute::MemoryBudget::instance()->release( *this );
+
         if( _devIdxPtr != NULL )
         {
             cudaError res = cudaGraphicsUnmapResources( 1, &_graphicsIdxResource );
@@ -336,9 +345,9 @@ namespace osgCuda
     }
 
     //------------------------------------------------------------------------------
-    unsigned int GeometryMemory::getNumElements() const
+    size_t GeometryMemory::getNumElements() const
     {
-        unsigned int numElements = osgCompute::Memory::getNumElements();
+        size_t numElements = osgCompute::Memory::getNumElements();
         if( numElements == 0 )
         {
             if( !_geomref.valid() )
@@ -355,7 +364,7 @@ namespace osgCuda
     }
 
     //------------------------------------------------------------------------------
-    void* GeometryMemory::map( unsigned int mapping/* = osgCompute::MAP_DEVICE*/, unsigned int offset/* = 0*/, unsigned int hint/* = 0*/ )
+    void* GeometryMemory::map( unsigned int mapping/* = osgCompute::MAP_DEVICE*/, size_t offset/* = 0*/, unsigned int hint/* = 0*/ )
     {
         if( !_geomref.valid() )
 			return NULL;
@@ -366,6 +375,10 @@ namespace osgCuda
             return NULL;
         }
 
+        // Copy deferred content first
+        if( getPayload() != NULL )
+            applyPayload();
+
         ////////////////////
         // RECEIVE HANDLE //
         ////////////////////
@@ -498,6 +511,8 @@ namespace osgCuda
                 if( !sync( mapping ) )
                     return NULL;
 
+            // Account registered buffer objects
+            osgCompute::MemoryBudget::instance()->update( *this, memory, getDeviceByteSize() );
             ptr = memory._devPtr;
         }
         else
@@ -595,7 +610,7 @@ namespace osgCuda
     }
 
     //------------------------------------------------------------------------------
-    unsigned int GeometryMemory::getAllocatedByteSize( unsigned int mapping, unsigned int hint /*= 0 */ ) const 
+    size_t GeometryMemory::getAllocatedByteSize( unsigned int mapping, unsigned int hint /*= 0 */ ) const 
     {
         ////////////////////
         // RECEIVE HANDLE //
@@ -605,7 +620,7 @@ namespace osgCuda
             return NULL;
         const GeometryObject& memory = *memoryPtr;
 
-        unsigned int allocSize = 0;
+        size_t allocSize = 0;
         switch( mapping )
         {
         case osgCompute::MAP_DEVICE: case osgCompute::MAP_DEVICE_TARGET: case osgCompute::MAP_DEVICE_SOURCE:
@@ -626,9 +641,9 @@ namespace osgCuda
     }
 
     //------------------------------------------------------------------------------
-    unsigned int GeometryMemory::getByteSize( unsigned int mapping, unsigned int hint /*= 0 */ ) const
+    size_t GeometryMemory::getByteSize( unsigned int mapping, unsigned int hint /*= 0 */ ) const
     {
-        unsigned int allocSize = 0;
+        size_t allocSize = 0;
         switch( mapping )
         {
         case osgCompute::MAP_DEVICE: case osgCompute::MAP_DEVICE_TARGET: case osgCompute::MAP_DEVICE_SOURCE:
@@ -750,6 +765,7 @@ namespace osgCuda
             }
 
             memory._graphicsResource = NULL;
+            osgCompute::MemoryBudget::instance()->update( *this, memory, getDeviceByteSize() );
         }
 
 
@@ -772,6 +788,11 @@ namespace osgCuda
 
         vbo->dirty();
 
+        // Without a GL context (e.g. headless mode) no GL buffer
+        // object exists yet. Dirtying the buffer object is sufficient.
+        if( osgCompute::GLMemory::getContext() == NULL || osgCompute::GLMemory::getContext()->getState() == NULL )
+            return true;
+
         // Compile vertex buffer
         osg::GLBufferObject* glBO = vbo->getOrCreateGLBufferObject( osgCompute::GLMemory::getContext()->getState()->getContextID() );
         if( NULL == glBO )
@@ -811,7 +832,7 @@ namespace osgCuda
     // PROTECTED FUNCTIONS //////////////////////////////////////////////////////////////////////////
     /////////////////////////////////////////////////////////////////////////////////////////////////
     //------------------------------------------------------------------------------
-    unsigned int GeometryMemory::computePitch() const
+    size_t GeometryMemory::computePitch() const
     {
         return getDimension(0)*getElementSize();
     }
@@ -892,7 +913,7 @@ namespace osgCuda
             if( memory._lastModifiedCount.size() != vbo->getNumBufferData() )
                 memory._lastModifiedCount.resize( vbo->getNumBufferData(), UINT_MAX );
 
-            unsigned int curOffset = 0;
+            size_t curOffset = 0;
             for( unsigned int d=0; d< vbo->getNumBufferData(); ++d )
             {
                 osg::BufferData* curData = vbo->getBufferData(d);
@@ -1172,6 +1193,16 @@ namespace osgCuda
         return false;
     }
 
+    //------------------------------------------------------------------------------
+    size_t GeometryMemory::getDeviceByteSize() const
+    {
+        const GeometryObject* memoryPtr = dynamic_cast<const GeometryObject*>( object(false) );
+        if( !memoryPtr || memoryPtr->_graphicsResource == NULL )
+            return 0;
+
+        return getByteSize( osgCompute::MAP_DEVICE );
+    }
+
     //------------------------------------------------------------------------------
     osgCompute::MemoryObject* GeometryMemory::createObject() const
     {
@@ -1199,7 +1230,7 @@ namespace osgCuda
     }
 
     //------------------------------------------------------------------------------
-    void* IndexedGeometryMemory::map( unsigned int mapping /*= osgCompute::MAP_DEVICE*/, unsigned int offset /*= 0*/, unsigned int hint /*= 0 */ )
+    void* IndexedGeometryMemory::map( unsigned int mapping /*= osgCompute::MAP_DEVICE*/, size_t offset /*= 0*/, unsigned int hint /*= 0 */ )
     {
         if( (mapping & MAP_INDICES) == MAP_INDICES )
             return mapIndices( mapping, offset, hint );
@@ -1208,7 +1239,7 @@ namespace osgCuda
     }
 
     //------------------------------------------------------------------------------
-    void* IndexedGeometryMemory::mapIndices( unsigned int mapping/* = osgCompute::MAP_DEVICE*/, unsigned int offset/* = 0*/, unsigned int hint/* = 0*/ )
+    void* IndexedGeometryMemory::mapIndices( unsigned int mapping/* = osgCompute::MAP_DEVICE*/, size_t offset/* = 0*/, unsigned int hint/* = 0*/ )
     {
 		if( !_geomref.valid() )
 			return NULL;
@@ -1347,6 +1378,8 @@ namespace osgCuda
                 if( !syncIndices( mapping ) )
                     return NULL;
 
+            // Account registered buffer objects
+            osgCompute::MemoryBudget::instance()->update( *this, memory, getDeviceByteSize() );
             ptr = memory._devIdxPtr;
         }
         else
@@ -1543,6 +1576,7 @@ namespace osgCuda
             }
 
             memory._graphicsIdxResource = NULL;
+            osgCompute::MemoryBudget::instance()->update( *this, memory, getDeviceByteSize() );
         }
 
 
@@ -1565,6 +1599,11 @@ namespace osgCuda
 
         ebo->dirty();
 
+        // Without a GL context (e.g. headless mode) no GL buffer
+        // object exists yet. Dirtying the buffer object is sufficient.
+        if( osgCompute::GLMemory::getContext() == NULL || osgCompute::GLMemory::getContext()->getState() == NULL )
+            return true;
+
         // Compile element buffer
         osg::GLBufferObject* glBO = ebo->getOrCreateGLBufferObject( osgCompute::GLMemory::getContext()->getState()->getContextID() );
         if( NULL == glBO )
@@ -1709,7 +1748,7 @@ namespace osgCuda
             if( memory._lastIdxModifiedCount.size() != ebo->getNumBufferData() )
                 memory._lastIdxModifiedCount.resize( ebo->getNumBufferData(), UINT_MAX );
 
-            unsigned int curOffset = 0;
+            size_t curOffset = 0;
             for( unsigned int d=0; d< ebo->getNumBufferData(); ++d )
             {
                 osg::BufferData* curData = ebo->getBufferData(d);
@@ -1968,6 +2007,20 @@ namespace osgCuda
         osgCompute::GLMemory::clear();
     }
 
+    //------------------------------------------------------------------------------
+    size_t IndexedGeometryMemory::getDeviceByteSize() const
+    {
+        const IndexedGeometryObject* memoryPtr = dynamic_cast<const IndexedGeometryObject*>( object(false) );
+        if( !memoryPtr )
+            return 0;
+
+        size_t byteSize = GeometryMemory::getDeviceByteSize();
+        if( memoryPtr->_graphicsIdxResource != NULL )
+            byteSize += getIndicesByteSize();
+
+        return byteSize;
+    }
+
     //------------------------------------------------------------------------------
     osgCompute::MemoryObject* IndexedGeometryMemory::createObject() const
     {
@@ -2039,6 +2092,110 @@ namespace osgCuda
         // Do nothing as geometry cannot be mapped as a render target.
     }
 
+    //------------------------------------------------------------------------------
+    unsigned int Geometry::getNumAttributes() const
+    {
+        osg::Geometry::ArrayList arrayList;
+        getArrayList( arrayList );
+        return static_cast<unsigned int>( arrayList.size() );
+    }
+
+    //------------------------------------------------------------------------------
+    bool Geometry::getAttribute( unsigned int attribIdx, AttributeLayout& layout ) const
+    {
+        osg::Geometry::ArrayList arrayList;
+        getArrayList( arrayList );
+        if( attribIdx >= arrayList.size() || arrayList[attribIdx] == NULL )
+            return false;
+
+        const osg::Array* array = arrayList[attribIdx];
+        if( array->getNumElements() == 0 )
+            return false;
+
+        // Arrays are copied one after another into the vertex 
+        // buffer (see GeometryMemory::setup()) 
+        osg::VertexBufferObject* vbo = const_cast<osgCuda::Geometry*>(this)->getOrCreateVertexBufferObject();
+        if( !vbo )
+            return false;
+
+        size_t offset = 0;
+        unsigned int d = 0;
+        for( ; d<vbo->getNumBufferData(); ++d )
+        {
+            const osg::BufferData* curData = vbo->getBufferData(d);
+            if( curData == array )
+                break;
+
+            if( curData != NULL )
+                offset += curData->getTotalDataSize();
+        }
+
+        if( d == vbo->getNumBufferData() )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ <<" " << getName() << ": array " << attribIdx << " is not part of the vertex buffer."
+                << std::endl;
+
+            return false;
+        }
+
+        layout._array = array;
+        layout._offset = offset;
+        layout._byteSize = array->getTotalDataSize();
+        layout._numElements = array->getNumElements();
+        layout._stride = static_cast<unsigned int>( layout._byteSize / layout._numElements );
+        layout._dataType = array->getDataType();
+        layout._numComponents = array->getDataSize();
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    bool Geometry::getAttribute( const std::string& identifier, AttributeLayout& layout ) const
+    {
+        osg::Geometry::ArrayList arrayList;
+        getArrayList( arrayList );
+
+        const osg::Array* array = NULL;
+        if( identifier == "VERTEX" ) 
+            array = getVertexArray();
+        else if( identifier == "NORMAL" ) 
+            array = getNormalArray();
+        else if( identifier == "COLOR" ) 
+            array = getColorArray();
+
+        for( unsigned int a=0; a<arrayList.size(); ++a )
+        {
+            if( arrayList[a] == NULL )
+                continue;
+
+            if( (array != NULL && arrayList[a] == array) ||
+                (array == NULL && arrayList[a]->getName() == identifier) )
+                return getAttribute( a, layout );
+        }
+
+        return false;
+    }
+
+    //------------------------------------------------------------------------------
+    void* Geometry::mapAttribute( unsigned int attribIdx, unsigned int mapping/* = osgCompute::MAP_DEVICE*/, unsigned int hint/* = 0*/ )
+    {
+        AttributeLayout layout;
+        if( !getAttribute( attribIdx, layout ) )
+            return NULL;
+
+        return mapLayout( layout, mapping, hint );
+    }
+
+    //------------------------------------------------------------------------------
+    void* Geometry::mapAttribute( const std::string& identifier, unsigned int mapping/* = osgCompute::MAP_DEVICE*/, unsigned int hint/* = 0*/ )
+    {
+        AttributeLayout layout;
+        if( !getAttribute( identifier, layout ) )
+            return NULL;
+
+        return mapLayout( layout, mapping, hint );
+    }
+
     //------------------------------------------------------------------------------
     void Geometry::releaseGLObjects( osg::State* state/*=0*/ ) const
     {
@@ -2085,4 +2242,19 @@ namespace osgCuda
         _memory->releaseObjects();
         _memory = NULL;
     }
+
+    //------------------------------------------------------------------------------
+    void* Geometry::mapLayout( const AttributeLayout& layout, unsigned int mapping, unsigned int hint )
+    {
+        if( (mapping & MAP_INDICES) == MAP_INDICES )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ <<" " << getName() << ": indices cannot be mapped as a vertex attribute."
+                << std::endl;
+
+            return NULL;
+        }
+
+        return _memory->map( mapping, layout._offset, hint );
+    }
 }
@@ -0,0 +1,303 @@
+#include <memory.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OSGCUDA_STORAGE_SSE2 1
+#include <emmintrin.h>
+#endif
+#include <osgCuda/Storage>
+
+namespace osgCuda
+{
+    //------------------------------------------------------------------------------
+    static inline unsigned int floatBits( float value )
+    {
+        unsigned int bits;
+        memcpy( &bits, &value, sizeof(float) );
+        return bits;
+    }
+
+    //------------------------------------------------------------------------------
+    static inline float bitsFloat( unsigned int bits )
+    {
+        float value;
+        memcpy( &value, &bits, sizeof(float) );
+        return value;
+    }
+
+    //------------------------------------------------------------------------------
+    static inline unsigned short floatToHalf( float value )
+    {
+        unsigned int bits = floatBits( value );
+        unsigned int sign = bits & 0x80000000u;
+        bits ^= sign;
+
+        unsigned short half;
+        if( bits >= ((127 + 16) << 23) )
+        {
+            // Overflows turn into infinity and NaNs stay quiet NaNs
+            half = (bits > (255u << 23))? 0x7E00 : 0x7C00;
+        }
+        else if( bits < ((127 - 14) << 23) )
+        {
+            // Subnormal results are rounded by the float addition
+            const unsigned int magic = ((127 - 15) + (23 - 10) + 1) << 23;
+            half = static_cast<unsigned short>( floatBits( bitsFloat( bits ) + bitsFloat( magic ) ) - magic );
+        }
+        else
+        {
+            // Rebias the exponent and round the mantissa to nearest even
+            unsigned int mantOdd = (bits >> 13) & 1;
+            bits += (static_cast<unsigned int>(15 - 127) << 23) + 0xFFF + mantOdd;
+            half = static_cast<unsigned short>( bits >> 13 );
+        }
+
+        return static_cast<unsigned short>( half | (sign >> 16) );
+    }
+
+    //------------------------------------------------------------------------------
+    static inline float halfToFloat( unsigned short half )
+    {
+        const unsigned int shiftedExp = 0x7C00 << 13;
+        unsigned int bits = (half & 0x7FFF) << 13;
+        unsigned int exp = bits & shiftedExp;
+        bits += (127 - 15) << 23;
+
+        if( exp == shiftedExp )
+        {
+            // Infinity or NaN
+            bits += (128 - 16) << 23;
+        }
+        else if( exp == 0 )
+        {
+            // Renormalize subnormals
+            bits += 1 << 23;
+            bits = floatBits( bitsFloat( bits ) - bitsFloat( 113 << 23 ) );
+        }
+
+        return bitsFloat( bits | ((half & 0x8000) << 16) );
+    }
+
+    //------------------------------------------------------------------------------
+    static inline float clampValue( float value, float minValue, float maxValue )
+    {
+        // NaNs are mapped to maxValue as with SSE min/max
+        value = (value < maxValue)? value : maxValue;
+        return (value > minValue)? value : minValue;
+    }
+
+    //------------------------------------------------------------------------------
+    static inline int roundValue( float value )
+    {
+        // Adding 2^23 rounds to nearest even like the SSE conversion
+        const float magic = 8388608.0f;
+        float rounded = (value >= 0.0f)? (value + magic) - magic : (value - magic) + magic;
+        return static_cast<int>( rounded );
+    }
+
+#ifdef OSGCUDA_STORAGE_SSE2
+    //------------------------------------------------------------------------------
+    static inline __m128i floatToHalf4( __m128 value )
+    {
+        const __m128i signMask = _mm_set1_epi32( 0x80000000 );
+        const __m128i halfMax = _mm_set1_epi32( (127 + 16) << 23 );
+        const __m128i minNormal = _mm_set1_epi32( (127 - 14) << 23 );
+        const __m128i subnormMagic = _mm_set1_epi32( ((127 - 15) + (23 - 10) + 1) << 23 );
+        const __m128i normalBias = _mm_set1_epi32( 0xFFF - ((127 - 15) << 23) );
+
+        __m128 sign = _mm_and_ps( value, _mm_castsi128_ps( signMask ) );
+        __m128 absValue = _mm_xor_ps( value, sign );
+        __m128i absBits = _mm_castps_si128( absValue );
+
+        // Infinity and quiet NaN
+        __m128i isNaN = _mm_castps_si128( _mm_cmpunord_ps( absValue, absValue ) );
+        __m128i special = _mm_or_si128( _mm_and_si128( isNaN, _mm_set1_epi32( 0x200 ) ), _mm_set1_epi32( 0x7C00 ) );
+        __m128i isRegular = _mm_cmpgt_epi32( halfMax, absBits );
+
+        // Subnormal results
+        __m128i isSubnorm = _mm_cmpgt_epi32( minNormal, absBits );
+        __m128 subnormSum = _mm_add_ps( absValue, _mm_castsi128_ps( subnormMagic ) );
+        __m128i subnorm = _mm_sub_epi32( _mm_castps_si128( subnormSum ), subnormMagic );
+
+        // Normal results rounded to nearest even
+        __m128i mantOdd = _mm_srai_epi32( _mm_slli_epi32( absBits, 31 - 13 ), 31 );
+        __m128i normal = _mm_srli_epi32( _mm_sub_epi32( _mm_add_epi32( absBits, normalBias ), mantOdd ), 13 );
+
+        __m128i regular = _mm_or_si128( _mm_and_si128( isSubnorm, subnorm ), _mm_andnot_si128( isSubnorm, normal ) );
+        __m128i half = _mm_or_si128( _mm_and_si128( isRegular, regular ), _mm_andnot_si128( isRegular, special ) );
+
+        // Sign extended halfs are packed without saturation
+        return _mm_or_si128( half, _mm_srai_epi32( _mm_castps_si128( sign ), 16 ) );
+    }
+
+    //------------------------------------------------------------------------------
+    static inline __m128 halfToFloat4( __m128i half )
+    {
+        const __m128i expMant = _mm_and_si128( half, _mm_set1_epi32( 0x7FFF ) );
+        const __m128 magic = _mm_castsi128_ps( _mm_set1_epi32( (254 - 15) << 23 ) );
+
+        // Scaling rebiases the exponent and renormalizes subnormals
+        __m128 scaled = _mm_mul_ps( _mm_castsi128_ps( _mm_slli_epi32( expMant, 13 ) ), magic );
+        __m128i isInfNaN = _mm_cmpgt_epi32( expMant, _mm_set1_epi32( 0x7BFF ) );
+        __m128i infNaNExp = _mm_and_si128( isInfNaN, _mm_set1_epi32( 255 << 23 ) );
+        __m128i sign = _mm_slli_epi32( _mm_xor_si128( half, expMant ), 16 );
+
+        return _mm_or_ps( scaled, _mm_castsi128_ps( _mm_or_si128( sign, infNaNExp ) ) );
+    }
+#endif
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    unsigned int StorageConverter::getValueSize( unsigned int storageFormat )
+    {
+        switch( storageFormat )
+        {
+        case STORAGE_NATIVE: return sizeof(float);
+        case STORAGE_HALF: return sizeof(unsigned short);
+        case STORAGE_SNORM16: return sizeof(short);
+        case STORAGE_UNORM8: return sizeof(unsigned char);
+        }
+
+        return 0;
+    }
+
+    //------------------------------------------------------------------------------
+    void StorageConverter::pack( unsigned int storageFormat, const float* src, void* dst, size_t numValues )
+    {
+        size_t v = 0;
+        switch( storageFormat )
+        {
+        case STORAGE_NATIVE:
+            {
+                memcpy( dst, src, numValues * sizeof(float) );
+            }break;
+        case STORAGE_HALF:
+            {
+                unsigned short* halfs = static_cast<unsigned short*>( dst );
+#ifdef OSGCUDA_STORAGE_SSE2
+                for( ; v+8 <= numValues; v+=8 )
+                {
+                    __m128i low = floatToHalf4( _mm_loadu_ps( &src[v] ) );
+                    __m128i high = floatToHalf4( _mm_loadu_ps( &src[v+4] ) );
+                    _mm_storeu_si128( reinterpret_cast<__m128i*>( &halfs[v] ), _mm_packs_epi32( low, high ) );
+                }
+#endif
+                for( ; v<numValues; ++v )
+                    halfs[v] = floatToHalf( src[v] );
+            }break;
+        case STORAGE_SNORM16:
+            {
+                short* snorms = static_cast<short*>( dst );
+#ifdef OSGCUDA_STORAGE_SSE2
+                const __m128 minValue = _mm_set1_ps( -1.0f );
+                const __m128 maxValue = _mm_set1_ps( 1.0f );
+                const __m128 scale = _mm_set1_ps( 32767.0f );
+                for( ; v+8 <= numValues; v+=8 )
+                {
+                    __m128 low = _mm_max_ps( _mm_min_ps( _mm_loadu_ps( &src[v] ), maxValue ), minValue );
+                    __m128 high = _mm_max_ps( _mm_min_ps( _mm_loadu_ps( &src[v+4] ), maxValue ), minValue );
+                    __m128i lowInt = _mm_cvtps_epi32( _mm_mul_ps( low, scale ) );
+                    __m128i highInt = _mm_cvtps_epi32( _mm_mul_ps( high, scale ) );
+                    _mm_storeu_si128( reinterpret_cast<__m128i*>( &snorms[v] ), _mm_packs_epi32( lowInt, highInt ) );
+                }
+#endif
+                for( ; v<numValues; ++v )
+                    snorms[v] = static_cast<short>( roundValue( clampValue( src[v], -1.0f, 1.0f ) * 32767.0f ) );
+            }break;
+        case STORAGE_UNORM8:
+            {
+                unsigned char* unorms = static_cast<unsigned char*>( dst );
+#ifdef OSGCUDA_STORAGE_SSE2
+                const __m128 minValue = _mm_setzero_ps();
+                const __m128 maxValue = _mm_set1_ps( 1.0f );
+                const __m128 scale = _mm_set1_ps( 255.0f );
+                for( ; v+16 <= numValues; v+=16 )
+                {
+                    __m128i ints[4];
+                    for( unsigned int i=0; i<4; ++i )
+                    {
+                        __m128 value = _mm_max_ps( _mm_min_ps( _mm_loadu_ps( &src[v+4*i] ), maxValue ), minValue );
+                        ints[i] = _mm_cvtps_epi32( _mm_mul_ps( value, scale ) );
+                    }
+
+                    __m128i shorts0 = _mm_packs_epi32( ints[0], ints[1] );
+                    __m128i shorts1 = _mm_packs_epi32( ints[2], ints[3] );
+                    _mm_storeu_si128( reinterpret_cast<__m128i*>( &unorms[v] ), _mm_packus_epi16( shorts0, shorts1 ) );
+                }
+#endif
+                for( ; v<numValues; ++v )
+                    unorms[v] = static_cast<unsigned char>( roundValue( clampValue( src[v], 0.0f, 1.0f ) * 255.0f ) );
+            }break;
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    void StorageConverter::unpack( unsigned int storageFormat, const void* src, float* dst, size_t numValues )
+    {
+        size_t v = 0;
+        switch( storageFormat )
+        {
+        case STORAGE_NATIVE:
+            {
+                memcpy( dst, src, numValues * sizeof(float) );
+            }break;
+        case STORAGE_HALF:
+            {
+                const unsigned short* halfs = static_cast<const unsigned short*>( src );
+#ifdef OSGCUDA_STORAGE_SSE2
+                const __m128i zero = _mm_setzero_si128();
+                for( ; v+8 <= numValues; v+=8 )
+                {
+                    __m128i values = _mm_loadu_si128( reinterpret_cast<const __m128i*>( &halfs[v] ) );
+                    _mm_storeu_ps( &dst[v], halfToFloat4( _mm_unpacklo_epi16( values, zero ) ) );
+                    _mm_storeu_ps( &dst[v+4], halfToFloat4( _mm_unpackhi_epi16( values, zero ) ) );
+                }
+#endif
+                for( ; v<numValues; ++v )
+                    dst[v] = halfToFloat( halfs[v] );
+            }break;
+        case STORAGE_SNORM16:
+            {
+                const short* snorms = static_cast<const short*>( src );
+#ifdef OSGCUDA_STORAGE_SSE2
+                const __m128 minValue = _mm_set1_ps( -1.0f );
+                const __m128 scale = _mm_set1_ps( 1.0f / 32767.0f );
+                for( ; v+8 <= numValues; v+=8 )
+                {
+                    // Sign extend the shorts
+                    __m128i values = _mm_loadu_si128( reinterpret_cast<const __m128i*>( &snorms[v] ) );
+                    __m128i low = _mm_srai_epi32( _mm_unpacklo_epi16( values, values ), 16 );
+                    __m128i high = _mm_srai_epi32( _mm_unpackhi_epi16( values, values ), 16 );
+                    _mm_storeu_ps( &dst[v], _mm_max_ps( _mm_mul_ps( _mm_cvtepi32_ps( low ), scale ), minValue ) );
+                    _mm_storeu_ps( &dst[v+4], _mm_max_ps( _mm_mul_ps( _mm_cvtepi32_ps( high ), scale ), minValue ) );
+                }
+#endif
+                for( ; v<numValues; ++v )
+                {
+                    float value = static_cast<float>( snorms[v] ) * (1.0f / 32767.0f);
+                    dst[v] = (value > -1.0f)? value : -1.0f;
+                }
+            }break;
+        case STORAGE_UNORM8:
+            {
+                const unsigned char* unorms = static_cast<const unsigned char*>( src );
+#ifdef OSGCUDA_STORAGE_SSE2
+                const __m128i zero = _mm_setzero_si128();
+                const __m128 scale = _mm_set1_ps( 1.0f / 255.0f );
+                for( ; v+16 <= numValues; v+=16 )
+                {
+                    __m128i values = _mm_loadu_si128( reinterpret_cast<const __m128i*>( &unorms[v] ) );
+                    __m128i shorts0 = _mm_unpacklo_epi8( values, zero );
+                    __m128i shorts1 = _mm_unpackhi_epi8( values, zero );
+                    _mm_storeu_ps( &dst[v], _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( shorts0, zero ) ), scale ) );
+                    _mm_storeu_ps( &dst[v+4], _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( shorts0, zero ) ), scale ) );
+                    _mm_storeu_ps( &dst[v+8], _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( shorts1, zero ) ), scale ) );
+                    _mm_storeu_ps( &dst[v+12], _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpackhi_epi16( shorts1, zero ) ), scale ) );
+                }
+#endif
+                for( ; v<numValues; ++v )
+                    dst[v] = static_cast<float>( unorms[v] ) * (1.0f / 255.0f);
+            }break;
+        }
+    }
+}
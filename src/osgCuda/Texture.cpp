@@ -8,8 +8,12 @@
 #include <cuda_gl_interop.h>
 #include <osg/observer_ptr>
 #include <osgCompute/Memory>
+#include <osgCompute/MemoryBudget>
 #include <osgCuda/Texture>
 
+// Number of staging buffers for asynchronous readbacks
+#define OSGCUDA_NUM_READBACKS 2
+
 namespace osgCuda
 {
     /**
@@ -24,6 +28,27 @@ namespace osgCuda
         unsigned int	            _lastModifiedCount;
 		void*						_lastModifiedAddress;
 
+        // Page-locked staging buffers of requested readbacks
+        struct Readback
+        {
+            void*                   _hostPtr;
+            size_t                  _byteSize;
+            cudaEvent_t             _event;
+            unsigned int            _writeCount;
+        };
+
+        Readback                    _readbacks[OSGCUDA_NUM_READBACKS];
+        unsigned int                _firstReadback;
+        unsigned int                _numReadbacks;
+        // Number of writes to the memory. Detects writes after a readback request.
+        unsigned int                _writeCount;
+
+        // Modified region of the device memory since the last array update
+        size_t                      _dirtyBegin;
+        size_t                      _dirtyEnd;
+        bool                        _dirtyAll;
+        bool                        _dirtyUndeclared;
+
         TextureObject();
         virtual ~TextureObject();
 
@@ -49,15 +74,18 @@ namespace osgCuda
         virtual unsigned int getElementSize() const;
         virtual unsigned int getDimension( unsigned int dimIdx ) const;
         virtual unsigned int getNumDimensions() const;
-        virtual unsigned int getNumElements() const;
+        virtual size_t getNumElements() const;
 
-        virtual void* map( unsigned int mapping = osgCompute::MAP_DEVICE, unsigned int offset = 0, unsigned int hint = 0 );
+        virtual void* map( unsigned int mapping = osgCompute::MAP_DEVICE, size_t offset = 0, unsigned int hint = 0 );
         virtual void unmap( unsigned int hint = 0 );
         virtual bool reset( unsigned int hint = 0 );
         virtual bool supportsMapping( unsigned int mapping, unsigned int hint = 0 ) const;
         virtual void mapAsRenderTarget();
-        virtual unsigned int getAllocatedByteSize( unsigned int mapping, unsigned int hint = 0 ) const;
-        virtual unsigned int getByteSize( unsigned int mapping = osgCompute::MAP_DEVICE, unsigned int hint = 0 ) const;
+        virtual bool requestReadback( unsigned int hint = 0 );
+        virtual bool isReadbackReady( unsigned int hint = 0 ) const;
+        virtual void addDirtyRegion( size_t offset, size_t byteSize, unsigned int hint = 0 );
+        virtual size_t getAllocatedByteSize( unsigned int mapping, unsigned int hint = 0 ) const;
+        virtual size_t getByteSize( unsigned int mapping = osgCompute::MAP_DEVICE, unsigned int hint = 0 ) const;
 
     protected:
         friend class Texture1D;
@@ -69,9 +97,13 @@ namespace osgCuda
         bool setup( unsigned int mapping );
         bool alloc( unsigned int mapping );
         bool sync( unsigned int mapping );
+        bool finishReadback();
+        void flush();
+        void getDirtyRange( size_t unitSize, size_t numUnits, size_t& first, size_t& count ) const;
+        size_t getDeviceByteSize() const;
 
         virtual osgCompute::MemoryObject* createObject() const;
-        virtual unsigned int computePitch() const;
+        virtual size_t computePitch() const;
 
         osg::observer_ptr<osg::Texture>	_texref; 
     private:
@@ -91,13 +123,30 @@ namespace osgCuda
           _graphicsArray(NULL),
           _graphicsResource(NULL),
           _lastModifiedCount(UINT_MAX),
-		  _lastModifiedAddress(NULL)
+		  _lastModifiedAddress(NULL),
+          _firstReadback(0),
+          _numReadbacks(0),
+          _writeCount(0),
+          _dirtyBegin(0),
+          _dirtyEnd(0),
+          _dirtyAll(false),
+          _dirtyUndeclared(false)
     {
+        for( unsigned int r=0; r<OSGCUDA_NUM_READBACKS; ++r )
+        {
+            _readbacks[r]._hostPtr = NULL;
+            _readbacks[r]._byteSize = 0;
+            _readbacks[r]._event = NULL;
+            _readbacks[r]._writeCount = 0;
+        }
     }
 
     //------------------------------------------------------------------------------
     TextureObject::~TextureObject()
     {
+        if( _devPtr != NULL || _graphicsResource != NULL )
+            osgCompute::MemoryBudget::instance()->release( *this );
+
         if( _devPtr != NULL )
         {
             cudaError res = cudaFree( _devPtr );
@@ -136,6 +185,19 @@ namespace osgCuda
 
         if( NULL != _hostPtr)
             free( _hostPtr );
+
+        for( unsigned int r=0; r<OSGCUDA_NUM_READBACKS; ++r )
+        {
+            // Wait for pending copies before the memory is freed
+            if( _readbacks[r]._event != NULL )
+            {
+                cudaEventSynchronize( _readbacks[r]._event );
+                cudaEventDestroy( _readbacks[r]._event );
+            }
+
+            if( _readbacks[r]._hostPtr != NULL )
+                cudaFreeHost( _readbacks[r]._hostPtr );
+        }
     }
 
 
@@ -280,9 +342,9 @@ namespace osgCuda
     }
 
     //------------------------------------------------------------------------------
-    unsigned int TextureMemory::getNumElements() const
+    size_t TextureMemory::getNumElements() const
     {
-        unsigned int numElements = osgCompute::Memory::getNumElements();
+        size_t numElements = osgCompute::Memory::getNumElements();
         if( numElements == 0 )
         {
             if( !_texref.valid() )
@@ -319,7 +381,7 @@ namespace osgCuda
     }
 
     //------------------------------------------------------------------------------
-     unsigned int TextureMemory::getAllocatedByteSize( unsigned int mapping, unsigned int hint /*= 0 */ ) const
+     size_t TextureMemory::getAllocatedByteSize( unsigned int mapping, unsigned int hint /*= 0 */ ) const
     {
         ////////////////////
         // RECEIVE HANDLE //
@@ -329,7 +391,7 @@ namespace osgCuda
             return NULL;
         const TextureObject& memory = *memoryPtr;
 
-        unsigned int allocSize = 0;
+        size_t allocSize = 0;
         switch( mapping )
         {
         case osgCompute::MAP_DEVICE: case osgCompute::MAP_DEVICE_TARGET: case osgCompute::MAP_DEVICE_SOURCE:
@@ -353,9 +415,9 @@ namespace osgCuda
     }
 
     //------------------------------------------------------------------------------
-    unsigned int TextureMemory::getByteSize( unsigned int mapping/* = osgCompute::MAP_DEVICE*/, unsigned int hint /*= 0 */  ) const
+    size_t TextureMemory::getByteSize( unsigned int mapping/* = osgCompute::MAP_DEVICE*/, unsigned int hint /*= 0 */  ) const
     {
-        unsigned int allocSize = 0;
+        size_t allocSize = 0;
         switch( mapping )
         {
         case osgCompute::MAP_DEVICE: case osgCompute::MAP_DEVICE_TARGET: case osgCompute::MAP_DEVICE_SOURCE:
@@ -387,7 +449,7 @@ namespace osgCuda
     }
 
     //------------------------------------------------------------------------------
-    void* TextureMemory::map( unsigned int mapping/* = osgCompute::MAP_DEVICE*/, unsigned int offset/* = 0*/, unsigned int hint/* = 0*/ )
+    void* TextureMemory::map( unsigned int mapping/* = osgCompute::MAP_DEVICE*/, size_t offset/* = 0*/, unsigned int hint/* = 0*/ )
     {
 		if( !_texref.valid() )
 			return NULL;
@@ -398,6 +460,10 @@ namespace osgCuda
             return NULL;
         }
 
+        // Copy deferred content first
+        if( getPayload() != NULL )
+            applyPayload();
+
         ////////////////////
         // RECEIVE HANDLE //
         ////////////////////
@@ -443,6 +509,13 @@ namespace osgCuda
                 if( !setup( mapping ) )
                     return NULL;
 
+            /////////////////////
+            // FINISH READBACK //
+            /////////////////////
+            if( memory._numReadbacks > 0 )
+                if( !finishReadback() )
+                    return NULL;
+
             /////////////////
             // SYNC STREAM //
             /////////////////
@@ -512,6 +585,8 @@ namespace osgCuda
                 if( !sync( mapping ) )
                     return NULL;
 
+            // Account registered texture and shadow-copy
+            osgCompute::MemoryBudget::instance()->update( *this, memory, getDeviceByteSize() );
             ptr = memory._graphicsArray;
         }
         else if( (mapping & osgCompute::MAP_DEVICE) )
@@ -541,6 +616,8 @@ namespace osgCuda
                 if( !sync( mapping ) )
                     return NULL;
 
+            // Account registered texture and shadow-copy
+            osgCompute::MemoryBudget::instance()->update( *this, memory, getDeviceByteSize() );
             ptr = memory._devPtr;
         }
         else
@@ -576,16 +653,27 @@ namespace osgCuda
         {
             memory._syncOp |= osgCompute::SYNC_DEVICE;
             memory._syncOp |= osgCompute::SYNC_HOST;
+            memory._writeCount++;
         }
         else if( (mapping & osgCompute::MAP_DEVICE_TARGET) == osgCompute::MAP_DEVICE_TARGET )
         {
             memory._syncOp |= osgCompute::SYNC_ARRAY;
             memory._syncOp |= osgCompute::SYNC_HOST;
+            memory._writeCount++;
+
+            // Everything is dirty unless the mapping declares a region
+            if( memory._dirtyUndeclared )
+                memory._dirtyAll = true;
+            memory._dirtyUndeclared = true;
         }
         else if( (mapping & osgCompute::MAP_HOST_TARGET) == osgCompute::MAP_HOST_TARGET )
         {
             memory._syncOp |= osgCompute::SYNC_ARRAY;
             memory._syncOp |= osgCompute::SYNC_DEVICE;
+            memory._writeCount++;
+
+            // Dirty regions refer to the device memory only
+            memory._dirtyAll = true;
         }
 
         return &static_cast<char*>(ptr)[offset];
@@ -608,18 +696,9 @@ namespace osgCuda
         //////////////////
         // UNMAP MEMORY //
         //////////////////
-        // Copy current memory to texture memory
-        if( memory._syncOp & osgCompute::SYNC_ARRAY && osgCompute::GLMemory::getContext() != NULL )
-        {
-            if( NULL == map( osgCompute::MAP_DEVICE_ARRAY, 0 ) )
-            {
-                osg::notify(osg::FATAL)
-                    << __FUNCTION__ <<" " << _texref->getName() << ": error during device memory synchronization (map())."
-                    << std::endl;
-
-                return;
-            }
-        }
+        // The texture memory is updated in flush() right before the 
+        // texture is used by OpenGL. Several mappings within a frame
+        // thus lead to a single copy.
 
         // Change current context to render context
         if( memory._graphicsArray != NULL )
@@ -659,6 +738,7 @@ namespace osgCuda
         // Reset image data during the next mapping
         memory._lastModifiedCount = UINT_MAX;
         memory._syncOp = osgCompute::NO_SYNC;
+        memory._writeCount++;
 
         // Reset host memory
         if( memory._hostPtr != NULL && _texref->getImage(0) == NULL )
@@ -792,11 +872,181 @@ namespace osgCuda
 
 
     
+    //------------------------------------------------------------------------------
+    void TextureMemory::addDirtyRegion( size_t offset, size_t byteSize, unsigned int )
+    {
+        TextureObject* memoryPtr = dynamic_cast<TextureObject*>( object(false) );
+        if( !memoryPtr || byteSize == 0 )
+            return;
+        TextureObject& memory = *memoryPtr;
+
+        if( memory._dirtyEnd <= memory._dirtyBegin )
+        {
+            memory._dirtyBegin = offset;
+            memory._dirtyEnd = offset + byteSize;
+        }
+        else
+        {
+            memory._dirtyBegin = osg::minimum( memory._dirtyBegin, offset );
+            memory._dirtyEnd = osg::maximum( memory._dirtyEnd, offset + byteSize );
+        }
+
+        memory._dirtyUndeclared = false;
+    }
+
+    //------------------------------------------------------------------------------
+    bool TextureMemory::requestReadback( unsigned int )
+    {
+        if( !_texref.valid() )
+            return false;
+
+        ////////////////////
+        // RECEIVE HANDLE //
+        ////////////////////
+        TextureObject* memoryPtr = dynamic_cast<TextureObject*>( object(true) );
+        if( !memoryPtr )
+            return false;
+        TextureObject& memory = *memoryPtr;
+
+        // All staging buffers are in use
+        if( memory._numReadbacks == OSGCUDA_NUM_READBACKS )
+            return false;
+
+        /////////////////////
+        // RECEIVE STAGING //
+        /////////////////////
+        TextureObject::Readback& readback = memory._readbacks[(memory._firstReadback + memory._numReadbacks) % OSGCUDA_NUM_READBACKS];
+        if( readback._hostPtr != NULL && readback._byteSize != getAllElementsSize() )
+        {
+            // Size has changed. Copies into unused staging 
+            // buffers have finished with the newest readback.
+            cudaFreeHost( readback._hostPtr );
+            readback._hostPtr = NULL;
+            readback._byteSize = 0;
+        }
+
+        if( readback._hostPtr == NULL )
+        {
+            cudaError res = cudaMallocHost( &readback._hostPtr, getAllElementsSize() );
+            if( cudaSuccess != res )
+            {
+                osg::notify(osg::FATAL)
+                    << __FUNCTION__ <<" " << _texref->getName() << ": error during cudaMallocHost()."
+                    << " " << cudaGetErrorString( res ) <<"."
+                    << std::endl;
+
+                readback._hostPtr = NULL;
+                return false;
+            }
+
+            readback._byteSize = getAllElementsSize();
+        }
+
+        if( readback._event == NULL )
+            cudaEventCreateWithFlags( &readback._event, cudaEventDisableTiming );
+
+        ////////////////
+        // START COPY //
+        ////////////////
+        size_t rowSize = getDimension(0) * getElementSize();
+        cudaError res = cudaSuccess;
+        if( memory._hostPtr != NULL && !(memory._syncOp & osgCompute::SYNC_HOST) )
+        {
+            // Host memory is current
+            memcpy( readback._hostPtr, memory._hostPtr, getAllElementsSize() );
+        }
+        else if( memory._devPtr != NULL && !(memory._syncOp & osgCompute::SYNC_DEVICE) )
+        {
+            // Linear device memory is current. This path does not require 
+            // an OpenGL context and is utilized in headless mode.
+            if( getNumDimensions() == 3 )
+            {
+                cudaMemcpy3DParms memCpyParams = {0};
+                memCpyParams.srcPtr = make_cudaPitchedPtr( memory._devPtr, memory._pitch, rowSize, getDimension(1) );
+                memCpyParams.dstPtr = make_cudaPitchedPtr( readback._hostPtr, rowSize, rowSize, getDimension(1) );
+                memCpyParams.extent = make_cudaExtent( rowSize, getDimension(1), getDimension(2) );
+                memCpyParams.kind = cudaMemcpyDeviceToHost;
+                res = cudaMemcpy3DAsync( &memCpyParams, 0 );
+            }
+            else if( getNumDimensions() == 2 )
+            {
+                res = cudaMemcpy2DAsync( readback._hostPtr, rowSize, memory._devPtr, memory._pitch, 
+                                         rowSize, getDimension(1), cudaMemcpyDeviceToHost, 0 );
+            }
+            else
+            {
+                res = cudaMemcpyAsync( readback._hostPtr, memory._devPtr, getAllElementsSize(), cudaMemcpyDeviceToHost, 0 );
+            }
+        }
+        else if( osgCompute::GLMemory::getContext() != NULL )
+        {
+            // Copy from the texture. The resource is unmapped before the next 
+            // rendering which orders the copy before any OpenGL access.
+            cudaArray* graphicsArray = static_cast<cudaArray*>( map( osgCompute::MAP_DEVICE_ARRAY ) );
+            if( graphicsArray == NULL )
+                return false;
+
+            if( getNumDimensions() == 3 )
+            {
+                cudaMemcpy3DParms memCpyParams = {0};
+                memCpyParams.srcArray = graphicsArray;
+                memCpyParams.dstPtr = make_cudaPitchedPtr( readback._hostPtr, rowSize, getDimension(0), getDimension(1) );
+                memCpyParams.extent = make_cudaExtent( getDimension(0), getDimension(1), getDimension(2) );
+                memCpyParams.kind = cudaMemcpyDeviceToHost;
+                res = cudaMemcpy3DAsync( &memCpyParams, 0 );
+            }
+            else if( getNumDimensions() == 2 )
+            {
+                res = cudaMemcpy2DFromArrayAsync( readback._hostPtr, rowSize, graphicsArray, 0, 0, 
+                                                  rowSize, getDimension(1), cudaMemcpyDeviceToHost, 0 );
+            }
+            else
+            {
+                res = cudaMemcpyFromArrayAsync( readback._hostPtr, graphicsArray, 0, 0, getAllElementsSize(), cudaMemcpyDeviceToHost, 0 );
+            }
+        }
+        else
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ <<" " << _texref->getName() << ": no current memory found to read back."
+                << std::endl;
+
+            return false;
+        }
+
+        if( cudaSuccess != res )
+        {
+            osg::notify(osg::FATAL)
+                << __FUNCTION__ <<" " << _texref->getName() << ": error during asynchronous copy."
+                << " " << cudaGetErrorString( res ) <<"."
+                << std::endl;
+
+            return false;
+        }
+
+        cudaEventRecord( readback._event, 0 );
+        readback._writeCount = memory._writeCount;
+        memory._numReadbacks++;
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    bool TextureMemory::isReadbackReady( unsigned int ) const
+    {
+        const TextureObject* memoryPtr = dynamic_cast<const TextureObject*>( object(false) );
+        if( !memoryPtr || memoryPtr->_numReadbacks == 0 )
+            return false;
+
+        // finishReadback() waits for the newest readback only
+        unsigned int newest = (memoryPtr->_firstReadback + memoryPtr->_numReadbacks - 1) % OSGCUDA_NUM_READBACKS;
+        return cudaSuccess == cudaEventQuery( memoryPtr->_readbacks[newest]._event );
+    }
+
     /////////////////////////////////////////////////////////////////////////////////////////////////
     // PROTECTED FUNCTIONS //////////////////////////////////////////////////////////////////////////
     /////////////////////////////////////////////////////////////////////////////////////////////////
     //------------------------------------------------------------------------------
-    unsigned int TextureMemory::computePitch() const
+    size_t TextureMemory::computePitch() const
     {
         // Proof paramters
         if( getNumDimensions() == 0 || getElementSize() == 0 ) 
@@ -829,6 +1079,8 @@ namespace osgCuda
             return NULL;
         TextureObject& memory = *memoryPtr;
 
+        // Image data replaces the content
+        memory._writeCount++;
 
         //////////////////
         // SETUP MEMORY //
@@ -1009,6 +1261,93 @@ namespace osgCuda
         return true;
     }
 
+    //------------------------------------------------------------------------------
+    void TextureMemory::flush()
+    {
+        if( !_texref.valid() )
+            return;
+
+        TextureObject* memoryPtr = dynamic_cast<TextureObject*>( object(false) );
+        if( !memoryPtr )
+            return;
+        TextureObject& memory = *memoryPtr;
+
+        // Copy current memory to texture memory
+        if( memory._syncOp & osgCompute::SYNC_ARRAY && osgCompute::GLMemory::getContext() != NULL )
+        {
+            if( NULL == map( osgCompute::MAP_DEVICE_ARRAY, 0 ) )
+            {
+                osg::notify(osg::FATAL)
+                    << __FUNCTION__ <<" " << _texref->getName() << ": error during device memory synchronization (map())."
+                    << std::endl;
+
+                return;
+            }
+        }
+
+        unmap();
+    }
+
+    //------------------------------------------------------------------------------
+    void TextureMemory::getDirtyRange( size_t unitSize, size_t numUnits, size_t& first, size_t& count ) const
+    {
+        first = 0;
+        count = numUnits;
+
+        const TextureObject* memoryPtr = dynamic_cast<const TextureObject*>( object(false) );
+        if( !memoryPtr || unitSize == 0 )
+            return;
+        const TextureObject& memory = *memoryPtr;
+
+        if( memory._dirtyAll || memory._dirtyUndeclared || memory._dirtyEnd <= memory._dirtyBegin )
+            return;
+
+        first = osg::minimum( memory._dirtyBegin / unitSize, numUnits );
+        size_t last = osg::minimum( (memory._dirtyEnd + unitSize - 1) / unitSize, numUnits );
+        count = last - first;
+    }
+
+    //------------------------------------------------------------------------------
+    bool TextureMemory::finishReadback()
+    {
+        TextureObject* memoryPtr = dynamic_cast<TextureObject*>( object(false) );
+        if( !memoryPtr )
+            return false;
+        TextureObject& memory = *memoryPtr;
+
+        // Only the most recent readback is of interest. Older readbacks 
+        // are superseded and their staging buffers are released. Waits 
+        // only if the copy is still in flight.
+        unsigned int newest = (memory._firstReadback + memory._numReadbacks - 1) % OSGCUDA_NUM_READBACKS;
+        TextureObject::Readback& readback = memory._readbacks[newest];
+        cudaError res = cudaEventSynchronize( readback._event );
+        memory._firstReadback = (newest + 1) % OSGCUDA_NUM_READBACKS;
+        memory._numReadbacks = 0;
+
+        if( cudaSuccess != res )
+        {
+            osg::notify(osg::FATAL)
+                << __FUNCTION__ <<" " << _texref->getName() << ": error during cudaEventSynchronize()."
+                << " " << cudaGetErrorString( res ) <<"."
+                << std::endl;
+
+            return false;
+        }
+
+        // The memory has been written after the request. The readback 
+        // is outdated and the host memory is synchronized as usual.
+        if( readback._writeCount != memory._writeCount || readback._byteSize != getAllElementsSize() )
+            return true;
+
+        memcpy( memory._hostPtr, readback._hostPtr, getAllElementsSize() );
+
+        // Host memory holds the content at the time of the request
+        if( (memory._syncOp & osgCompute::SYNC_HOST) == osgCompute::SYNC_HOST )
+            memory._syncOp ^= osgCompute::SYNC_HOST;
+
+        return true;
+    }
+
     //------------------------------------------------------------------------------
     bool TextureMemory::alloc( unsigned int mapping )
     {
@@ -1084,6 +1423,16 @@ namespace osgCuda
             if( memory._devPtr != NULL )
                 return true;
 
+            // Free device memory of cold buffers if necessary
+            if( !osgCompute::MemoryBudget::instance()->reserve( *this, getAllElementsSize() ) )
+            {
+                osg::notify(osg::FATAL)
+                    << __FUNCTION__ <<" " << _texref->getName() << ": device memory budget exceeded."
+                    << std::endl;
+
+                return false;
+            }
+
             // Allocate shadow-copy memory
             if( getNumDimensions() == 3 )
             {
@@ -1249,10 +1598,13 @@ namespace osgCuda
             }
             else
             {
-                // Copy from device memory
+                // Copy from device memory. Only the dirty 
+                // bytes, rows or slices are copied.
+                size_t first = 0, count = 0;
                 if( getNumDimensions() < 2 )
                 {
-                    res = cudaMemcpyToArray( memory._graphicsArray, 0, 0, memory._devPtr, getAllElementsSize(), cudaMemcpyDeviceToDevice);
+                    getDirtyRange( 1, getAllElementsSize(), first, count );
+                    res = cudaMemcpyToArray( memory._graphicsArray, first, 0, &static_cast<char*>(memory._devPtr)[first], count, cudaMemcpyDeviceToDevice);
                     if( cudaSuccess != res )
                     {
                         osg::notify(osg::FATAL)
@@ -1265,8 +1617,9 @@ namespace osgCuda
                 }
                 else if( getNumDimensions() == 2 ) 
                 {
-                    res = cudaMemcpy2DToArray( memory._graphicsArray, 0, 0, memory._devPtr, 
-                                               memory._pitch,  getDimension(0)*getElementSize(), getDimension(1), 
+                    getDirtyRange( memory._pitch, getDimension(1), first, count );
+                    res = cudaMemcpy2DToArray( memory._graphicsArray, 0, first, &static_cast<char*>(memory._devPtr)[first * memory._pitch], 
+                                               memory._pitch,  getDimension(0)*getElementSize(), count, 
                                                cudaMemcpyDeviceToDevice );
                     if( cudaSuccess != res )
                     {
@@ -1280,15 +1633,19 @@ namespace osgCuda
                 }
                 else
                 {
+                    getDirtyRange( memory._pitch * getDimension(1), getDimension(2), first, count );
+
                     cudaMemcpy3DParms memCpyParams = {0};
                     memCpyParams.dstArray = memory._graphicsArray;
                     memCpyParams.kind = cudaMemcpyDeviceToDevice;
                     memCpyParams.srcPtr = make_cudaPitchedPtr(memory._devPtr, memory._pitch, getDimension(0), getDimension(1));
+                    memCpyParams.srcPos = make_cudaPos( 0, 0, first );
+                    memCpyParams.dstPos = make_cudaPos( 0, 0, first );
 
                     cudaExtent arrayExtent = {0};
                     arrayExtent.width = getDimension(0);
                     arrayExtent.height = getDimension(1);
-                    arrayExtent.depth = getDimension(2);
+                    arrayExtent.depth = count;
 
                     memCpyParams.extent = arrayExtent;
 
@@ -1306,6 +1663,10 @@ namespace osgCuda
             }
 
             memory._syncOp = memory._syncOp ^ osgCompute::SYNC_ARRAY;
+            memory._dirtyBegin = 0;
+            memory._dirtyEnd = 0;
+            memory._dirtyAll = false;
+            memory._dirtyUndeclared = false;
             return true;
         }
         else if( mapping & osgCompute::MAP_DEVICE )
@@ -1455,6 +1816,9 @@ namespace osgCuda
 
                     return false;
                 }
+
+                // The complete device memory has changed
+                memory._dirtyAll = true;
             }
 
             memory._syncOp = memory._syncOp ^ osgCompute::SYNC_DEVICE;
@@ -1668,6 +2032,12 @@ namespace osgCuda
         return false;
     }
 
+    //------------------------------------------------------------------------------
+    size_t TextureMemory::getDeviceByteSize() const
+    {
+        return getAllocatedByteSize( osgCompute::MAP_DEVICE ) + getAllocatedByteSize( osgCompute::MAP_DEVICE_ARRAY );
+    }
+
     //------------------------------------------------------------------------------
     osgCompute::MemoryObject* TextureMemory::createObject() const
     {
@@ -1770,10 +2140,11 @@ namespace osgCuda
     void Texture2D::apply(osg::State& state) const
     {
         // Currently we support  a single OpenGL context only. So unmap memory every
-        // time releaseGLObjects() is called.
+        // time releaseGLObjects() is called. Pending device changes are copied 
+        // to the texture once.
         //if( osgCompute::GLMemory::getContext() != NULL && 
         //    state.getContextID() == osgCompute::GLMemory::getContext()->getState()->getContextID() )
-        _memory->unmap();
+        static_cast<TextureMemory*>( _memory.get() )->flush();
 
         osg::Texture2D::apply( state );
     }
@@ -1892,10 +2263,11 @@ namespace osgCuda
     void Texture3D::apply(osg::State& state) const
     {
         // Currently we support  a single OpenGL context only. So unmap memory every
-        // time releaseGLObjects() is called.
+        // time releaseGLObjects() is called. Pending device changes are copied 
+        // to the texture once.
         //if( osgCompute::GLMemory::getContext() != NULL && 
         //    state.getContextID() == osgCompute::GLMemory::getContext()->getState()->getContextID() )
-        _memory->unmap();
+        static_cast<TextureMemory*>( _memory.get() )->flush();
 
         osg::Texture3D::apply( state );
     }
@@ -2014,10 +2386,11 @@ namespace osgCuda
     void TextureRectangle::apply(osg::State& state) const
     {
         // Currently we support  a single OpenGL context only. So unmap memory every
-        // time releaseGLObjects() is called.
+        // time releaseGLObjects() is called. Pending device changes are copied 
+        // to the texture once.
         //if( osgCompute::GLMemory::getContext() != NULL && 
         //    state.getContextID() == osgCompute::GLMemory::getContext()->getState()->getContextID() )
-        _memory->unmap();
+        static_cast<TextureMemory*>( _memory.get() )->flush();
 
         osg::TextureRectangle::apply( state );
     }
@@ -4,6 +4,8 @@
 #include <cuda_gl_interop.h>
 #include <osg/OperationThread>
 #include <osgCompute/Memory>
+#include <osgCompute/Computation>
+#include <osgCompute/Device>
 #include <osgCudaInit/Init>
 
 namespace osgCuda
@@ -148,4 +150,119 @@ namespace osgCuda
 
         return true;
     }
+
+    //------------------------------------------------------------------------------
+    bool setupOsgCudaHeadless( int device /*= 0*/ )
+    {
+        int deviceCount = 0;
+        cudaError res = cudaGetDeviceCount( &deviceCount );
+        if( cudaSuccess != res )
+        {
+            osg::notify(osg::FATAL)  
+                << __FUNCTION__ << ": error during cudaGetDeviceCount()."
+                << cudaGetErrorString(res)
+                << std::endl;
+
+            return false;
+        }
+
+        if( device > deviceCount - 1 )
+        {
+            osg::notify(osg::FATAL)   
+                << __FUNCTION__ << ": device \""<<device<<"\" does not exist."
+                << std::endl;
+
+            return false;
+        }
+
+        // No OpenGL interoperability here
+        res = cudaSetDevice( device );
+        if( cudaSuccess != res )
+        {
+            osg::notify(osg::FATAL)  
+                << __FUNCTION__ << ": cannot setup device."
+                << cudaGetErrorString(res) 
+                << std::endl;
+            return false;
+        }
+
+        osgCompute::Computation::setHeadless( true );
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    class CudaDevice : public osgCompute::Device
+    {
+    public:
+        CudaDevice( unsigned int id ) : osgCompute::Device( id ) {}
+
+        virtual bool makeCurrent()
+        {
+            cudaError res = cudaSetDevice( static_cast<int>(_id) );
+            if( cudaSuccess != res )
+            {
+                osg::notify(osg::WARN)  
+                    << __FUNCTION__ << ": cannot activate device \"" << _id << "\". "
+                    << cudaGetErrorString(res) 
+                    << std::endl;
+                return false;
+            }
+
+            return true;
+        }
+
+        virtual bool isEmulated() const { return false; }
+
+        virtual std::string getName() const
+        {
+            // Querying the properties is expensive and 
+            // the name is requested during each tuned launch
+            if( _name.empty() )
+            {
+                cudaDeviceProp prop;
+                if( cudaSuccess != cudaGetDeviceProperties( &prop, static_cast<int>(_id) ) )
+                    return "CUDA";
+
+                _name = prop.name;
+            }
+
+            return _name;
+        }
+
+    protected:
+        virtual ~CudaDevice() {}
+
+        mutable std::string _name;
+    };
+
+    //------------------------------------------------------------------------------
+    unsigned int setupOsgCudaDevices( unsigned int numEmulated /*= 0*/ )
+    {
+        osgCompute::Device::removeAllDevices();
+
+        if( numEmulated != 0 )
+        {
+            for( unsigned int d=0; d<numEmulated; ++d )
+                osgCompute::Device::addDevice( *new osgCompute::Device(d) );
+
+            return osgCompute::Device::getNumDevices();
+        }
+
+        int deviceCount = 0;
+        cudaError res = cudaGetDeviceCount( &deviceCount );
+        if( cudaSuccess != res )
+        {
+            osg::notify(osg::FATAL)  
+                << __FUNCTION__ << ": error during cudaGetDeviceCount()."
+                << cudaGetErrorString(res)
+                << std::endl;
+
+            return 0;
+        }
+
+        for( int d=0; d<deviceCount; ++d )
+            osgCompute::Device::addDevice( *new CudaDevice(d) );
+
+        return osgCompute::Device::getNumDevices();
+    }
 } 
@@ -1,19 +1,279 @@
+#include <cstring>
+#include <vector>
+#include <osg/Notify>
 #include <osg/io_utils>
 #include <osgDB/ReadFile>
 #include <osgDB/WriteFile>
 #include <osgDB/Registry>
+#include <osgDB/Options>
 #include <osgDB/Input>
 #include <osgDB/Output>
 #include <osgDB/ParameterOutput>
 #include <osgCuda/Buffer>
 #include "Util.h"
 
+// Number of bytes per line in ascii files
+#define OSGCUDA_DATA_BYTES_PER_LINE 32
+// Maximum number of bytes per binary block
+#define OSGCUDA_DATA_BYTES_PER_BLOCK 0x40000000
+
+//------------------------------------------------------------------------------
+// Sizes are stored as two 32-bit values in order to support 
+// buffers with 4GB and more. The shift is split into two 
+// operations as size_t might be a 32-bit value.
+static unsigned int getHighBits( size_t value )
+{
+	return static_cast<unsigned int>( (value >> 16) >> 16 );
+}
+
+//------------------------------------------------------------------------------
+static inline unsigned char hexValue( char digit )
+{
+	if( digit >= '0' && digit <= '9' ) return static_cast<unsigned char>( digit - '0' );
+	if( digit >= 'a' && digit <= 'f' ) return static_cast<unsigned char>( digit - 'a' + 10 );
+	if( digit >= 'A' && digit <= 'F' ) return static_cast<unsigned char>( digit - 'A' + 10 );
+	return 0;
+}
+
+//------------------------------------------------------------------------------
+static void decodeLine( const std::string& line, char* data, size_t maxBytes )
+{
+	for( size_t c=0; c+1<line.size() && c/2<maxBytes; c+=2 )
+		data[c/2] = static_cast<char>( (hexValue(line[c]) << 4) | hexValue(line[c+1]) );
+}
+
+//------------------------------------------------------------------------------
+// Data is deferred if the options of the reader contain "DeferredData", e.g.
+// osgDB::readNodeFile( "scene.osgt", new osgDB::Options("DeferredData") )
+static bool deferData( osgDB::InputStream& is )
+{
+	const osgDB::Options* options = is.getOptions();
+	return options != NULL && options->getOptionString().find( "DeferredData" ) != std::string::npos;
+}
+
+//------------------------------------------------------------------------------
+// Keeps the data of a buffer until its first mapping. Ascii data 
+// is decoded by the loader threads or during the first mapping.
+class BufferPayload : public osgCompute::Payload
+{
+public:
+	BufferPayload( size_t byteSize ) : osgCompute::Payload(), _byteSize( byteSize ) {}
+
+	virtual bool apply( osgCompute::Memory& memory )
+	{
+		char* data = NULL;
+		if( _data.size() == _byteSize && _byteSize == memory.getAllElementsSize() )
+			data = static_cast<char*>( memory.map( osgCompute::MAP_HOST_TARGET ) );
+
+		if( data == NULL )
+		{
+			osg::notify(osg::WARN)
+				<< __FUNCTION__ << " " << memory.getName() << ": cannot restore " << _byteSize 
+				<< " bytes of deferred data. Buffer requires " << memory.getAllElementsSize() << " bytes."
+				<< std::endl;
+			return false;
+		}
+
+		memcpy( data, &_data.front(), _byteSize );
+
+		// Free the host copy
+		std::vector<char>().swap( _data );
+		return true;
+	}
+
+	std::vector<char>			_data;
+	std::vector<std::string>	_lines;
+	size_t						_byteSize;
+
+protected:
+	virtual bool decodeImplementation()
+	{
+		if( _lines.empty() )
+			return _data.size() == _byteSize;
+
+		_data.resize( _byteSize );
+		size_t b = 0;
+		for( std::vector<std::string>::const_iterator itr = _lines.begin(); 
+			itr != _lines.end() && b < _byteSize; 
+			++itr, b+=OSGCUDA_DATA_BYTES_PER_LINE )
+			decodeLine( *itr, &_data[b], _byteSize-b );
+
+		std::vector<std::string>().swap( _lines );
+		return true;
+	}
+};
+
+//------------------------------------------------------------------------------
+static bool checkData( const osgCuda::Buffer& buffer )
+{
+	if( !buffer.getSerializeData() )
+		return false;
+
+	// Nothing to store if memory is not allocated
+	return buffer.getAllocatedByteSize( osgCompute::MAP_HOST ) != 0 ||
+		buffer.getAllocatedByteSize( osgCompute::MAP_DEVICE ) != 0 ||
+		buffer.getAllocatedByteSize( osgCompute::MAP_DEVICE_ARRAY ) != 0;
+}
+
+//------------------------------------------------------------------------------
+static bool writeData( osgDB::OutputStream& os, const osgCuda::Buffer& buffer )
+{
+	// Mapping to the host synchronizes the current content.
+	// Host memory is stored without any pitch.
+	size_t byteSize = buffer.getAllElementsSize();
+	const char* data = static_cast<const char*>( 
+		const_cast<osgCuda::Buffer&>(buffer).map( osgCompute::MAP_HOST_SOURCE ) );
+	if( data == NULL )
+		byteSize = 0;
+
+	unsigned int sizeHigh = getHighBits( byteSize );
+	unsigned int sizeLow = static_cast<unsigned int>( byteSize & 0xffffffff );
+	if( os.isBinary() )
+	{
+		os << sizeHigh << sizeLow;
+		for( size_t b=0; b<byteSize; b+=OSGCUDA_DATA_BYTES_PER_BLOCK )
+			os.writeCharArray( &data[b], static_cast<unsigned int>( osg::minimum<size_t>( OSGCUDA_DATA_BYTES_PER_BLOCK, byteSize-b ) ) );
+	}
+	else
+	{
+		static const char* hexDigits = "0123456789abcdef";
+
+		os << sizeHigh << sizeLow << os.BEGIN_BRACKET << std::endl;
+		for( size_t b=0; b<byteSize; b+=OSGCUDA_DATA_BYTES_PER_LINE )
+		{
+			std::string line;
+			for( size_t c=b; c<byteSize && c<b+OSGCUDA_DATA_BYTES_PER_LINE; ++c )
+			{
+				unsigned char curByte = static_cast<unsigned char>( data[c] );
+				line += hexDigits[curByte >> 4];
+				line += hexDigits[curByte & 0xf];
+			}
+			os << line << std::endl;
+		}
+		os << os.END_BRACKET << std::endl;
+	}
+
+	return true;
+}
+
+//------------------------------------------------------------------------------
+static bool readData( osgDB::InputStream& is, osgCuda::Buffer& buffer )
+{
+	unsigned int sizeHigh = 0, sizeLow = 0;
+	if( !is.isBinary() ) 
+		is >> sizeHigh >> sizeLow >> is.BEGIN_BRACKET;
+	else 
+		is >> sizeHigh >> sizeLow;
+
+	size_t byteSize = ((static_cast<size_t>(sizeHigh) << 16) << 16) | sizeLow;
+	if( getHighBits( byteSize ) != sizeHigh )
+	{
+		osg::notify(osg::FATAL)
+			<< __FUNCTION__ << " " << buffer.getName() << ": data exceeds the addressable memory."
+			<< std::endl;
+
+		return false;
+	}
+
+	// Keep the data until the first mapping. Ascii data is decoded 
+	// in parallel by the loader. Binary data needs no decoding but 
+	// has to be consumed from the sequential stream right now.
+	if( byteSize > 0 && byteSize == buffer.getAllElementsSize() && deferData( is ) )
+	{
+		osg::ref_ptr<BufferPayload> payload = new BufferPayload( byteSize );
+		if( is.isBinary() )
+		{
+			payload->_data.resize( byteSize );
+			for( size_t b=0; b<byteSize; b+=OSGCUDA_DATA_BYTES_PER_BLOCK )
+				is.readCharArray( &payload->_data[b], static_cast<unsigned int>( osg::minimum<size_t>( OSGCUDA_DATA_BYTES_PER_BLOCK, byteSize-b ) ) );
+		}
+		else
+		{
+			payload->_lines.reserve( (byteSize + OSGCUDA_DATA_BYTES_PER_LINE - 1) / OSGCUDA_DATA_BYTES_PER_LINE );
+			for( size_t b=0; b<byteSize; b+=OSGCUDA_DATA_BYTES_PER_LINE )
+			{
+				payload->_lines.push_back( std::string() );
+				is >> payload->_lines.back();
+			}
+			is >> is.END_BRACKET;
+		}
+
+		buffer.setPayload( payload.get() );
+		if( !is.isBinary() )
+			osgCompute::PayloadLoader::instance()->submit( *payload );
+
+		return true;
+	}
+
+	// Copy directly into host memory. The device 
+	// is updated during the next mapping.
+	char* data = NULL;
+	if( byteSize > 0 && byteSize == buffer.getAllElementsSize() )
+		data = static_cast<char*>( buffer.map( osgCompute::MAP_HOST_TARGET ) );
+
+	if( byteSize > 0 && data == NULL )
+	{
+		osg::notify(osg::WARN)
+			<< __FUNCTION__ << " " << buffer.getName() << ": cannot restore " << byteSize 
+			<< " bytes of data. Buffer requires " << buffer.getAllElementsSize() << " bytes."
+			<< std::endl;
+	}
+
+	if( is.isBinary() )
+	{
+		std::vector<char> skip;
+		for( size_t b=0; b<byteSize; b+=OSGCUDA_DATA_BYTES_PER_BLOCK )
+		{
+			unsigned int blockSize = static_cast<unsigned int>( osg::minimum<size_t>( OSGCUDA_DATA_BYTES_PER_BLOCK, byteSize-b ) );
+			if( data != NULL ) 
+			{
+				is.readCharArray( &data[b], blockSize );
+			}
+			else
+			{
+				skip.resize( blockSize );
+				is.readCharArray( &skip.front(), blockSize );
+			}
+		}
+	}
+	else
+	{
+		for( size_t b=0; b<byteSize; b+=OSGCUDA_DATA_BYTES_PER_LINE )
+		{
+			std::string line;
+			is >> line;
+			if( data == NULL )
+				continue;
+
+			decodeLine( line, &data[b], byteSize-b );
+		}
+		is >> is.END_BRACKET;
+	}
+
+	return true;
+}
+
 //------------------------------------------------------------------------------
-REGISTER_OBJECT_WRAPPER(osgCuda_Buffer,
+// Binary fields are read by position. Fields behind the image are versioned
+// with the osgCuda domain (see OSGCUDA_SERIALIZER_VERSION), so that files 
+// without the domain skip them.
+REGISTER_CUSTOM_OBJECT_WRAPPER(osgCuda, 
+						osgCuda_Buffer,
 						new osgCuda::Buffer,
 						osgCuda::Buffer,
 						"osg::Object osgCompute::Resource osgCompute::Memory osgCuda::Buffer" )
 {
 	ADD_IMAGE_SERIALIZER( Image, osg::Image, NULL );
+	{
+		UPDATE_TO_VERSION_SCOPED( 1 )
+		ADD_BOOL_SERIALIZER( SerializeData, false );
+		{
+			// The storage format must be known before the data is restored.
+			// Data of files without the format is stored natively.
+			UPDATE_TO_VERSION_SCOPED( 2 )
+			ADD_UINT_SERIALIZER( StorageFormat, 0 );
+		}
+		ADD_USER_SERIALIZER( Data );
+	}
 }
 
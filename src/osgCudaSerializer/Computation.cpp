@@ -1,8 +1,10 @@
 #include <osgDB/Registry>
 #include <osgDB/Input>
 #include <osgDB/Output>
+#include <vector>
 #include <osgCompute/Program>
 #include <osgCompute/Memory>
+#include <osgCompute/HostWorkers>
 #include <osgCuda/Computation>
 #include "Util.h"
 
@@ -11,6 +13,7 @@ ADD_USER_VALUE( UPDATE_AFTERCHILDREN );
 ADD_USER_VALUE( UPDATE_BEFORECHILDREN );
 ADD_USER_VALUE( UPDATE_AFTERCHILDREN_NORENDER );
 ADD_USER_VALUE( UPDATE_BEFORECHILDREN_NORENDER );
+ADD_USER_VALUE( UPDATE_PIPELINED );
 ADD_USER_VALUE( PRE_RENDER );
 ADD_USER_VALUE( POST_RENDER );
 END_USER_TABLE()
@@ -153,19 +156,54 @@ static bool writePrograms( osgDB::OutputStream& os, const osgCuda::Computation&
 	return true;
 }
 
+//------------------------------------------------------------------------------
+// Searches the libraries of the programs in parallel. Found 
+// paths are cached by existsProgram() for loadProgram().
+class FindProgramsJob : public osgCompute::HostJob
+{
+public:
+	FindProgramsJob( const std::vector<std::string>& libraryNames ) : _libraryNames( libraryNames ) {}
+
+	virtual void execute( unsigned int thread, unsigned int numThreads )
+	{
+		size_t begin, end;
+		osgCompute::HostWorkers::getRange( _libraryNames.size(), 1, thread, numThreads, begin, end );
+		for( size_t i=begin; i<end; ++i )
+			osgCompute::Program::existsProgram( _libraryNames[i] );
+	}
+
+private:
+	const std::vector<std::string>&	_libraryNames;
+};
+
 //------------------------------------------------------------------------------
 static bool readPrograms( osgDB::InputStream& is, osgCuda::Computation& computation )
 {
 	unsigned int numMods = 0;  
 	is >> numMods >> is.BEGIN_BRACKET;
 
+	std::vector<std::string> moduleLibraryNames( numMods );
+	for( unsigned int i=0; i<numMods; ++i )
+	{
+		is.readWrappedString( moduleLibraryNames[i] );
+        moduleLibraryNames[i] = osgCuda::trim( moduleLibraryNames[i] );
+	}
+
+	if( numMods > 1 )
+	{
+		FindProgramsJob job( moduleLibraryNames );
+		osgCompute::HostWorkers::instance()->run( job );
+	}
+
+	// Programs are added in file order
 	for( unsigned int i=0; i<numMods; ++i )
 	{
-		std::string moduleLibraryName;
-		is.readWrappedString( moduleLibraryName );
-        moduleLibraryName = osgCuda::trim( moduleLibraryName );
+		const std::string& moduleLibraryName = moduleLibraryNames[i];
 
-		if( !osgCompute::Program::existsProgram(moduleLibraryName) )
+		// loadProgram() consults registered programs first and
+		// reports missing libraries itself
+		osgCompute::Program* module = osgCompute::Program::loadProgram( moduleLibraryName );
+		if( module == NULL )
 		{
 			osg::notify(osg::WARN) 
 				<<" osgCuda_Computation::readPrograms(): cannot find module library "
@@ -174,11 +212,7 @@ static bool readPrograms( osgDB::InputStream& is, osgCuda::Computation& computat
 			continue;
 		}
 
-		osgCompute::Program* module = osgCompute::Program::loadProgram( moduleLibraryName );
-		if( module != NULL )
-		{
-			computation.addProgram( *module );
-		}
+		computation.addProgram( *module );
 	}
 
 	is >> is.END_BRACKET;
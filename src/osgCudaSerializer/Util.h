@@ -2,6 +2,15 @@
 #define OSGCUDA_SERIALIZER_UTIL_H
 
 #include <string>
+
+// Version of the osgCuda serializer domain. Fields which have been 
+// added after the initial wrappers are only read from files carrying 
+// the domain. Writers add it with the plugin string data "domain" 
+// set to "osgCuda:<version>".
+//   1: SerializeData and Data of osgCuda::Buffer
+//   2: StorageFormat of osgCuda::Buffer
+#define OSGCUDA_SERIALIZER_VERSION 2
+
 namespace osgCuda
 {
     std::string trim( const std::string& str );
@@ -0,0 +1,483 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <osg/Notify>
+#include <osg/Timer>
+#include <osg/NodeVisitor>
+#include <osg/FrameStamp>
+#include <osgCompute/Resource>
+#include <osgCompute/Memory>
+#include <osgCompute/MemoryBudget>
+#include <osgCompute/MirrorCompressor>
+#include <osgCompute/Device>
+#include <osgCudaUtil/Timer>
+#include <osgCudaStats/Metrics>
+
+// Number of snapshots which can be buffered
+#define OSGCUDA_METRICS_RING_SIZE 64
+
+namespace osgCuda
+{
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // Helper classes ///////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    class MetricsWriter : public OpenThreads::Thread
+    {
+    public:
+        MetricsWriter( MetricsExporter& exporter ) 
+            : OpenThreads::Thread(), _exporter( exporter ), _done( 0 ) {}
+
+        virtual void run()
+        {
+            while( _done == 0 )
+            {
+                _exporter.flush();
+                OpenThreads::Thread::microSleep( 10000 );
+            }
+
+            // Write remaining snapshots
+            _exporter.flush();
+        }
+
+        void setDone() { ++_done; }
+
+    protected:
+        MetricsExporter&        _exporter;
+        OpenThreads::Atomic     _done;
+    };
+
+    //------------------------------------------------------------------------------
+    static std::string escapeLabel( const std::string& label )
+    {
+        std::string escaped;
+        for( std::string::const_iterator itr = label.begin(); itr != label.end(); ++itr )
+        {
+            if( (*itr) == '\\' || (*itr) == '"' ) escaped += '\\';
+            if( (*itr) == '\n' ) { escaped += "\\n"; continue; }
+            escaped += (*itr);
+        }
+        return escaped;
+    }
+
+    //------------------------------------------------------------------------------
+    // Objects might share the same name. The address identifies them uniquely.
+    static std::string objectId( const void* object )
+    {
+        std::stringstream id;
+        id << object;
+        return id.str();
+    }
+
+    //------------------------------------------------------------------------------
+    static std::string escapeCSV( const std::string& field )
+    {
+        if( field.find_first_of( ",\"\n" ) == std::string::npos )
+            return field;
+
+        std::string escaped = "\"";
+        for( std::string::const_iterator itr = field.begin(); itr != field.end(); ++itr )
+        {
+            if( (*itr) == '"' ) escaped += '"';
+            escaped += (*itr);
+        }
+        escaped += "\"";
+        return escaped;
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PUBLIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    MetricsExporter::MetricsExporter()
+        : osg::NodeCallback(),
+          _fileName( "osgCompute.prom" ),
+          _format( FORMAT_PROMETHEUS ),
+          _interval( 1 ),
+          _csvHeaderWritten( false ),
+          _ring( OSGCUDA_METRICS_RING_SIZE ),
+          _writeIdx( 0 ),
+          _readIdx( 0 ),
+          _numDropped( 0 ),
+          _writer( NULL )
+    {
+    }
+
+    //------------------------------------------------------------------------------
+    void MetricsExporter::setFileName( const std::string& fileName )
+    {
+        _fileName = fileName;
+        _csvHeaderWritten = false;
+    }
+
+    //------------------------------------------------------------------------------
+    const std::string& MetricsExporter::getFileName() const
+    {
+        return _fileName;
+    }
+
+    //------------------------------------------------------------------------------
+    void MetricsExporter::setFormat( Format format )
+    {
+        _format = format;
+        _csvHeaderWritten = false;
+    }
+
+    //------------------------------------------------------------------------------
+    MetricsExporter::Format MetricsExporter::getFormat() const
+    {
+        return _format;
+    }
+
+    //------------------------------------------------------------------------------
+    void MetricsExporter::setInterval( unsigned int interval )
+    {
+        _interval = (interval != 0)? interval : 1;
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int MetricsExporter::getInterval() const
+    {
+        return _interval;
+    }
+
+    //------------------------------------------------------------------------------
+    bool MetricsExporter::start()
+    {
+        if( _writer != NULL )
+            return true;
+
+        _writer = new MetricsWriter( *this );
+        if( _writer->start() != 0 )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << ": cannot start writer thread."
+                << std::endl;
+
+            delete _writer;
+            _writer = NULL;
+            return false;
+        }
+
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    void MetricsExporter::stop()
+    {
+        if( _writer == NULL )
+            return;
+
+        static_cast<MetricsWriter*>( _writer )->setDone();
+        _writer->join();
+        delete _writer;
+        _writer = NULL;
+    }
+
+    //------------------------------------------------------------------------------
+    bool MetricsExporter::isRunning() const
+    {
+        return (_writer != NULL);
+    }
+
+    //------------------------------------------------------------------------------
+    void MetricsExporter::snapshot( unsigned int frameNumber )
+    {
+        // Only the reading thread releases slots 
+        unsigned int writeIdx = _writeIdx;
+        if( writeIdx - static_cast<unsigned int>(_readIdx) >= _ring.size() )
+        {
+            ++_numDropped;
+            return;
+        }
+
+        Snapshot& snapshot = _ring[writeIdx % _ring.size()];
+        snapshot._frameNumber = frameNumber;
+        snapshot._time = osg::Timer::instance()->time_s();
+        snapshot._samples.clear();
+
+        ////////////
+        // MEMORY //
+        ////////////
+        addMemorySamples( snapshot, "osgCuda::Buffer" );
+        addMemorySamples( snapshot, "osgCuda::TextureMemory" );
+        addMemorySamples( snapshot, "osgCuda::GeometryMemory" );
+        addMemorySamples( snapshot, "osgCuda::IndexedGeometryMemory" );
+
+        ////////////
+        // TIMERS //
+        ////////////
+        osgCompute::ResourceClassList timerList = osgCompute::ResourceObserver::instance()->getResources( "osgCuda::Timer" );
+        for( osgCompute::ResourceClassListItr itr = timerList.begin(); itr != timerList.end(); ++itr )
+        {
+            const osgCuda::Timer* curTimer = dynamic_cast<const osgCuda::Timer*>( (*itr).get() );
+            if( NULL == curTimer )
+                continue;
+
+            Sample sample;
+            sample._metric = "osgcompute_timer_milliseconds";
+            sample._id = objectId( curTimer );
+            sample._name = curTimer->getName();
+            sample._kind = "last"; sample._value = curTimer->getLastTime();
+            snapshot._samples.push_back( sample );
+            sample._kind = "average"; sample._value = curTimer->getAveTime();
+            snapshot._samples.push_back( sample );
+            sample._kind = "peak"; sample._value = curTimer->getPeakTime();
+            snapshot._samples.push_back( sample );
+            sample._kind = "window_peak"; sample._value = curTimer->getWindowPeakTime();
+            snapshot._samples.push_back( sample );
+            sample._kind = "p50"; sample._value = curTimer->getPercentileTime( 0.5f );
+            snapshot._samples.push_back( sample );
+            sample._kind = "p90"; sample._value = curTimer->getPercentileTime( 0.9f );
+            snapshot._samples.push_back( sample );
+            sample._kind = "p99"; sample._value = curTimer->getPercentileTime( 0.99f );
+            snapshot._samples.push_back( sample );
+            sample._kind = "p999"; sample._value = curTimer->getPercentileTime( 0.999f );
+            snapshot._samples.push_back( sample );
+
+            sample._metric = "osgcompute_timer_calls";
+            sample._kind = ""; sample._value = curTimer->getCalls();
+            snapshot._samples.push_back( sample );
+        }
+
+        ////////////
+        // BUDGET //
+        ////////////
+        osgCompute::MemoryBudget* budget = osgCompute::MemoryBudget::instance();
+        unsigned int numDevices = osg::maximum( osgCompute::Device::getNumDevices(), 1u );
+        for( unsigned int d=0; d<numDevices; ++d )
+        {
+            std::stringstream device;
+            device << d;
+
+            Sample sample;
+            sample._metric = "osgcompute_device_memory_bytes";
+            sample._name = device.str();
+            sample._kind = "usage"; sample._value = static_cast<double>( budget->getUsage(d) );
+            snapshot._samples.push_back( sample );
+            sample._kind = "budget"; sample._value = static_cast<double>( budget->getBudget(d) );
+            snapshot._samples.push_back( sample );
+        }
+
+        Sample sample;
+        sample._metric = "osgcompute_evictions_total";
+        sample._counter = true;
+        sample._value = budget->getNumEvictions();
+        snapshot._samples.push_back( sample );
+        sample._metric = "osgcompute_evicted_bytes_total";
+        sample._counter = true;
+        sample._value = static_cast<double>( budget->getEvictedByteSize() );
+        snapshot._samples.push_back( sample );
+        sample._metric = "osgcompute_restores_total";
+        sample._counter = true;
+        sample._value = budget->getNumRestores();
+        snapshot._samples.push_back( sample );
+
+        ////////////////
+        // COMPRESSOR //
+        ////////////////
+        osgCompute::MirrorCompressor* compressor = osgCompute::MirrorCompressor::instance();
+        sample._metric = "osgcompute_host_mirror_bytes";
+        sample._counter = false;
+        sample._kind = "compressed"; sample._value = static_cast<double>( compressor->getCompressedByteSize() );
+        snapshot._samples.push_back( sample );
+        sample._kind = "uncompressed"; sample._value = static_cast<double>( compressor->getUncompressedByteSize() );
+        snapshot._samples.push_back( sample );
+        sample._kind = "";
+        sample._metric = "osgcompute_compressions_total";
+        sample._counter = true;
+        sample._value = compressor->getNumCompressions();
+        snapshot._samples.push_back( sample );
+        sample._metric = "osgcompute_decompressions_total";
+        sample._counter = true;
+        sample._value = compressor->getNumDecompressions();
+        snapshot._samples.push_back( sample );
+
+        // Publish the snapshot
+        ++_writeIdx;
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int MetricsExporter::flush()
+    {
+        unsigned int numWritten = 0;
+        while( static_cast<unsigned int>(_readIdx) != static_cast<unsigned int>(_writeIdx) )
+        {
+            unsigned int readIdx = _readIdx;
+            if( write( _ring[readIdx % _ring.size()] ) )
+                ++numWritten;
+
+            // Release the slot
+            ++_readIdx;
+        }
+
+        return numWritten;
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int MetricsExporter::getNumDropped() const
+    {
+        return _numDropped;
+    }
+
+    //------------------------------------------------------------------------------
+    void MetricsExporter::operator()( osg::Node* node, osg::NodeVisitor* nv )
+    {
+        if( nv != NULL && nv->getFrameStamp() != NULL )
+        {
+            unsigned int frameNumber = nv->getFrameStamp()->getFrameNumber();
+            if( frameNumber % _interval == 0 )
+            {
+                snapshot( frameNumber );
+                if( !isRunning() )
+                    flush();
+            }
+        }
+
+        traverse( node, nv );
+    }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // PROTECTED FUNCTIONS //////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    MetricsExporter::~MetricsExporter()
+    {
+        stop();
+    }
+
+    //------------------------------------------------------------------------------
+    void MetricsExporter::addMemorySamples( Snapshot& snapshot, const std::string& classIdentifier )
+    {
+        osgCompute::ResourceClassList curResources = osgCompute::ResourceObserver::instance()->getResources( classIdentifier );
+        for( osgCompute::ResourceClassListItr itr = curResources.begin(); itr != curResources.end(); ++itr )
+        {
+            const osgCompute::Memory* memory = dynamic_cast<const osgCompute::Memory*>( (*itr).get() );
+            if( NULL == memory )
+                continue;
+
+            Sample sample;
+            sample._metric = "osgcompute_memory_bytes";
+            sample._id = objectId( memory );
+            sample._name = memory->getName();
+            sample._kind = "host"; sample._value = static_cast<double>( memory->getAllocatedByteSize( osgCompute::MAP_HOST ) );
+            snapshot._samples.push_back( sample );
+            sample._kind = "host_compressed"; sample._value = static_cast<double>( memory->getCompressedByteSize() );
+            snapshot._samples.push_back( sample );
+            sample._kind = "device"; sample._value = static_cast<double>( memory->getAllocatedByteSize( osgCompute::MAP_DEVICE ) );
+            snapshot._samples.push_back( sample );
+            sample._kind = "array"; sample._value = static_cast<double>( memory->getAllocatedByteSize( osgCompute::MAP_DEVICE_ARRAY ) );
+            snapshot._samples.push_back( sample );
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    bool MetricsExporter::write( const Snapshot& snapshot )
+    {
+        switch( _format )
+        {
+        case FORMAT_CSV: return writeCSV( snapshot );
+        default: return writePrometheus( snapshot );
+        }
+    }
+
+    //------------------------------------------------------------------------------
+    bool MetricsExporter::writePrometheus( const Snapshot& snapshot )
+    {
+        // Write to a temporary file first so readers 
+        // never observe a partially written file
+        std::string tmpFileName = _fileName + ".tmp";
+        std::ofstream file( tmpFileName.c_str(), std::ios::out | std::ios::trunc );
+        if( !file )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << ": cannot open file \"" << tmpFileName << "\"."
+                << std::endl;
+
+            return false;
+        }
+
+        file << "# osgCompute metrics of frame " << snapshot._frameNumber << std::endl;
+
+        // All samples of a metric family must follow a single 
+        // TYPE line. Collect the families in order of appearance.
+        // TYPE line. Collect the families in order of appearance.
+        std::vector<const Sample*> families;
+        for( std::vector<Sample>::const_iterator itr = snapshot._samples.begin(); itr != snapshot._samples.end(); ++itr )
+        {
+            std::vector<const Sample*>::const_iterator fitr = families.begin();
+            while( fitr != families.end() && (*fitr)->_metric != (*itr)._metric )
+                ++fitr;
+
+            if( fitr == families.end() )
+                families.push_back( &(*itr) );
+        }
+
+        for( std::vector<const Sample*>::const_iterator fitr = families.begin(); fitr != families.end(); ++fitr )
+        {
+            file << "# TYPE " << (*fitr)->_metric << (((*fitr)->_counter)? " counter" : " gauge") << std::endl;
+
+            for( std::vector<Sample>::const_iterator itr = snapshot._samples.begin(); itr != snapshot._samples.end(); ++itr )
+            {
+                if( (*itr)._metric != (*fitr)->_metric )
+                    continue;
+
+                // Label sets must be unique within a family
+                file << (*itr)._metric;
+                if( !(*itr)._id.empty() || !(*itr)._name.empty() || !(*itr)._kind.empty() )
+                {
+                    file << "{";
+                    if( !(*itr)._id.empty() )
+                        file << "id=\"" << (*itr)._id << "\",";
+                    file << "name=\"" << escapeLabel( (*itr)._name ) << "\"";
+                    if( !(*itr)._kind.empty() )
+                        file << ",kind=\"" << (*itr)._kind << "\"";
+                    file << "}";
+                }
+                file << " " << (*itr)._value << std::endl;
+            }
+        }
+        file.close();
+
+        // rename() replaces the file atomically
+        if( ::rename( tmpFileName.c_str(), _fileName.c_str() ) != 0 )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << ": cannot replace file \"" << _fileName << "\"."
+                << std::endl;
+
+            return false;
+        }
+
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    bool MetricsExporter::writeCSV( const Snapshot& snapshot )
+    {
+        std::ofstream file( _fileName.c_str(), std::ios::out | std::ios::app );
+        if( !file )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << ": cannot open file \"" << _fileName << "\"."
+                << std::endl;
+
+            return false;
+        }
+
+        if( !_csvHeaderWritten )
+        {
+            file << "frame,time,metric,id,name,kind,value" << std::endl;
+            _csvHeaderWritten = true;
+        }
+
+        file.precision( 10 );
+        for( std::vector<Sample>::const_iterator itr = snapshot._samples.begin(); itr != snapshot._samples.end(); ++itr )
+        {
+            file << snapshot._frameNumber << "," << snapshot._time << "," 
+                 << (*itr)._metric << "," << (*itr)._id << "," << escapeCSV( (*itr)._name ) << "," 
+                 << (*itr)._kind << "," << (*itr)._value << std::endl;
+        }
+
+        return true;
+    }
+}
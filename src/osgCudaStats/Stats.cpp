@@ -136,7 +136,8 @@ namespace osgCuda
         {
             LAST_TIME = 0,
             AVE_TIME = 1,
-            PEAK_TIME = 2
+            PEAK_TIME = 2,
+            PERCENTILES = 3
         };
 
         TimeTextDrawCallback( const osg::observer_ptr<osgCuda::Timer> timer, Type type )
@@ -163,6 +164,14 @@ namespace osgCuda
             case PEAK_TIME:
                  curStream << _timer->getPeakTime();
                 break;
+            case PERCENTILES:
+                curStream.precision(3);
+                curStream << _timer->getPercentileTime(0.5f) << " / "
+                          << _timer->getPercentileTime(0.9f) << " / "
+                          << _timer->getPercentileTime(0.99f) << " / "
+                          << _timer->getPercentileTime(0.999f) << " (window peak "
+                          << _timer->getWindowPeakTime() << ")";
+                break;
             }
 
             curStream << " ms";
@@ -450,6 +459,7 @@ namespace osgCuda
 
         float overallGPUByteSize = 0.0f;
         float hostByteSize = 0.0f;
+        float rawHostByteSize = 0.0f;
         float deviceByteSize = 0.0f;
         float arrayByteSize = 0.0f;
 
@@ -523,12 +533,16 @@ namespace osgCuda
             //consstream << "Array= "<<memory->getMappingByteSize(osgCompute::MAP_DEVICE_ARRAY)/(1048576.0f)<<" MB; "; 
             //consstream << "Sum= " << memory->getAllocatedByteSize()/(1048576.0f) << " MB";
 
-            unsigned int tmpHost   = (*itr).memory->getAllocatedByteSize(osgCompute::MAP_HOST);
-            unsigned int tmpDevice = (*itr).memory->getAllocatedByteSize(osgCompute::MAP_DEVICE);
-            unsigned int tmpArray  = (*itr).memory->getAllocatedByteSize(osgCompute::MAP_DEVICE_ARRAY);
+            size_t tmpHost   = (*itr).memory->getAllocatedByteSize(osgCompute::MAP_HOST);
+            size_t tmpDevice = (*itr).memory->getAllocatedByteSize(osgCompute::MAP_DEVICE);
+            size_t tmpArray  = (*itr).memory->getAllocatedByteSize(osgCompute::MAP_DEVICE_ARRAY);
+            size_t tmpPacked = (*itr).memory->getCompressedByteSize();
+            size_t tmpRaw    = (tmpPacked != 0)? (*itr).memory->getByteSize(osgCompute::MAP_HOST) : tmpHost;
 
 
             consstream << "Host= "   << tmpHost  /(1048576.0f)<<" MB; "; 
+            if( tmpPacked != 0 )
+                consstream << "(compressed from " << tmpRaw/(1048576.0f) << " MB) ";
             consstream << "Device= " << tmpDevice/(1048576.0f)<<" MB; "; 
             consstream << "Array= "  << tmpArray /(1048576.0f)<<" MB; "; 
             consstream << "Sum (D+A) = " << tmpDevice/(1048576.0f) + tmpArray/(1048576.0f) << " MB";
@@ -538,6 +552,7 @@ namespace osgCuda
 
             //overallByteSize += memory->getAllocatedByteSize();
             hostByteSize    += tmpHost;
+            rawHostByteSize += tmpRaw;
             deviceByteSize  += tmpDevice;
             arrayByteSize   += tmpArray;
 
@@ -552,7 +567,8 @@ namespace osgCuda
 
          std::stringstream consstream;
          consstream.precision(5);
-         consstream << "Total Host   (CPU) memory: "  << hostByteSize/(1048576.0f)   << " MB" << "\n" 
+         consstream << "Total Host   (CPU) memory: "  << hostByteSize/(1048576.0f)   << " MB" 
+                    << " (uncompressed " << rawHostByteSize/(1048576.0f) << " MB)" << "\n" 
                     << "Total Device (GPU) memory: "  << deviceByteSize/(1048576.0f) << " MB" << "\n" 
                     << "Total Array  (GPU) memory: "  << arrayByteSize/(1048576.0f)  << " MB" << "\n\n" 
                     << "Total GPU memory (Device+Array): " << overallGPUByteSize/(1048576.0f) << " MB";
@@ -638,6 +654,17 @@ namespace osgCuda
         curPeakTimeLabel->setPosition(pos);
         curPeakTimeLabel->setText( "Peak Time" );
 
+        headerX = curPeakTimeLabel->getBoundingBox().xMax() + 230.0f;
+
+        pos.x() = headerX;
+        osg::ref_ptr<osgText::Text> curPercentileLabel = new osgText::Text;
+        geode->addDrawable( curPercentileLabel.get() );
+        curPercentileLabel->setColor(colorFR);
+        curPercentileLabel->setFont(font);
+        curPercentileLabel->setCharacterSize(characterSize+2.0f);
+        curPercentileLabel->setPosition(pos);
+        curPercentileLabel->setText( "p50 / p90 / p99 / p999" );
+
         startY -= (characterSize+2.0f) * 1.5f;
 
 
@@ -901,6 +928,32 @@ namespace osgCuda
         }
 
         curElementXPos += textElementSize;
+
+        /////////////////////////
+        // Add Percentile Text //
+        /////////////////////////
+        pos.x() = curElementXPos;
+        pos.y() = startY;
+        for( osgCompute::ResourceClassListItr itr = timerList.begin(); itr != timerList.end(); ++itr )
+        {
+            osgCuda::Timer* curTimer = dynamic_cast<osgCuda::Timer*>((*itr).get());
+            if( !(*itr).valid() || (NULL == curTimer) ) 
+                continue;
+
+            osg::ref_ptr<osgText::Text> curValue = new osgText::Text;
+            geode->addDrawable( curValue.get() );
+
+            curValue->setColor(colorFR);
+            curValue->setFont(font);
+            curValue->setCharacterSize(characterSize);
+            curValue->setPosition(pos);
+            curValue->setText("0.0");
+            curValue->setDrawCallback( new TimeTextDrawCallback( curTimer, TimeTextDrawCallback::PERCENTILES ) );
+
+            pos.y() -= characterSize*1.5f;
+        }
+
+        curElementXPos += 2.0f * textElementSize;
     }
 
     //------------------------------------------------------------------------------
@@ -0,0 +1,455 @@
+#include <vector>
+#include <cuda_runtime.h>
+#include <osg/Notify>
+#include <osgCompute/Device>
+#include <osgCompute/Computation>
+#include <osgCuda/Buffer>
+#include <osgCudaUtil/PartitionedBuffer>
+
+namespace osgCuda
+{   
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+	// PUBLIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+	//------------------------------------------------------------------------------
+	PartitionedBuffer::PartitionedBuffer()
+		: osgCompute::Memory()
+	{
+        clearLocal();
+        // Please note that virtual functions className() and libraryName() are called
+        // during observeResource() which will only develop until this class.
+        // However if contructor of a subclass calls this function again observeResource
+        // will change the className and libraryName of the observed pointer.
+        osgCompute::ResourceObserver::instance()->observeResource( *this );
+	}
+
+    //------------------------------------------------------------------------------
+    void PartitionedBuffer::setElementSize( unsigned int elementSize )
+    {
+        // Partitions have to be rebuild
+        _partitions.clear();
+        osgCompute::Memory::setElementSize( elementSize );
+    }
+
+    //------------------------------------------------------------------------------
+    void PartitionedBuffer::setDimension( unsigned int dimIdx, unsigned int dimSize )
+    {
+        // Partitions have to be rebuild
+        _partitions.clear();
+        osgCompute::Memory::setDimension( dimIdx, dimSize );
+    }
+
+    //------------------------------------------------------------------------------
+    void PartitionedBuffer::setHaloSize( unsigned int haloSize )
+    {
+        if( haloSize == _haloSize )
+            return;
+
+        _partitions.clear();
+        _haloSize = haloSize;
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int PartitionedBuffer::getHaloSize() const
+    {
+        return _haloSize;
+    }
+
+    //------------------------------------------------------------------------------
+    bool PartitionedBuffer::createPartitions()
+    {
+        if( getNumDimensions() == 0 || getElementSize() == 0 )
+        {
+            osg::notify( osg::WARN )  
+                << __FUNCTION__ << " " << getName() << ": cannot partition buffer as dimension and element size is unknown."
+                << std::endl;
+
+            return false;
+        }
+
+        unsigned int lastDim = getNumDimensions() - 1;
+        if( getDimension(lastDim) < getNumPartitions() )
+        {
+            osg::notify( osg::WARN )  
+                << __FUNCTION__ << " " << getName() << ": last dimension is smaller than the number of devices."
+                << std::endl;
+
+            return false;
+        }
+
+        // Halos are copied from the direct neighbours only
+        if( getNumPartitions() > 1 && getPartitionSlices( getNumPartitions() - 1 ) < _haloSize )
+        {
+            osg::notify( osg::WARN )  
+                << __FUNCTION__ << " " << getName() << ": halo size " << _haloSize 
+                << " exceeds the " << getPartitionSlices( getNumPartitions() - 1 ) << " slices of the smallest partition."
+                << std::endl;
+
+            return false;
+        }
+
+        _partitions.clear();
+        for( unsigned int p=0; p<getNumPartitions(); ++p )
+        {
+            osg::ref_ptr<osgCuda::Buffer> newBuffer = new osgCuda::Buffer;
+            newBuffer->setName( getName() );
+            newBuffer->setElementSize( getElementSize() );
+            newBuffer->setAllocHint( getAllocHint() );
+            for( unsigned int d=0; d<lastDim; ++d )
+                newBuffer->setDimension( d, getDimension(d) );
+
+            newBuffer->setDimension( lastDim, 
+                getPartitionHaloFront(p) + getPartitionSlices(p) + getPartitionHaloBack(p) );
+
+            _partitions.push_back( newBuffer.get() );
+        }
+
+        return true;
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int PartitionedBuffer::getNumPartitions() const
+    {
+        if( !_partitions.empty() )
+            return _partitions.size();
+
+        unsigned int numDevices = osgCompute::Device::getNumDevices();
+        return (numDevices != 0)? numDevices : 1;
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int PartitionedBuffer::getCurrentPartition() const
+    {
+        return osgCompute::Device::getCurrentIdx() % getNumPartitions();
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int PartitionedBuffer::getPartitionBegin( unsigned int partition ) const
+    {
+        if( getNumDimensions() == 0 )
+            return 0;
+
+        // Distribute the remaining slices among the first partitions
+        unsigned int numSlices = getDimension( getNumDimensions() - 1 );
+        unsigned int numPartitions = getNumPartitions();
+        unsigned int base = numSlices / numPartitions;
+        unsigned int remain = numSlices % numPartitions;
+
+        return partition * base + osg::minimum( partition, remain );
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int PartitionedBuffer::getPartitionSlices( unsigned int partition ) const
+    {
+        if( getNumDimensions() == 0 || partition >= getNumPartitions() )
+            return 0;
+
+        unsigned int numSlices = getDimension( getNumDimensions() - 1 );
+        unsigned int numPartitions = getNumPartitions();
+        return (numSlices / numPartitions) + ((partition < (numSlices % numPartitions))? 1 : 0);
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int PartitionedBuffer::getPartitionHaloFront( unsigned int partition ) const
+    {
+        return osg::minimum( _haloSize, getPartitionBegin(partition) );
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int PartitionedBuffer::getPartitionHaloBack( unsigned int partition ) const
+    {
+        if( getNumDimensions() == 0 )
+            return 0;
+
+        unsigned int numSlices = getDimension( getNumDimensions() - 1 );
+        unsigned int end = getPartitionBegin(partition) + getPartitionSlices(partition);
+        return osg::minimum( _haloSize, numSlices - end );
+    }
+
+    //------------------------------------------------------------------------------
+    osgCompute::Memory* PartitionedBuffer::getPartition( unsigned int partition )
+    {
+        if( partition >= _partitions.size() )
+            return NULL;
+
+        return _partitions[partition].get();
+    }
+
+    //------------------------------------------------------------------------------
+    const osgCompute::Memory* PartitionedBuffer::getPartition( unsigned int partition ) const
+    {
+        if( partition >= _partitions.size() )
+            return NULL;
+
+        return _partitions[partition].get();
+    }
+
+    //------------------------------------------------------------------------------
+    bool PartitionedBuffer::exchangeHalos()
+    {
+        if( _haloSize == 0 || _partitions.size() < 2 )
+            return true;
+
+        unsigned int curDevice = osgCompute::Device::getCurrentIdx();
+        bool hasDevices = (osgCompute::Device::getNumDevices() != 0);
+        bool success = true;
+
+        // Synchronize each partition with its device memory. 
+        // Partitions have to be mapped while their device is active.
+        std::vector<unsigned char*> devPtrs( _partitions.size(), NULL );
+        for( unsigned int p=0; p<_partitions.size() && success; ++p )
+        {
+            if( hasDevices ) osgCompute::Device::setCurrent( p );
+            devPtrs[p] = static_cast<unsigned char*>( _partitions[p]->map( osgCompute::MAP_DEVICE ) );
+            if( devPtrs[p] == NULL )
+            {
+                osg::notify( osg::WARN )  
+                    << __FUNCTION__ << " " << getName() << ": cannot map partition " << p << "."
+                    << std::endl;
+
+                success = false;
+            }
+        }
+
+        // Copy the halo slices only
+        for( unsigned int p=0; p<_partitions.size()-1 && success; ++p )
+        {
+            // Back halo of the left partition receives the first owned slices of the right partition
+            success &= copySlices( devPtrs[p], p, getPartitionHaloFront(p) + getPartitionSlices(p), 
+                devPtrs[p+1], p+1, getPartitionHaloFront(p+1), getPartitionHaloBack(p) );
+
+            // Front halo of the right partition receives the last owned slices of the left partition
+            success &= copySlices( devPtrs[p+1], p+1, 0,
+                devPtrs[p], p, getPartitionHaloFront(p) + getPartitionSlices(p) - getPartitionHaloFront(p+1), getPartitionHaloFront(p+1) );
+        }
+
+        if( hasDevices ) osgCompute::Device::setCurrent( curDevice );
+        return success;
+    }
+
+	//------------------------------------------------------------------------------
+	void* PartitionedBuffer::map( unsigned int mapping/* = osgCompute::MAP_DEVICE*/, size_t offset/* = 0*/, unsigned int /*hint = 0 */ )
+	{
+		if( _partitions.empty() && !createPartitions() )
+			return NULL;
+
+		return _partitions[getCurrentPartition()]->map( mapping, offset );		
+	}
+
+	//------------------------------------------------------------------------------
+	void PartitionedBuffer::unmap( unsigned int /*hint = 0 */ )
+	{
+		if( _partitions.empty() )
+			return;
+
+		_partitions[getCurrentPartition()]->unmap();
+	}
+
+	//------------------------------------------------------------------------------
+	bool PartitionedBuffer::reset( unsigned int /*hint = 0 */ )
+	{
+		if( _partitions.empty() && !createPartitions() )
+			return false;
+
+        bool success = true;
+        for( unsigned int p=0; p<_partitions.size(); ++p )
+            success &= _partitions[p]->reset();
+
+		return success;
+	}
+
+    //------------------------------------------------------------------------------
+    bool PartitionedBuffer::supportsMapping( unsigned int mapping, unsigned int /*hint = 0 */ ) const
+    {
+        switch( mapping )
+        {
+        case osgCompute::UNMAP:
+        case osgCompute::MAP_HOST:
+        case osgCompute::MAP_HOST_SOURCE:
+        case osgCompute::MAP_HOST_TARGET:
+        case osgCompute::MAP_DEVICE:
+        case osgCompute::MAP_DEVICE_SOURCE:
+        case osgCompute::MAP_DEVICE_TARGET:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+	//------------------------------------------------------------------------------
+	unsigned int PartitionedBuffer::getMapping( unsigned int /*hint = 0 */ ) const
+	{
+        if( _partitions.empty() )
+			return osgCompute::UNMAP;
+
+		return _partitions[getCurrentPartition()]->getMapping();
+	}
+
+    //------------------------------------------------------------------------------
+    size_t PartitionedBuffer::getPitch( unsigned int /*hint = 0 */ ) const
+    {
+        if( _partitions.empty() )
+            return computePitch();
+
+        return _partitions[getCurrentPartition()]->getPitch();
+    }
+
+    //------------------------------------------------------------------------------
+    size_t PartitionedBuffer::getAllocatedByteSize( unsigned int mapping, unsigned int /*hint = 0 */ ) const
+    {
+        size_t allocSize = 0;
+        for( unsigned int p=0; p<_partitions.size(); ++p )
+            allocSize += _partitions[p]->getAllocatedByteSize( mapping );
+
+        return allocSize;
+    }
+
+    //------------------------------------------------------------------------------
+    size_t PartitionedBuffer::getByteSize( unsigned int mapping, unsigned int /*hint = 0 */ ) const
+    {
+        if( _partitions.empty() )
+            return 0;
+
+        return _partitions[getCurrentPartition()]->getByteSize( mapping );
+    }
+
+    //------------------------------------------------------------------------------
+    size_t PartitionedBuffer::getAllElementsSize( unsigned int /*hint = 0 */ ) const
+    {
+        if( _partitions.empty() )
+            return osgCompute::Memory::getAllElementsSize();
+
+        return _partitions[getCurrentPartition()]->getAllElementsSize();
+    }
+
+    //------------------------------------------------------------------------------
+    void PartitionedBuffer::releaseObjects()
+    {
+        for( unsigned int p=0; p<_partitions.size(); ++p )
+            _partitions[p]->releaseObjects();
+    }
+
+    //------------------------------------------------------------------------------
+    void PartitionedBuffer::clear()
+    {
+        clearLocal();
+        osgCompute::Memory::clear();
+    }
+
+    //------------------------------------------------------------------------------
+    void PartitionLaunchCallback::operator()( osgCompute::Computation& computation )
+    {
+        unsigned int numDevices = osgCompute::Device::getNumDevices();
+        unsigned int curDevice = osgCompute::Device::getCurrentIdx();
+
+        // Launch all programs once per device. Programs 
+        // map the partition of the current device.
+        for( unsigned int d=0; d<osg::maximum(numDevices,1u); ++d )
+        {
+            if( numDevices != 0 && !osgCompute::Device::setCurrent(d) )
+                continue;
+
+            osgCompute::ProgramList& programs = computation.getPrograms();
+            for( osgCompute::ProgramListItr itr = programs.begin(); itr != programs.end(); ++itr )
+                if( (*itr)->isEnabled() )
+                    (*itr)->launch();
+        }
+
+        if( numDevices != 0 )
+            osgCompute::Device::setCurrent( curDevice );
+
+        // Update halo regions
+        osgCompute::ResourceHandleList& resources = computation.getResources();
+        for( osgCompute::ResourceHandleListItr itr = resources.begin(); itr != resources.end(); ++itr )
+        {
+            PartitionedBuffer* partBuffer = dynamic_cast<PartitionedBuffer*>( (*itr)._resource.get() );
+            if( partBuffer != NULL )
+                partBuffer->exchangeHalos();
+        }
+    }
+
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+	// PROTECTED FUNCTIONS //////////////////////////////////////////////////////////////////////////
+	/////////////////////////////////////////////////////////////////////////////////////////////////
+	//------------------------------------------------------------------------------
+	PartitionedBuffer::~PartitionedBuffer()
+	{
+		clearLocal();
+	}
+
+	//------------------------------------------------------------------------------
+	void PartitionedBuffer::clearLocal()
+	{
+		_partitions.clear();
+		_haloSize = 0;
+	} 
+
+	//------------------------------------------------------------------------------
+    size_t PartitionedBuffer::computePitch() const
+    {
+        if( getNumDimensions() == 0 )
+            return 0;
+
+        return getDimension(0) * getElementSize();
+    }
+
+	//------------------------------------------------------------------------------
+    bool PartitionedBuffer::copySlices( unsigned char* dstPtr, unsigned int dst, unsigned int dstSlice, 
+        const unsigned char* srcPtr, unsigned int src, unsigned int srcSlice, unsigned int numSlices )
+    {
+        if( numSlices == 0 )
+            return true;
+
+        // A slice consists of rows which are pitched in device memory.
+        // One-dimensional buffers store a single element per slice.
+        size_t rowSize = getElementSize();
+        size_t dstPitch = rowSize, srcPitch = rowSize;
+        size_t rowsPerSlice = 1;
+        if( getNumDimensions() > 1 )
+        {
+            rowSize *= getDimension(0);
+            dstPitch = _partitions[dst]->getPitch();
+            srcPitch = _partitions[src]->getPitch();
+            for( unsigned int d=1; d<getNumDimensions()-1; ++d )
+                rowsPerSlice *= getDimension(d);
+        }
+
+        // Devices of the API are addressed by their ordinal. 
+        // Emulated devices share the memory of a single device.
+        osgCompute::Device* dstDevice = osgCompute::Device::getDevice( dst );
+        osgCompute::Device* srcDevice = osgCompute::Device::getDevice( src );
+        bool peer = dstDevice != NULL && srcDevice != NULL && !dstDevice->isEmulated() && !srcDevice->isEmulated();
+
+        size_t numRows = rowsPerSlice * numSlices;
+        dstPtr += dstSlice * rowsPerSlice * dstPitch;
+        srcPtr += srcSlice * rowsPerSlice * srcPitch;
+
+        // Equally pitched slices are copied within a single block
+        if( dstPitch == srcPitch )
+        {
+            rowSize = numRows * dstPitch;
+            numRows = 1;
+        }
+
+        cudaError_t res = cudaSuccess;
+        for( size_t r=0; r<numRows && res == cudaSuccess; ++r )
+        {
+            if( peer )
+                res = cudaMemcpyPeer( &dstPtr[r*dstPitch], static_cast<int>(dstDevice->getId()), &srcPtr[r*srcPitch], static_cast<int>(srcDevice->getId()), rowSize );
+            else
+                res = cudaMemcpy( &dstPtr[r*dstPitch], &srcPtr[r*srcPitch], rowSize, cudaMemcpyDeviceToDevice );
+        }
+
+        if( res != cudaSuccess )
+        {
+            osg::notify( osg::WARN )  
+                << __FUNCTION__ << " " << getName() << ": cannot copy halo from partition " << src 
+                << " to partition " << dst << ". " << cudaGetErrorString( res ) << "."
+                << std::endl;
+
+            return false;
+        }
+
+        return true;
+    }
+}
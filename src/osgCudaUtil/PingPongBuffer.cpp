@@ -47,7 +47,7 @@ namespace osgCuda
     }
 
     //------------------------------------------------------------------------------
-    unsigned int PingPongBuffer::getNumElements() const
+    size_t PingPongBuffer::getNumElements() const
     {
         if( (_stackIdx >= _bufferStack.size()) || !_bufferStack[_stackIdx].valid() ) 
             return osgCompute::Memory::getNumElements();
@@ -81,11 +81,16 @@ namespace osgCuda
     }
 
 	//------------------------------------------------------------------------------
-	void* PingPongBuffer::map( unsigned int mapping/* = osgCompute::MAP_DEVICE*/, unsigned int offset/* = 0*/, unsigned int bufferIdx /*= 0 */ )
+	void* PingPongBuffer::map( unsigned int mapping/* = osgCompute::MAP_DEVICE*/, size_t offset/* = 0*/, unsigned int bufferIdx /*= 0 */ )
 	{
 		unsigned int mapIdx = (_stackIdx + bufferIdx) % _bufferStack.size();
 		if( !_bufferStack[mapIdx].valid() )
-			return NULL;
+		{
+			// Allocate buffers for all entries added
+			// with setSwapCount() on first use
+			if( !createSwapBuffers() || !_bufferStack[mapIdx].valid() )
+				return NULL;
+		}
 
 		osgCompute::Memory* curBuffer = dynamic_cast<osgCompute::Memory*>(_bufferStack[mapIdx].get());
 		return curBuffer->map( mapping, offset );		
@@ -103,7 +108,7 @@ namespace osgCuda
 	}
 
     //------------------------------------------------------------------------------
-    unsigned int PingPongBuffer::getAllocatedByteSize( unsigned int mapping, unsigned int bufferIdx /*= 0 */ ) const
+    size_t PingPongBuffer::getAllocatedByteSize( unsigned int mapping, unsigned int bufferIdx /*= 0 */ ) const
     {
         unsigned int mapIdx = (_stackIdx + bufferIdx) % _bufferStack.size();
         if( _bufferStack.empty() || !_bufferStack[mapIdx].valid() )
@@ -113,7 +118,7 @@ namespace osgCuda
     }
 
     //------------------------------------------------------------------------------
-    unsigned int PingPongBuffer::getByteSize( unsigned int mapping, unsigned int bufferIdx /*= 0 */  ) const
+    size_t PingPongBuffer::getByteSize( unsigned int mapping, unsigned int bufferIdx /*= 0 */  ) const
     {
          unsigned int mapIdx = (_stackIdx + bufferIdx) % _bufferStack.size();
          if( _bufferStack.empty() || !_bufferStack[mapIdx].valid() )
@@ -123,7 +128,7 @@ namespace osgCuda
     }
 
     //------------------------------------------------------------------------------
-    unsigned int PingPongBuffer::getAllElementsSize( unsigned int bufferIdx /*= 0 */  ) const
+    size_t PingPongBuffer::getAllElementsSize( unsigned int bufferIdx /*= 0 */  ) const
     {
         unsigned int mapIdx = (_stackIdx + bufferIdx) % _bufferStack.size();
         if( _bufferStack.empty() || !_bufferStack[mapIdx].valid() )
@@ -167,7 +172,7 @@ namespace osgCuda
 	}
 
     //------------------------------------------------------------------------------
-    unsigned int PingPongBuffer::getPitch( unsigned int bufferIdx /*= 0 */ ) const
+    size_t PingPongBuffer::getPitch( unsigned int bufferIdx /*= 0 */ ) const
     {
         unsigned int mapIdx = (_stackIdx + bufferIdx) % _bufferStack.size();
         if( _bufferStack.empty() || !_bufferStack[mapIdx].valid() )
@@ -291,7 +296,7 @@ namespace osgCuda
 	} 
 
 	//------------------------------------------------------------------------------
-    unsigned int PingPongBuffer::computePitch() const
+    size_t PingPongBuffer::computePitch() const
     {
         // should not be called
         return 0;
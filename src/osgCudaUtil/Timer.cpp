@@ -1,5 +1,14 @@
+#include <algorithm>
+#include <climits>
+#include <osg/Notify>
 #include <osgCudaUtil/Timer>
 
+// Histogram layout: times below 64us are counted exactly. Above that
+// each power of two is split into 32 linear sub-buckets up to 2^32us.
+#define OSGCUDA_TIMER_EXACT_BUCKETS 64
+#define OSGCUDA_TIMER_SUB_BUCKETS 32
+#define OSGCUDA_TIMER_NUM_BUCKETS (OSGCUDA_TIMER_EXACT_BUCKETS + 26 * OSGCUDA_TIMER_SUB_BUCKETS)
+
 namespace osgCuda
 {   
     bool Timer::_timerEnabled = true;
@@ -34,7 +43,10 @@ namespace osgCuda
         _calls(0),
         _lastTime(0.0f),
         _peakTime(0.0f),
-        _overallTime(0.0f)
+        _overallTime(0.0f),
+        _histogram(OSGCUDA_TIMER_NUM_BUCKETS, 0),
+        _windowSize(100),
+        _windowPos(0)
     {
         // Please note that virtual functions className() and libraryName() are called
         // during observeResource() which will only develop until this class.
@@ -76,6 +88,21 @@ namespace osgCuda
 
         _overallTime += _lastTime;
         _calls++;
+
+        float microSeconds = _lastTime * 1000.0f;
+        if( microSeconds < 0.0f ) microSeconds = 0.0f;
+        if( microSeconds > static_cast<float>(UINT_MAX) ) microSeconds = static_cast<float>(UINT_MAX);
+        _histogram[ bucketIndex( static_cast<unsigned int>(microSeconds) ) ]++;
+
+        if( _window.size() < _windowSize )
+        {
+            _window.push_back( _lastTime );
+        }
+        else
+        {
+            _window[_windowPos] = _lastTime;
+            _windowPos = (_windowPos + 1) % _windowSize;
+        }
     }
 
     //------------------------------------------------------------------------------
@@ -105,6 +132,108 @@ namespace osgCuda
         return _calls;
     }
 
+    //------------------------------------------------------------------------------
+    float Timer::getPercentileTime( float percentile ) const
+    {
+        if( _calls == 0 )
+            return 0.0f;
+
+        if( percentile < 0.0f ) percentile = 0.0f;
+        if( percentile > 1.0f ) percentile = 1.0f;
+
+        // Rank of the requested measurement (1-based)
+        unsigned int rank = static_cast<unsigned int>( percentile * static_cast<float>(_calls) + 0.5f );
+        if( rank == 0 ) rank = 1;
+
+        unsigned int count = 0;
+        for( unsigned int i=0; i<_histogram.size(); ++i )
+        {
+            count += _histogram[i];
+            if( count >= rank )
+                return std::min( bucketTime(i), _peakTime );
+        }
+
+        return _peakTime;
+    }
+
+    //------------------------------------------------------------------------------
+    float Timer::getWindowPercentileTime( float percentile ) const
+    {
+        if( _window.empty() )
+            return 0.0f;
+
+        if( percentile < 0.0f ) percentile = 0.0f;
+        if( percentile > 1.0f ) percentile = 1.0f;
+
+        std::vector<float> sorted( _window );
+        std::vector<float>::iterator nth = sorted.begin() +
+            static_cast<unsigned int>( percentile * static_cast<float>(sorted.size() - 1) + 0.5f );
+        std::nth_element( sorted.begin(), nth, sorted.end() );
+        return *nth;
+    }
+
+    //------------------------------------------------------------------------------
+    float Timer::getWindowAveTime() const
+    {
+        if( _window.empty() )
+            return 0.0f;
+
+        float sum = 0.0f;
+        for( std::vector<float>::const_iterator itr = _window.begin(); itr != _window.end(); ++itr )
+            sum += (*itr);
+
+        return sum / static_cast<float>( _window.size() );
+    }
+
+    //------------------------------------------------------------------------------
+    float Timer::getWindowPeakTime() const
+    {
+        if( _window.empty() )
+            return 0.0f;
+
+        return *std::max_element( _window.begin(), _window.end() );
+    }
+
+    //------------------------------------------------------------------------------
+    void Timer::setWindowSize( unsigned int windowSize )
+    {
+        if( windowSize == 0 )
+        {
+            osg::notify(osg::WARN)
+                << __FUNCTION__ << ": \"" << getName() << "\": window size must be larger than 0."
+                << std::endl;
+            return;
+        }
+
+        _windowSize = windowSize;
+        _window.clear();
+        _windowPos = 0;
+    }
+
+    //------------------------------------------------------------------------------
+    unsigned int Timer::getWindowSize() const
+    {
+        return _windowSize;
+    }
+
+    //------------------------------------------------------------------------------
+    void Timer::reset()
+    {
+        _calls = 0;
+        _lastTime = 0.0f;
+        _peakTime = 0.0f;
+        _overallTime = 0.0f;
+        std::fill( _histogram.begin(), _histogram.end(), 0 );
+        _window.clear();
+        _windowPos = 0;
+    }
+
+    //------------------------------------------------------------------------------
+    void Timer::resetPeak()
+    {
+        _peakTime = 0.0f;
+    }
+
     //------------------------------------------------------------------------------
     void Timer::releaseObjects()
     {
@@ -139,4 +268,38 @@ namespace osgCuda
             cudaEventDestroy(_stop);
         _stop = NULL;
     }
+
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    // STATIC FUNCTIONS /////////////////////////////////////////////////////////////////////////////
+    /////////////////////////////////////////////////////////////////////////////////////////////////
+    //------------------------------------------------------------------------------
+    unsigned int Timer::bucketIndex( unsigned int microSeconds )
+    {
+        if( microSeconds < OSGCUDA_TIMER_EXACT_BUCKETS )
+            return microSeconds;
+
+        // Position of the most significant bit (>= 6)
+        unsigned int msb = 0;
+        for( unsigned int value = microSeconds; value > 1; value >>= 1 )
+            ++msb;
+
+        // Top 6 bits select the sub-bucket within [32,63]
+        unsigned int sub = (microSeconds >> (msb - 5)) - OSGCUDA_TIMER_SUB_BUCKETS;
+        return OSGCUDA_TIMER_EXACT_BUCKETS + (msb - 6) * OSGCUDA_TIMER_SUB_BUCKETS + sub;
+    }
+
+    //------------------------------------------------------------------------------
+    float Timer::bucketTime( unsigned int index )
+    {
+        if( index < OSGCUDA_TIMER_EXACT_BUCKETS )
+            return static_cast<float>(index) / 1000.0f;
+
+        unsigned int msb = (index - OSGCUDA_TIMER_EXACT_BUCKETS) / OSGCUDA_TIMER_SUB_BUCKETS + 6;
+        unsigned int sub = (index - OSGCUDA_TIMER_EXACT_BUCKETS) % OSGCUDA_TIMER_SUB_BUCKETS + OSGCUDA_TIMER_SUB_BUCKETS;
+
+        // Center of the bucket
+        double lower = static_cast<double>(sub) * static_cast<double>(1u << (msb - 5));
+        double width = static_cast<double>(1u << (msb - 5));
+        return static_cast<float>( (lower + 0.5 * width) / 1000.0 );
+    }
 }